@@ -462,7 +462,12 @@ static void cmd_read(struct read_frame* f)
         ;
     dma_reading_from_td = 0;
     bool dma_running = true;
+    bool stop_requested = false;
     
+    /* Listen for the host telling us to stop early. */
+    
+    USBFS_EnableOutEP(FLUXENGINE_CMD_OUT_EP_NUM);
+
     /* Start transferring. */
 
     uint32_t start_time = clock;
@@ -470,10 +475,19 @@ static void cmd_read(struct read_frame* f)
     {
         CyWdtClear();
 
+        if (USBFS_GetEPState(FLUXENGINE_CMD_OUT_EP_NUM) == USBFS_OUT_BUFFER_FULL)
+        {
+            uint8_t stop_buffer[FRAME_SIZE];
+            (void) usb_read(FLUXENGINE_CMD_OUT_EP_NUM, stop_buffer);
+            if (((struct any_frame*) stop_buffer)->f.type == F_FRAME_STOP_READ_CMD)
+                stop_requested = true;
+            USBFS_EnableOutEP(FLUXENGINE_CMD_OUT_EP_NUM);
+        }
+
         /* If the sample session is over, stop reading but continue processing until
          * the DMA chain is empty. */
         
-        if ((clock - start_time) >= f->milliseconds)
+        if (stop_requested || ((clock - start_time) >= f->milliseconds))
         {
             if (dma_running)
             {
@@ -858,6 +872,10 @@ static void handle_command(void)
             cmd_erase((struct erase_frame*) f);
             break;
         
+        case F_FRAME_STOP_READ_CMD:
+            /* The read finished before the stop arrived. */
+            break;
+        
         case F_FRAME_RECALIBRATE_CMD:
             cmd_recalibrate();
             break;
@@ -2,11 +2,13 @@
 #include "lib/decoders/decoders.h"
 #include "arch/aeslanier/aeslanier.h"
 #include "lib/core/crc.h"
+#include "lib/core/crccorrector.h"
 #include "lib/data/fluxmap.h"
 #include "lib/data/fluxmapreader.h"
 #include "lib/data/fluxpattern.h"
 #include "lib/data/sector.h"
 #include "lib/core/bytes.h"
+#include "lib/decoders/decoders.pb.h"
 #include "fmt/format.h"
 #include <string.h>
 
@@ -18,7 +20,14 @@ static const FluxPattern SECTOR_PATTERN(32, AESLANIER_RECORD_SEPARATOR);
 class AesLanierDecoder : public Decoder
 {
 public:
-    AesLanierDecoder(const DecoderProto& config): Decoder(config) {}
+    AesLanierDecoder(const DecoderProto& config):
+        Decoder(config),
+        _crcCorrector(CrcCorrector::CRC_LSB_FIRST,
+            16,
+            MODBUS_POLY_REF,
+            config.crc_correction().adjacent_pairs())
+    {
+    }
 
     nanoseconds_t advanceToNextRecord() override
     {
@@ -55,8 +64,16 @@ public:
         _sector->data = reversed.slice(1, AESLANIER_SECTOR_LENGTH);
         uint16_t wanted = reversed.reader().seek(0x101).read_le16();
         uint16_t got = crc16ref(MODBUS_POLY_REF, _sector->data);
-        _sector->status = (wanted == got) ? Sector::OK : Sector::BAD_CHECKSUM;
+        if (wanted == got)
+            _sector->status = Sector::OK;
+        else if (correctCrcError(_crcCorrector, _sector->data, got, wanted))
+            _sector->status = Sector::CORRECTED;
+        else
+            _sector->status = Sector::BAD_CHECKSUM;
     }
+
+private:
+    CrcCorrector _crcCorrector;
 };
 
 std::unique_ptr<Decoder> createAesLanierDecoder(const DecoderProto& config)
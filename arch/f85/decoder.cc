@@ -7,7 +7,9 @@
 #include "lib/data/sector.h"
 #include "arch/f85/f85.h"
 #include "lib/core/crc.h"
+#include "lib/core/crccorrector.h"
 #include "lib/core/bytes.h"
+#include "lib/decoders/decoders.pb.h"
 #include "fmt/format.h"
 #include <string.h>
 #include <algorithm>
@@ -57,7 +59,14 @@ static Bytes decode(const std::vector<bool>& bits)
 class DurangoF85Decoder : public Decoder
 {
 public:
-    DurangoF85Decoder(const DecoderProto& config): Decoder(config) {}
+    DurangoF85Decoder(const DecoderProto& config):
+        Decoder(config),
+        _crcCorrector(CrcCorrector::CRC_MSB_FIRST,
+            16,
+            CCITT_POLY,
+            config.crc_correction().adjacent_pairs())
+    {
+    }
 
     nanoseconds_t advanceToNextRecord() override
     {
@@ -100,9 +109,17 @@ public:
         _sector->data = br.read(F85_SECTOR_LENGTH);
         uint16_t wantChecksum = br.read_be16();
         uint16_t gotChecksum = crc16(CCITT_POLY, 0xbf84, _sector->data);
-        _sector->status =
-            (wantChecksum == gotChecksum) ? Sector::OK : Sector::BAD_CHECKSUM;
+        if (wantChecksum == gotChecksum)
+            _sector->status = Sector::OK;
+        else if (correctCrcError(
+                     _crcCorrector, _sector->data, gotChecksum, wantChecksum))
+            _sector->status = Sector::CORRECTED;
+        else
+            _sector->status = Sector::BAD_CHECKSUM;
     }
+
+private:
+    CrcCorrector _crcCorrector;
 };
 
 std::unique_ptr<Decoder> createDurangoF85Decoder(const DecoderProto& config)
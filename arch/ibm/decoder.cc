@@ -2,6 +2,7 @@
 #include "lib/decoders/decoders.h"
 #include "arch/ibm/ibm.h"
 #include "lib/core/crc.h"
+#include "lib/core/crccorrector.h"
 #include "lib/data/fluxmap.h"
 #include "lib/data/fluxmapreader.h"
 #include "lib/data/fluxpattern.h"
@@ -95,7 +96,11 @@ class IbmDecoder : public Decoder
 public:
     IbmDecoder(const DecoderProto& config):
         Decoder(config),
-        _config(config.ibm())
+        _config(config.ibm()),
+        _crcCorrector(CrcCorrector::CRC_MSB_FIRST,
+            16,
+            CCITT_POLY,
+            config.crc_correction().adjacent_pairs())
     {
     }
 
@@ -201,11 +206,21 @@ public:
         auto bits = readRawBits((_currentSectorSize + 2) * 16);
         bw += decodeFmMfm(bits).slice(0, _currentSectorSize + 2);
 
+        unsigned headerSize = br.pos;
         _sector->data = br.read(_currentSectorSize);
-        uint16_t gotCrc = crc16(CCITT_POLY, bytes.slice(0, br.pos));
+        Bytes block = bytes.slice(0, br.pos);
+        uint16_t gotCrc = crc16(CCITT_POLY, block);
         uint16_t wantCrc = br.read_be16();
-        _sector->status =
-            (wantCrc == gotCrc) ? Sector::OK : Sector::BAD_CHECKSUM;
+        if (wantCrc == gotCrc)
+            _sector->status = Sector::OK;
+        else if (correctCrcError(
+                     _crcCorrector, block, gotCrc, wantCrc, headerSize))
+        {
+            _sector->data = block.slice(headerSize);
+            _sector->status = Sector::CORRECTED;
+        }
+        else
+            _sector->status = Sector::BAD_CHECKSUM;
 
         if (_currentSectorSize != _ltl->sectorSize)
             std::cerr << fmt::format(
@@ -239,6 +254,7 @@ private:
     const IbmDecoderProto& _config;
     unsigned _currentSectorSize;
     unsigned _currentHeaderLength;
+    CrcCorrector _crcCorrector;
 };
 
 std::unique_ptr<Decoder> createIbmDecoder(const DecoderProto& config)
@@ -2,8 +2,10 @@ from build.c import cxxlibrary
 
 cxxlibrary(
     name="algorithms",
-    srcs=["./readerwriter.cc"],
+    srcs=["./calibration.cc", "./identify.cc", "./readerwriter.cc"],
     hdrs={
+        "lib/algorithms/calibration.h": "./calibration.h",
+        "lib/algorithms/identify.h": "./identify.h",
         "lib/algorithms/readerwriter.h": "./readerwriter.h",
     },
     deps=[
@@ -17,5 +19,6 @@ cxxlibrary(
         "lib/fluxsink",
         "lib/imagereader",
         "lib/imagewriter",
+        "arch",
     ],
 )
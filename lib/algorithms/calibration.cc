@@ -0,0 +1,134 @@
+#include "lib/core/globals.h"
+#include "lib/config/drive.pb.h"
+#include "lib/algorithms/calibration.h"
+#include <google/protobuf/text_format.h>
+#include <fstream>
+#include <filesystem>
+#include <math.h>
+#include <mutex>
+#include <random>
+
+/* Several devices can be in use at once, each on its own thread, so updates
+ * from within this process are serialised. */
+
+static std::mutex storeMutex;
+
+static CalibrationStoreProto loadStore(const std::string& filename)
+{
+    CalibrationStoreProto store;
+    std::ifstream f(filename);
+    if (!f.is_open())
+        return store;
+
+    std::stringstream ss;
+    ss << f.rdbuf();
+
+    /* A damaged cache is the same as an empty one; it'll get rewritten. */
+
+    if (!google::protobuf::TextFormat::ParseFromString(ss.str(), &store))
+        store.Clear();
+    return store;
+}
+
+static bool matches(const CalibrationEntryProto& entry,
+    const std::string& serial,
+    const DriveProto& drive)
+{
+    return (entry.serial() == serial) && (entry.drive() == drive.drive()) &&
+           (entry.index_mode() == drive.index_mode()) &&
+           (entry.hard_sector_count() == drive.hard_sector_count());
+}
+
+std::optional<DriveCalibration> findDriveCalibration(
+    const CalibrationCacheProto& config,
+    const std::string& serial,
+    const DriveProto& drive,
+    time_t now)
+{
+    auto store = loadStore(config.filename());
+    for (const auto& entry : store.entry())
+    {
+        if (!matches(entry, serial, drive))
+            continue;
+
+        double age = now - entry.measured_at();
+        if ((age < 0) || (age > (config.max_age_hours() * 3600.0)))
+            return {};
+        if (entry.rotational_period_ms() <= 0)
+            return {};
+
+        DriveCalibration calibration;
+        calibration.rotationalPeriod = entry.rotational_period_ms() * 1e6;
+        calibration.hardSectorThreshold = entry.hard_sector_threshold_ns();
+        return calibration;
+    }
+    return {};
+}
+
+void saveDriveCalibration(const CalibrationCacheProto& config,
+    const std::string& serial,
+    const DriveProto& drive,
+    const DriveCalibration& calibration,
+    time_t now)
+{
+    std::lock_guard<std::mutex> lock(storeMutex);
+    auto store = loadStore(config.filename());
+
+    CalibrationEntryProto* entry = nullptr;
+    for (auto& e : *store.mutable_entry())
+        if (matches(e, serial, drive))
+            entry = &e;
+    if (!entry)
+    {
+        entry = store.add_entry();
+        entry->set_serial(serial);
+        entry->set_drive(drive.drive());
+        entry->set_index_mode(drive.index_mode());
+        entry->set_hard_sector_count(drive.hard_sector_count());
+    }
+    entry->set_rotational_period_ms(calibration.rotationalPeriod / 1e6);
+    entry->set_hard_sector_threshold_ns(calibration.hardSectorThreshold);
+    entry->set_measured_at(now);
+
+    std::string s;
+    google::protobuf::TextFormat::PrintToString(store, &s);
+
+    /* Write to a temporary file and rename it over the top, so that two
+     * processes sharing a cache can't leave it half-written. Each writer gets
+     * its own temporary file (in the same directory, so the rename stays
+     * atomic). Failing to write it isn't fatal; the drive just gets measured
+     * again next time. */
+
+    std::random_device random;
+    std::string tempname = fmt::format(
+        "{}.{:08x}{:08x}.new", config.filename(), random(), random());
+    {
+        std::ofstream f(tempname, std::ios::out | std::ios::trunc);
+        if (!f.is_open())
+        {
+            warning("cannot write calibration cache '{}'", tempname);
+            return;
+        }
+        f << s;
+    }
+    std::error_code ec;
+    std::filesystem::rename(tempname, config.filename(), ec);
+    if (ec)
+    {
+        warning("cannot write calibration cache '{}': {}",
+            config.filename(),
+            ec.message());
+        std::filesystem::remove(tempname, ec);
+    }
+}
+
+bool isCalibrationStillValid(const CalibrationCacheProto& config,
+    const DriveCalibration& calibration,
+    nanoseconds_t measuredPeriod)
+{
+    if (measuredPeriod <= 0)
+        return false;
+    double drift = fabs(measuredPeriod - calibration.rotationalPeriod) /
+                   calibration.rotationalPeriod;
+    return drift <= config.max_drift();
+}
@@ -0,0 +1,44 @@
+#ifndef CALIBRATION_H
+#define CALIBRATION_H
+
+#include <time.h>
+
+class CalibrationCacheProto;
+class DriveProto;
+
+/* What's remembered about a drive between runs. */
+
+struct DriveCalibration
+{
+    nanoseconds_t rotationalPeriod = 0;
+    nanoseconds_t hardSectorThreshold = 0;
+};
+
+/* Looks up the calibration for the drive described by drive (the drive number,
+ * index mode and hard sector count all have to match) on the device with the
+ * given serial number. Entries older than the cache's maximum age are
+ * ignored. */
+
+extern std::optional<DriveCalibration> findDriveCalibration(
+    const CalibrationCacheProto& config,
+    const std::string& serial,
+    const DriveProto& drive,
+    time_t now = time(nullptr));
+
+/* Remembers a newly measured calibration, replacing any existing one for the
+ * same drive. */
+
+extern void saveDriveCalibration(const CalibrationCacheProto& config,
+    const std::string& serial,
+    const DriveProto& drive,
+    const DriveCalibration& calibration,
+    time_t now = time(nullptr));
+
+/* Whether a quick measurement of the rotational period is close enough to the
+ * remembered one for the latter to still be trusted. */
+
+extern bool isCalibrationStillValid(const CalibrationCacheProto& config,
+    const DriveCalibration& calibration,
+    nanoseconds_t measuredPeriod);
+
+#endif
@@ -0,0 +1,238 @@
+#include "lib/core/globals.h"
+#include "lib/core/utils.h"
+#include "lib/config/config.h"
+#include "lib/config/proto.h"
+#include "lib/data/fluxmap.h"
+#include "lib/data/disk.h"
+#include "lib/data/layout.h"
+#include "lib/data/sector.h"
+#include "lib/data/sectorcollector.h"
+#include "lib/decoders/decoders.h"
+#include "lib/decoders/decoders.pb.h"
+#include "lib/fluxsource/fluxsource.h"
+#include "lib/algorithms/identify.h"
+#include "lib/algorithms/readerwriter.h"
+#include "arch/arch.h"
+#include <math.h>
+
+namespace
+{
+    struct Candidate
+    {
+        std::string profile;
+        ConfigProto config;
+        std::shared_ptr<const DiskLayout> layout;
+    };
+}
+
+void IdentifiedFormat::add(const Track& track)
+{
+    const auto& ltl = *track.ltl;
+    std::set<unsigned> wanted(
+        ltl.diskSectorOrder.begin(), ltl.diskSectorOrder.end());
+    expected += wanted.size();
+
+    SectorCollector collector;
+    collector.add(track.allSectors);
+    for (const auto& sector : collector.sectors())
+    {
+        bool fits = (sector->logicalCylinder == ltl.logicalCylinder) &&
+                    (sector->logicalHead == ltl.logicalHead) &&
+                    wanted.contains(sector->logicalSector) &&
+                    (!ltl.sectorSize ||
+                        (sector->data.size() == ltl.sectorSize));
+
+        if (sector->status == Sector::OK)
+        {
+            if (fits)
+                good++;
+            else
+                spurious++;
+
+            _clocks++;
+            _clockSum += sector->clock;
+            _clockSumSquares += sector->clock * sector->clock;
+        }
+        else if (fits)
+            bad++;
+    }
+}
+
+void IdentifiedFormat::finish()
+{
+    clockSpread = 0.0;
+    if (_clocks > 1)
+    {
+        double mean = _clockSum / _clocks;
+        double variance = _clockSumSquares / _clocks - mean * mean;
+        if (mean > 0.0)
+            clockSpread = sqrt(std::max(variance, 0.0)) / mean;
+    }
+
+    /* Mostly the fraction of expected sectors which were found, but a profile
+     * which also finds sectors it doesn't expect has probably got the
+     * geometry wrong, and one whose sectors are at different clock rates is
+     * probably picking up noise. */
+
+    score = 0.0;
+    if (expected)
+        score = (double)good / expected;
+    if (good + spurious)
+        score -= 0.5 * spurious / (good + spurious);
+    score -= std::min(clockSpread, 1.0);
+}
+
+static ConfigProto applyOptions(const ConfigProto& base,
+    const OptionGroupProto* variedGroup,
+    const OptionProto* variedOption,
+    const ConfigProto& user)
+{
+    ConfigProto config = base;
+    for (const auto& group : base.option_group())
+    {
+        if (&group == variedGroup)
+            config.MergeFrom(variedOption->config());
+        else
+            for (const auto& option : group.option())
+                if (option.set_by_default())
+                    config.MergeFrom(option.config());
+    }
+    config.MergeFrom(user);
+    return config;
+}
+
+static std::vector<Candidate> makeCandidates(
+    const std::map<std::string, const ConfigProto*>& formats,
+    const ConfigProto& user)
+{
+    std::vector<Candidate> candidates;
+    std::set<std::string> seen;
+    auto add = [&](const std::string& profile, ConfigProto config)
+    {
+        if (!config.has_decoder())
+            return;
+
+        std::string key = config.decoder().SerializeAsString() +
+                          config.layout().SerializeAsString();
+        if (!seen.insert(key).second)
+            return;
+
+        try
+        {
+            auto layout = std::make_shared<DiskLayout>(config);
+            candidates.push_back({profile, std::move(config), layout});
+        }
+        catch (const ErrorException&)
+        {
+            /* The layout doesn't fit the drive. */
+        }
+    };
+
+    for (const auto& [name, format] : formats)
+    {
+        if (format->is_extension())
+            continue;
+
+        /* Try the default, and then each of the geometry variations. */
+
+        add(name, applyOptions(*format, nullptr, nullptr, user));
+        for (const auto& group : format->option_group())
+        {
+            if (group.comment() != "$formats")
+                continue;
+
+            for (const auto& option : group.option())
+            {
+                std::string profile =
+                    group.name().empty()
+                        ? fmt::format("{} --{}", name, option.name())
+                        : fmt::format(
+                              "{} --{}={}", name, group.name(), option.name());
+                add(profile, applyOptions(*format, &group, &option, user));
+            }
+        }
+    }
+
+    return candidates;
+}
+
+std::vector<IdentifySample> readIdentifySamples(
+    FluxSource& fluxSource, const std::vector<CylinderHead>& locations)
+{
+    if (fluxSource.isHardware())
+        measureDiskRotation();
+
+    std::vector<IdentifySample> samples;
+    for (const auto& location : locations)
+    {
+        auto it = fluxSource.readFlux(location);
+        if (!it->hasNext())
+            continue;
+        samples.push_back({location, it->next()});
+    }
+    return samples;
+}
+
+std::vector<IdentifiedFormat> identifyFormat(
+    const std::vector<IdentifySample>& samples,
+    const std::map<std::string, const ConfigProto*>& formats,
+    const ConfigProto& user,
+    unsigned threads)
+{
+    auto candidates = makeCandidates(formats, user);
+    unsigned jobs = candidates.size() * samples.size();
+
+    /* Each job decodes one sample with one candidate. Decoders are cheap to
+     * make and not thread safe, so every job gets its own. */
+
+    std::vector<std::shared_ptr<const Track>> decoded(jobs);
+    parallelFor(jobs,
+        threads,
+        [&](unsigned job)
+        {
+            const auto& candidate = candidates[job / samples.size()];
+            const auto& sample = samples[job % samples.size()];
+            const auto& layouts = candidate.layout->layoutByPhysicalLocation;
+            auto it = layouts.find(sample.location);
+            if (it == layouts.end())
+                return;
+
+            try
+            {
+                auto decoder = Arch::createDecoder(candidate.config.decoder());
+                decoded[job] =
+                    decoder->decodeToSectors(sample.fluxmap, it->second);
+            }
+            catch (const ErrorException&)
+            {
+                /* Decoders are allowed to give up on flux they can't make
+                 * sense of. */
+            }
+        });
+
+    std::vector<IdentifiedFormat> results;
+    for (unsigned c = 0; c < candidates.size(); c++)
+    {
+        IdentifiedFormat result;
+        result.profile = candidates[c].profile;
+        for (unsigned s = 0; s < samples.size(); s++)
+        {
+            const auto& track = decoded[c * samples.size() + s];
+            if (track)
+                result.add(*track);
+        }
+        result.finish();
+        if (result.expected)
+            results.push_back(result);
+    }
+
+    std::stable_sort(results.begin(),
+        results.end(),
+        [](const auto& lhs, const auto& rhs)
+        {
+            if (lhs.score != rhs.score)
+                return lhs.score > rhs.score;
+            return lhs.good > rhs.good;
+        });
+    return results;
+}
@@ -0,0 +1,73 @@
+#ifndef IDENTIFY_H
+#define IDENTIFY_H
+
+#include "lib/data/locations.h"
+
+class ConfigProto;
+class FluxSource;
+class Fluxmap;
+struct Track;
+
+/* How well one profile explains some sample tracks. */
+
+struct IdentifiedFormat
+{
+    /* Profile name plus options, as it would be given on the command line. */
+    std::string profile;
+
+    /* Number of sectors the profile's layout expects on the sample tracks. */
+    unsigned expected = 0;
+
+    /* Number of expected sectors which were read correctly. */
+    unsigned good = 0;
+
+    /* Number of expected sectors which were found but were bad. */
+    unsigned bad = 0;
+
+    /* Number of good sectors which the layout doesn't expect (wrong
+     * cylinder, head, sector ID or size). */
+    unsigned spurious = 0;
+
+    /* Relative standard deviation of the clock of good sectors. */
+    double clockSpread = 0.0;
+
+    /* Overall ranking; higher is better, 1.0 is perfect. */
+    double score = 0.0;
+
+    /* Adds the sectors decoded from one track. */
+    void add(const Track& track);
+
+    /* Calculates clockSpread and score. */
+    void finish();
+
+private:
+    unsigned _clocks = 0;
+    double _clockSum = 0.0;
+    double _clockSumSquares = 0.0;
+};
+
+struct IdentifySample
+{
+    CylinderHead location;
+    std::shared_ptr<const Fluxmap> fluxmap;
+};
+
+/* Reads one sample from each location. Real drives are measured first, as
+ * reads are timed in revolutions. Locations with no flux are skipped. */
+
+extern std::vector<IdentifySample> readIdentifySamples(
+    FluxSource& fluxSource, const std::vector<CylinderHead>& locations);
+
+/* Decodes the samples with every non-extension profile in formats (and every
+ * geometry variation of each), using threads decoders at once (0 means one
+ * per CPU), and returns the results best first. user is merged on top of each
+ * profile, as it would be by the command line. Profiles which can't read, or
+ * which are identical to one already tried, are skipped. */
+
+extern std::vector<IdentifiedFormat> identifyFormat(
+    const std::vector<IdentifySample>& samples,
+    const std::map<std::string, const ConfigProto*>& formats,
+    const ConfigProto& user,
+    unsigned threads = 0);
+
+#endif
@@ -3,6 +3,7 @@
 #include "lib/config/flags.h"
 #include "lib/data/fluxmap.h"
 #include "lib/algorithms/readerwriter.h"
+#include "lib/algorithms/calibration.h"
 #include "protocol.h"
 #include "lib/usb/usb.h"
 #include "lib/encoders/encoders.h"
@@ -12,13 +13,20 @@
 #include "lib/imagereader/imagereader.h"
 #include "lib/imagewriter/imagewriter.h"
 #include "lib/data/sector.h"
+#include "lib/data/sectorcollector.h"
 #include "lib/data/image.h"
 #include "lib/core/logger.h"
 #include "lib/data/layout.h"
 #include "lib/core/utils.h"
+#include "lib/core/crc.h"
+#include "lib/core/trace.h"
 #include "lib/config/config.pb.h"
 #include "lib/config/proto.h"
+#include "lib/decoders/decoders.pb.h"
+#include "arch/arch.h"
 #include <optional>
+#include <thread>
+#include <mutex>
 
 enum ReadResult
 {
@@ -66,6 +74,29 @@ void renderLogMessage(
 {
 }
 
+/* The result of verifying a freshly written track. */
+void renderLogMessage(
+    LogRenderer& r, std::shared_ptr<const VerifyTrackLogMessage> m)
+{
+    r.comma().add(fmt::format("verify: {} good, {} mismatched, {} missing",
+        m->matched,
+        m->mismatched,
+        m->missing));
+    if (m->spurious)
+        r.comma().add(fmt::format("{} spurious", m->spurious));
+}
+
+/* Some sectors were recovered by re-decoding with different parameters. */
+void renderLogMessage(
+    LogRenderer& r, std::shared_ptr<const ParameterSweepLogMessage> m)
+{
+    r.newline().add(
+        fmt::format("parameter sweep recovered {} sectors:", m->recovered));
+    for (const auto& [parameters, count] : m->winners)
+        r.newline().add(fmt::format("    {} with {}", count, parameters));
+    r.newline();
+}
+
 /* Indicates that we're starting a read operation. */
 void renderLogMessage(
     LogRenderer& r, std::shared_ptr<const BeginReadOperationLogMessage> m)
@@ -159,7 +190,8 @@ void renderLogMessage(
 
 /* In order to allow rereads in file-based flux sources, we need to persist the
  * FluxSourceIterator (as that's where the state for which read to return is
- * held). This class handles that. */
+ * held). This class handles that. As every read goes through here, it also
+ * keeps track of where the head is and how far it's moved. */
 
 class FluxSourceIteratorHolder
 {
@@ -168,16 +200,48 @@ public:
 
     FluxSourceIterator& getIterator(unsigned physicalCylinder, unsigned head)
     {
+        moveHead(physicalCylinder);
         auto& it = _cache[std::make_pair(physicalCylinder, head)];
         if (!it)
             it = _fluxSource.readFlux(physicalCylinder, head);
         return *it;
     }
 
+    void moveHead(unsigned physicalCylinder)
+    {
+        if (physicalCylinder != _cylinder)
+        {
+            _seeks++;
+            _travel += (physicalCylinder > _cylinder)
+                           ? (physicalCylinder - _cylinder)
+                           : (_cylinder - physicalCylinder);
+            _cylinder = physicalCylinder;
+            Trace::counter("cylinder", physicalCylinder);
+        }
+    }
+
+    unsigned cylinder() const
+    {
+        return _cylinder;
+    }
+
+    unsigned seeks() const
+    {
+        return _seeks;
+    }
+
+    unsigned travel() const
+    {
+        return _travel;
+    }
+
 private:
     FluxSource& _fluxSource;
     std::map<std::pair<unsigned, unsigned>, std::unique_ptr<FluxSourceIterator>>
         _cache;
+    unsigned _cylinder = 0;
+    unsigned _seeks = 0;
+    unsigned _travel = 0;
 };
 
 static nanoseconds_t getRotationalPeriodFromConfig()
@@ -185,29 +249,57 @@ static nanoseconds_t getRotationalPeriodFromConfig()
     return globalConfig()->drive().rotational_period_ms() * 1e6;
 }
 
-static nanoseconds_t measureDiskRotation()
+nanoseconds_t measureDiskRotation()
 {
     log(BeginSpeedOperationLogMessage());
 
     nanoseconds_t oneRevolution = getRotationalPeriodFromConfig();
+    bool measured = false;
     if (oneRevolution == 0)
     {
-        usbSetDrive(globalConfig()->drive().drive(),
-            globalConfig()->drive().high_density(),
-            globalConfig()->drive().index_mode());
+        const auto& drive = globalConfig()->drive();
+        usbSetDrive(drive.drive(), drive.high_density(), drive.index_mode());
+
+        /* If the drive's been measured recently, a quick check that it's
+         * still spinning at the same speed will do. */
+
+        const auto& cacheConfig = drive.calibration_cache();
+        std::optional<DriveCalibration> calibration;
+        if (cacheConfig.has_filename())
+            calibration =
+                findDriveCalibration(cacheConfig, usbGetSerial(), drive);
+        if (calibration && cacheConfig.check() &&
+            !isCalibrationStillValid(cacheConfig,
+                *calibration,
+                usbGetRotationalPeriod(drive.hard_sector_count())))
+        {
+            log("drive speed has changed since it was last measured");
+            calibration.reset();
+        }
 
-        log(BeginOperationLogMessage{"Measuring drive rotational speed"});
-        int retries = 5;
-        do
+        if (calibration)
+        {
+            oneRevolution = calibration->rotationalPeriod;
+            if (!drive.hard_sector_threshold_ns())
+                globalConfig().setTransient("drive.hard_sector_threshold_ns",
+                    std::to_string(calibration->hardSectorThreshold));
+        }
+        else
         {
-            oneRevolution = usbGetRotationalPeriod(
-                globalConfig()->drive().hard_sector_count());
+            log(BeginOperationLogMessage{"Measuring drive rotational speed"});
+            int retries = 5;
+            do
+            {
+                oneRevolution =
+                    usbGetRotationalPeriod(drive.hard_sector_count());
 
-            retries--;
-        } while ((oneRevolution == 0) && (retries > 0));
+                retries--;
+            } while ((oneRevolution == 0) && (retries > 0));
+            log(EndOperationLogMessage{});
+            measured = true;
+        }
         globalConfig().setTransient(
             "drive.rotational_period_ms", std::to_string(oneRevolution / 1e6));
-        log(EndOperationLogMessage{});
     }
 
     if (!globalConfig()->drive().hard_sector_threshold_ns())
@@ -223,116 +315,63 @@ static nanoseconds_t measureDiskRotation()
     if (oneRevolution == 0)
         error("Failed\nIs a disk in the drive?");
 
+    const auto& cacheConfig = globalConfig()->drive().calibration_cache();
+    if (measured && cacheConfig.has_filename())
+        saveDriveCalibration(cacheConfig,
+            usbGetSerial(),
+            globalConfig()->drive(),
+            DriveCalibration{oneRevolution,
+                globalConfig()->drive().hard_sector_threshold_ns()});
+
     log(EndSpeedOperationLogMessage{oneRevolution});
     return oneRevolution;
 }
 
-/* Given a set of sectors, deduplicates them sensibly (e.g. if there is a good
- * and bad version of the same sector, the bad version is dropped). */
-
-static std::vector<std::shared_ptr<const Sector>> collectSectors(
-    std::vector<std::shared_ptr<const Sector>>& trackSectors,
-    bool collapse_conflicts = true)
-{
-    typedef std::tuple<unsigned, unsigned, unsigned> key_t;
-    std::multimap<key_t, std::shared_ptr<const Sector>> sectors;
-
-    for (const auto& sector : trackSectors)
-    {
-        key_t sectorid = {sector->logicalCylinder,
-            sector->logicalHead,
-            sector->logicalSector};
-        sectors.insert({sectorid, sector});
-    }
-
-    std::set<std::shared_ptr<const Sector>> sector_set;
-    auto it = sectors.begin();
-    while (it != sectors.end())
-    {
-        auto ub = sectors.upper_bound(it->first);
-        auto new_sector = std::accumulate(it,
-            ub,
-            it->second,
-            [&](auto left, auto& rightit) -> std::shared_ptr<const Sector>
-            {
-                auto& right = rightit.second;
-                if ((left->status == Sector::OK) &&
-                    (right->status == Sector::OK) &&
-                    (left->data != right->data))
-                {
-                    if (!collapse_conflicts)
-                    {
-                        auto s = std::make_shared<Sector>(*right);
-                        s->status = Sector::CONFLICT;
-                        sector_set.insert(s);
-                    }
-                    auto s = std::make_shared<Sector>(*left);
-                    s->status = Sector::CONFLICT;
-                    return s;
-                }
-                if (left->status == Sector::CONFLICT)
-                    return left;
-                if (right->status == Sector::CONFLICT)
-                    return right;
-                if (left->status == Sector::OK)
-                    return left;
-                if (right->status == Sector::OK)
-                    return right;
-                return left;
-            });
-        sector_set.insert(new_sector);
-        it = ub;
-    }
-
-    return std::vector(sector_set.begin(), sector_set.end());
-}
-
 struct CombinationResult
 {
     BadSectorsState result;
     std::vector<std::shared_ptr<const Sector>> sectors;
 };
 
+/* Works out the state of a track given the sectors read so far, adding
+ * placeholders for any which should be there but haven't been seen. */
+
 static CombinationResult combineRecordAndSectors(
-    std::vector<std::shared_ptr<const Track>>& tracks,
-    Decoder& decoder,
+    const SectorCollector& collector,
     const std::shared_ptr<const LogicalTrackLayout>& ltl)
 {
+    TraceSpan span("combine");
     CombinationResult cr = {HAS_NO_BAD_SECTORS};
-    std::vector<std::shared_ptr<const Sector>> track_sectors;
-
-    /* Add the sectors which were there. */
-
-    for (auto& track : tracks)
-        for (auto& sector : track->allSectors)
-            track_sectors.push_back(sector);
-
-    /* Add the sectors which should be there. */
+    cr.sectors = collector.sectors();
 
     for (unsigned sectorId : ltl->diskSectorOrder)
     {
-        auto sector = std::make_shared<Sector>(
-            LogicalLocation{ltl->logicalCylinder, ltl->logicalHead, sectorId});
+        LogicalLocation location = {
+            ltl->logicalCylinder, ltl->logicalHead, sectorId};
+        if (collector.contains(location))
+            continue;
 
+        auto sector = std::make_shared<Sector>(location);
         sector->status = Sector::MISSING;
         sector->physicalLocation = std::make_optional(
             CylinderHead(ltl->physicalCylinder, ltl->physicalHead));
-        track_sectors.push_back(sector);
+        cr.sectors.push_back(sector);
     }
 
-    /* Deduplicate. */
-
-    cr.sectors = collectSectors(track_sectors);
+    bool acceptCorrected =
+        globalConfig()->decoder().crc_correction().accept();
     if (cr.sectors.empty())
         cr.result = HAS_BAD_SECTORS;
     for (const auto& sector : cr.sectors)
-        if (sector->status != Sector::OK)
+        if (!Sector::isGoodStatus(sector->status, acceptCorrected))
             cr.result = HAS_BAD_SECTORS;
 
     return cr;
 }
 
-static void adjustTrackOnError(FluxSource& fluxSource, int baseTrack)
+static void adjustTrackOnError(FluxSource& fluxSource,
+    FluxSourceIteratorHolder& fluxSourceIteratorHolder,
+    int baseTrack)
 {
     switch (globalConfig()->drive().error_behaviour())
     {
@@ -341,14 +380,16 @@ static void adjustTrackOnError(FluxSource& fluxSource, int baseTrack)
 
         case DriveProto::RECALIBRATE:
             fluxSource.recalibrate();
+            fluxSourceIteratorHolder.moveHead(0);
             break;
 
         case DriveProto::JIGGLE:
-            if (baseTrack > 0)
-                fluxSource.seek(baseTrack - 1);
-            else
-                fluxSource.seek(baseTrack + 1);
+        {
+            int track = (baseTrack > 0) ? (baseTrack - 1) : (baseTrack + 1);
+            fluxSource.seek(track);
+            fluxSourceIteratorHolder.moveHead(track);
             break;
+        }
     }
 }
 
@@ -369,8 +410,12 @@ static ReadGroupResult readGroup(const DiskLayout& diskLayout,
     /* Before doing the read, look to see if we already have the necessary
      * sectors. */
 
+    SectorCollector collector;
+    for (const auto& track : tracks)
+        collector.add(track->allSectors);
+
     {
-        auto [result, sectors] = combineRecordAndSectors(tracks, decoder, ltl);
+        auto [result, sectors] = combineRecordAndSectors(collector, ltl);
         rgr.combinedSectors = sectors;
         if (result == HAS_NO_BAD_SECTORS)
         {
@@ -391,6 +436,8 @@ static ReadGroupResult readGroup(const DiskLayout& diskLayout,
 
         /* Do the physical read. */
 
+        TraceSpan span("read",
+            {{"cylinder", physicalCylinder}, {"head", physicalHead}});
         log(BeginReadOperationLogMessage{physicalCylinder, physicalHead});
 
         auto& fluxSourceIterator = fluxSourceIteratorHolder.getIterator(
@@ -398,19 +445,42 @@ static ReadGroupResult readGroup(const DiskLayout& diskLayout,
         if (!fluxSourceIterator.hasNext())
             continue;
 
-        auto fluxmap = fluxSourceIterator.next();
+        std::unique_ptr<const Fluxmap> fluxmap;
+        const auto& drive = globalConfig()->drive();
+        if (drive.max_revolutions() > 0)
+        {
+            /* Check the flux once a revolution as it arrives, so that the
+             * device can stop as soon as the track's complete. */
+
+            StreamingDecoder streamingDecoder(
+                decoder, ptl, drive.rotational_period_ms() * 1e6);
+            fluxmap = fluxSourceIterator.nextUntilComplete(
+                [&](const Fluxmap& soFar)
+                {
+                    return streamingDecoder.feed(soFar);
+                });
+        }
+        else
+            fluxmap = fluxSourceIterator.next();
         log(EndReadOperationLogMessage());
         log("{0} ms in {1} bytes",
             (int)(fluxmap->duration() / 1e6),
             fluxmap->bytes());
 
-        auto flux = decoder.decodeToSectors(std::move(fluxmap), ptl);
-        flux->normalisedSectors = collectSectors(flux->allSectors);
+        auto flux = decoder.decodeToSectors(std::move(fluxmap),
+            ptl,
+            globalConfig()->decoder().stop_when_complete());
+        {
+            SectorCollector normalised;
+            normalised.add(flux->allSectors);
+            flux->normalisedSectors = normalised.sectors();
+        }
         tracks.push_back(flux);
+        collector.add(flux->allSectors);
 
         /* Decode what we've got so far. */
 
-        auto [result, sectors] = combineRecordAndSectors(tracks, decoder, ltl);
+        auto [result, sectors] = combineRecordAndSectors(collector, ltl);
         rgr.combinedSectors = sectors;
         if (result == HAS_NO_BAD_SECTORS)
         {
@@ -456,6 +526,11 @@ void writeTracks(const DiskLayout& diskLayout,
 
             const auto& ltl = diskLayout.layoutByLogicalLocation.at(ch);
             int retriesRemaining = globalConfig()->decoder().retries();
+
+            /* The track is only encoded once; retries just rewrite the same
+             * flux. */
+
+            auto fluxmap = producer(ltl);
             for (;;)
             {
                 for (int offset = 0; offset < ltl->groupSize;
@@ -464,15 +539,15 @@ void writeTracks(const DiskLayout& diskLayout,
                     unsigned physicalCylinder = ltl->physicalCylinder + offset;
                     unsigned physicalHead = ltl->physicalHead;
 
+                    TraceSpan span("sink write",
+                        {{"cylinder", physicalCylinder},
+                            {"head", physicalHead}});
                     log(BeginWriteOperationLogMessage{
                         physicalCylinder, ltl->physicalHead});
 
-                    if (offset == globalConfig()->drive().group_offset())
+                    if (fluxmap &&
+                        (offset == globalConfig()->drive().group_offset()))
                     {
-                        auto fluxmap = producer(ltl);
-                        if (!fluxmap)
-                            goto erase;
-
                         fluxSink->addFlux(
                             physicalCylinder, physicalHead, *fluxmap);
                         log("writing {0} ms in {1} bytes",
@@ -481,7 +556,6 @@ void writeTracks(const DiskLayout& diskLayout,
                     }
                     else
                     {
-                    erase:
                         /* Erase this track rather than writing. */
 
                         Fluxmap blank;
@@ -519,6 +593,7 @@ void writeTracks(const DiskLayout& diskLayout,
         fluxSinkFactory,
         [&](const std::shared_ptr<const LogicalTrackLayout>& ltl)
         {
+            TraceSpan span("encode");
             auto sectors = encoder.collectSectors(*ltl, image);
             return encoder.encode(*ltl, sectors, image);
         },
@@ -529,6 +604,65 @@ void writeTracks(const DiskLayout& diskLayout,
         chs);
 }
 
+/* What a sector should look like when it's read back after writing. Only the
+ * digest of the payload is kept, so verification doesn't need to hang on to
+ * (or rebuild) an image of the track. */
+
+struct SectorDigest
+{
+    unsigned logicalSector;
+    unsigned size;
+    uint64_t digest;
+};
+
+static std::vector<SectorDigest> calculateSectorDigests(
+    const std::vector<std::shared_ptr<const Sector>>& sectors)
+{
+    std::vector<SectorDigest> digests;
+    digests.reserve(sectors.size());
+    for (const auto& sector : sectors)
+        digests.push_back(SectorDigest{sector->logicalSector,
+            sector->data.size(),
+            fnv1a64(sector->data)});
+
+    std::ranges::sort(digests, {}, &SectorDigest::logicalSector);
+    return digests;
+}
+
+static VerifyTrackLogMessage verifySectors(const LogicalTrackLayout& ltl,
+    const std::vector<SectorDigest>& wanted,
+    const std::vector<std::shared_ptr<const Sector>>& sectors)
+{
+    VerifyTrackLogMessage result = {};
+    std::vector<bool> seen(wanted.size());
+    for (const auto& sector : sectors)
+    {
+        auto it = std::ranges::lower_bound(
+            wanted, sector->logicalSector, {}, &SectorDigest::logicalSector);
+        if ((sector->logicalCylinder != ltl.logicalCylinder) ||
+            (sector->logicalHead != ltl.logicalHead) ||
+            (it == wanted.end()) ||
+            (it->logicalSector != sector->logicalSector))
+        {
+            result.spurious++;
+            continue;
+        }
+
+        unsigned index = it - wanted.begin();
+        if (seen[index] || (sector->status != Sector::OK))
+            continue;
+        seen[index] = true;
+
+        if (fnv1a64(sector->data.slice(0, it->size)) == it->digest)
+            result.matched++;
+        else
+            result.mismatched++;
+    }
+
+    result.missing = wanted.size() - result.matched - result.mismatched;
+    return result;
+}
+
 void writeTracksAndVerify(const DiskLayout& diskLayout,
     FluxSinkFactory& fluxSinkFactory,
     Encoder& encoder,
@@ -537,57 +671,55 @@ void writeTracksAndVerify(const DiskLayout& diskLayout,
     const Image& image,
     const std::vector<CylinderHead>& chs)
 {
+    /* Digests for the track currently being written; these are calculated by
+     * the producer and consumed by the verifier. */
+
+    std::vector<SectorDigest> wanted;
+
     writeTracks(
         diskLayout,
         fluxSinkFactory,
         [&](const std::shared_ptr<const LogicalTrackLayout>& ltl)
         {
+            TraceSpan span("encode");
             auto sectors = encoder.collectSectors(*ltl, image);
+            wanted = calculateSectorDigests(sectors);
             return encoder.encode(*ltl, sectors, image);
         },
         [&](const std::shared_ptr<const LogicalTrackLayout>& ltl)
         {
+            /* Each attempt needs a fresh iterator, or file-based sources will
+             * have run out of data by the time a retry happens. */
+
             FluxSourceIteratorHolder fluxSourceIteratorHolder(fluxSource);
             std::vector<std::shared_ptr<const Track>> tracks;
             auto [result, sectors] = readGroup(
                 diskLayout, fluxSourceIteratorHolder, ltl, tracks, decoder);
             log(TrackReadLogMessage{tracks, sectors});
 
+            auto verifyResult = verifySectors(*ltl, wanted, sectors);
+            log(verifyResult);
+
             if (result != GOOD_READ)
             {
-                adjustTrackOnError(fluxSource, ltl->physicalCylinder);
+                adjustTrackOnError(fluxSource,
+                    fluxSourceIteratorHolder,
+                    ltl->physicalCylinder);
                 log("bad read");
                 return false;
             }
 
-            Image wanted;
-            for (const auto& sector : encoder.collectSectors(*ltl, image))
-                wanted
-                    .put(sector->logicalCylinder,
-                        sector->logicalHead,
-                        sector->logicalSector)
-                    ->data = sector->data;
-
-            for (const auto& sector : sectors)
+            if (verifyResult.spurious)
             {
-                const auto s = wanted.get(sector->logicalCylinder,
-                    sector->logicalHead,
-                    sector->logicalSector);
-                if (!s)
-                {
-                    log("spurious sector on verify");
-                    return false;
-                }
-                if (s->data != sector->data.slice(0, s->data.size()))
-                {
-                    log("data mismatch on verify");
-                    return false;
-                }
-                wanted.erase(sector->logicalCylinder,
-                    sector->logicalHead,
-                    sector->logicalSector);
+                log("spurious sector on verify");
+                return false;
+            }
+            if (verifyResult.mismatched)
+            {
+                log("data mismatch on verify");
+                return false;
             }
-            if (!wanted.empty())
+            if (verifyResult.missing)
             {
                 log("missing sector on verify");
                 return false;
@@ -658,23 +790,210 @@ void writeRawDiskCommand(const DiskLayout& diskLayout,
         diskLayout.logicalLocations);
 }
 
-void readAndDecodeTrack(const DiskLayout& diskLayout,
+namespace
+{
+    struct SweepVariant
+    {
+        DecoderProto config;
+        std::string description;
+    };
+}
+
+/* Builds the grid of decoder parameters to try. Parameters with no values
+ * configured keep their normal value; if none are configured at all, a
+ * built-in grid around the defaults is used. */
+
+static std::vector<SweepVariant> makeSweepVariants(const DecoderProto& base)
+{
+    const auto& sweep = base.parameter_sweep();
+    bool builtin = sweep.pll_adjust().empty() && sweep.pll_phase().empty() &&
+                   sweep.bit_error_threshold().empty() &&
+                   sweep.flux_scale().empty();
+    auto values = [&](const google::protobuf::RepeatedField<double>& field,
+                      std::vector<double> builtinValues,
+                      double normal) -> std::vector<double>
+    {
+        if (builtin)
+            return builtinValues;
+        if (field.empty())
+            return {normal};
+        return {field.begin(), field.end()};
+    };
+
+    std::vector<SweepVariant> variants;
+    for (double pllAdjust :
+        values(sweep.pll_adjust(), {0.02, 0.04, 0.08}, base.pll_adjust()))
+        for (double pllPhase :
+            values(sweep.pll_phase(), {0.4, 0.6, 0.8}, base.pll_phase()))
+            for (double bitErrorThreshold : values(sweep.bit_error_threshold(),
+                     {0.3, 0.4, 0.5},
+                     base.bit_error_threshold()))
+                for (double fluxScale : values(sweep.flux_scale(),
+                         {0.98, 1.0, 1.02},
+                         base.flux_scale()))
+                {
+                    if ((pllAdjust == base.pll_adjust()) &&
+                        (pllPhase == base.pll_phase()) &&
+                        (bitErrorThreshold == base.bit_error_threshold()) &&
+                        (fluxScale == base.flux_scale()))
+                        continue;
+
+                    auto& variant = variants.emplace_back();
+                    variant.config = base;
+                    variant.config.set_pll_adjust(pllAdjust);
+                    variant.config.set_pll_phase(pllPhase);
+                    variant.config.set_bit_error_threshold(bitErrorThreshold);
+                    variant.config.set_flux_scale(fluxScale);
+                    variant.description = fmt::format(
+                        "pll_adjust: {} pll_phase: {} bit_error_threshold: {} "
+                        "flux_scale: {}",
+                        pllAdjust,
+                        pllPhase,
+                        bitErrorThreshold,
+                        fluxScale);
+                }
+    return variants;
+}
+
+/* Re-decodes flux which has already been read using each set of parameters
+ * from the sweep, in parallel, and adds any good sectors which weren't
+ * already good to the tracks. Each fluxmap is only swept once. Returns true
+ * if anything new was found. */
+
+static bool sweepDecoderParameters(
+    std::vector<std::shared_ptr<const Track>>& tracks,
+    std::set<const Fluxmap*>& swept)
+{
+    std::vector<unsigned> pending;
+    for (unsigned i = 0; i < tracks.size(); i++)
+        if (tracks[i]->fluxmap && swept.insert(tracks[i]->fluxmap.get()).second)
+            pending.push_back(i);
+    if (pending.empty())
+        return false;
+
+    std::set<LogicalLocation> good;
+    for (const auto& track : tracks)
+        for (const auto& sector : track->allSectors)
+            if (sector->status == Sector::OK)
+                good.insert(*sector);
+
+    const auto& config = globalConfig()->decoder();
+    auto variants = makeSweepVariants(config);
+    unsigned jobs = pending.size() * variants.size();
+    if (!jobs)
+        return false;
+
+    std::vector<std::vector<std::shared_ptr<const Sector>>> found(jobs);
+    parallelFor(jobs,
+        config.parameter_sweep().threads(),
+        [&](unsigned job)
+        {
+            const auto& track = tracks[pending[job / variants.size()]];
+            const auto& variant = variants[job % variants.size()];
+            auto decoder = Arch::createDecoder(variant.config);
+            auto result = decoder->decodeToSectors(track->fluxmap, track->ptl);
+            for (const auto& sector : result->allSectors)
+                if ((sector->status == Sector::OK) && !good.contains(*sector))
+                    found[job].push_back(sector);
+        });
+
+    /* Add the new sectors to copies of the tracks which produced them, and
+     * tally up which parameters found them. */
+
+    std::set<LogicalLocation> recovered;
+    std::vector<std::set<LogicalLocation>> wins(variants.size());
+    for (unsigned t = 0; t < pending.size(); t++)
+    {
+        std::vector<std::shared_ptr<const Sector>> extra;
+        std::set<std::pair<LogicalLocation, uint64_t>> seen;
+        for (unsigned v = 0; v < variants.size(); v++)
+            for (const auto& sector : found[t * variants.size() + v])
+            {
+                wins[v].insert(*sector);
+                recovered.insert(*sector);
+                if (seen.insert({*sector, sector->dataDigest()}).second)
+                    extra.push_back(sector);
+            }
+        if (extra.empty())
+            continue;
+
+        auto track = std::make_shared<Track>(*tracks[pending[t]]);
+        track->allSectors.insert(
+            track->allSectors.end(), extra.begin(), extra.end());
+        SectorCollector normalised;
+        normalised.add(track->allSectors);
+        track->normalisedSectors = normalised.sectors();
+        tracks[pending[t]] = track;
+    }
+
+    if (recovered.empty())
+        return false;
+
+    ParameterSweepLogMessage message;
+    message.recovered = recovered.size();
+    for (unsigned v = 0; v < variants.size(); v++)
+        if (!wins[v].empty())
+            message.winners.push_back(
+                {variants[v].description, (unsigned)wins[v].size()});
+    log(message);
+    return true;
+}
+
+/* Makes one attempt at reading a group. If that doesn't produce a good read,
+ * the flux already read is re-decoded with different parameters (if enabled)
+ * before giving up. */
+
+static ReadResult readAndDecodeGroup(const DiskLayout& diskLayout,
+    FluxSourceIteratorHolder& fluxSourceIteratorHolder,
+    Decoder& decoder,
+    const std::shared_ptr<const LogicalTrackLayout>& ltl,
+    std::vector<std::shared_ptr<const Track>>& tracks,
+    std::vector<std::shared_ptr<const Sector>>& combinedSectors,
+    std::set<const Fluxmap*>& swept)
+{
+    auto [result, sectors] =
+        readGroup(diskLayout, fluxSourceIteratorHolder, ltl, tracks, decoder);
+    combinedSectors = sectors;
+    if (result == GOOD_READ)
+        return result;
+
+    /* Before going back to the drive, see whether the flux we already have
+     * decodes any better with different parameters. */
+
+    if (globalConfig()->decoder().parameter_sweep().enabled() &&
+        sweepDecoderParameters(tracks, swept))
+    {
+        SectorCollector collector;
+        for (const auto& track : tracks)
+            collector.add(track->allSectors);
+        auto [sweepResult, sweepSectors] =
+            combineRecordAndSectors(collector, ltl);
+        combinedSectors = sweepSectors;
+        if (sweepResult == HAS_NO_BAD_SECTORS)
+            return GOOD_READ;
+    }
+    return result;
+}
+
+static void readAndDecodeTrack(const DiskLayout& diskLayout,
     FluxSource& fluxSource,
+    FluxSourceIteratorHolder& fluxSourceIteratorHolder,
     Decoder& decoder,
     const std::shared_ptr<const LogicalTrackLayout>& ltl,
     std::vector<std::shared_ptr<const Track>>& tracks,
     std::vector<std::shared_ptr<const Sector>>& combinedSectors)
 {
-    if (fluxSource.isHardware())
-        measureDiskRotation();
-
-    FluxSourceIteratorHolder fluxSourceIteratorHolder(fluxSource);
     int retriesRemaining = globalConfig()->decoder().retries();
+    std::set<const Fluxmap*> swept;
     for (;;)
     {
-        auto [result, sectors] = readGroup(
-            diskLayout, fluxSourceIteratorHolder, ltl, tracks, decoder);
-        combinedSectors = sectors;
+        auto result = readAndDecodeGroup(diskLayout,
+            fluxSourceIteratorHolder,
+            decoder,
+            ltl,
+            tracks,
+            combinedSectors,
+            swept);
         if (result == GOOD_READ)
             break;
         if (result == BAD_AND_CAN_NOT_RETRY)
@@ -691,13 +1010,196 @@ void readAndDecodeTrack(const DiskLayout& diskLayout,
 
         if (fluxSource.isHardware())
         {
-            adjustTrackOnError(fluxSource, ltl->physicalCylinder);
+            adjustTrackOnError(
+                fluxSource, fluxSourceIteratorHolder, ltl->physicalCylinder);
             log("retrying; {} retries remaining", retriesRemaining);
             retriesRemaining--;
         }
     }
 }
 
+void readAndDecodeTrack(const DiskLayout& diskLayout,
+    FluxSource& fluxSource,
+    Decoder& decoder,
+    const std::shared_ptr<const LogicalTrackLayout>& ltl,
+    std::vector<std::shared_ptr<const Track>>& tracks,
+    std::vector<std::shared_ptr<const Sector>>& combinedSectors)
+{
+    if (fluxSource.isHardware())
+        measureDiskRotation();
+
+    FluxSourceIteratorHolder fluxSourceIteratorHolder(fluxSource);
+    readAndDecodeTrack(diskLayout,
+        fluxSource,
+        fluxSourceIteratorHolder,
+        decoder,
+        ltl,
+        tracks,
+        combinedSectors);
+}
+
+/* Orders the groups to retry so as to move the head as little as possible:
+ * go to whichever end is nearer, picking up groups on the way, and then sweep
+ * across to the other end. */
+
+static std::vector<std::shared_ptr<const LogicalTrackLayout>>
+orderForMinimumTravel(
+    std::vector<std::shared_ptr<const LogicalTrackLayout>> ltls,
+    unsigned cylinder)
+{
+    std::ranges::stable_sort(ltls, {}, &LogicalTrackLayout::physicalCylinder);
+    if (ltls.empty())
+        return ltls;
+
+    unsigned lo = ltls.front()->physicalCylinder;
+    unsigned hi = ltls.back()->physicalCylinder;
+    bool downFirst = (cylinder - std::min(cylinder, lo)) <=
+                     (std::max(cylinder, hi) - cylinder);
+
+    std::vector<std::shared_ptr<const LogicalTrackLayout>> below, above;
+    for (const auto& ltl : ltls)
+    {
+        bool isBelow = downFirst ? (ltl->physicalCylinder <= cylinder)
+                                 : (ltl->physicalCylinder < cylinder);
+        (isBelow ? below : above).push_back(ltl);
+    }
+
+    std::vector<std::shared_ptr<const LogicalTrackLayout>> result;
+    if (downFirst)
+    {
+        result.insert(result.end(), below.rbegin(), below.rend());
+        result.insert(result.end(), above.begin(), above.end());
+    }
+    else
+    {
+        result.insert(result.end(), above.begin(), above.end());
+        result.insert(result.end(), below.rbegin(), below.rend());
+    }
+    return result;
+}
+
+/* The physical locations readDiskCommand() will read, in the order it reads
+ * them (assuming no retries). */
+
+static std::vector<CylinderHead> getReadOrder(const DiskLayout& diskLayout)
+{
+    std::vector<CylinderHead> locations;
+    for (auto& [logicalLocation, ltl] : diskLayout.layoutByLogicalLocation)
+        for (unsigned offset = 0; offset < ltl->groupSize;
+            offset += diskLayout.headWidth)
+            locations.push_back(CylinderHead{
+                ltl->physicalCylinder + offset, ltl->physicalHead});
+    return locations;
+}
+
+/* Replaces a track's flux and sectors on the disk with a newly read set, and
+ * tells everyone about it. */
+
+static void updateDisk(Disk& disk,
+    const std::vector<std::shared_ptr<const Track>>& trackFluxes,
+    const std::vector<std::shared_ptr<const Sector>>& trackSectors)
+{
+    for (const auto& flux : trackFluxes)
+        disk.tracksByPhysicalLocation.erase(
+            CylinderHead{flux->ptl->physicalCylinder, flux->ptl->physicalHead});
+    for (const auto& flux : trackFluxes)
+        disk.tracksByPhysicalLocation.emplace(
+            CylinderHead{flux->ptl->physicalCylinder, flux->ptl->physicalHead},
+            flux);
+
+    /* Likewise for sectors. */
+
+    for (const auto& sector : trackSectors)
+        disk.sectorsByPhysicalLocation.erase(sector->physicalLocation.value());
+    for (const auto& sector : trackSectors)
+        disk.sectorsByPhysicalLocation.emplace(
+            sector->physicalLocation.value(), sector);
+
+    if (globalConfig()->decoder().dump_records())
+    {
+        std::vector<std::shared_ptr<const Record>> sorted_records;
+
+        for (const auto& data : trackFluxes)
+            sorted_records.insert(sorted_records.end(),
+                data->records.begin(),
+                data->records.end());
+
+        std::sort(sorted_records.begin(),
+            sorted_records.end(),
+            [](const auto& o1, const auto& o2)
+            {
+                return o1->startTime < o2->startTime;
+            });
+
+        std::cout << "\nRaw (undecoded) records follow:\n\n";
+        for (const auto& record : sorted_records)
+        {
+            std::cout << fmt::format("I+{:.2f}us with {:.2f}us clock\n",
+                record->startTime / 1000.0,
+                record->clock / 1000.0);
+            hexdump(std::cout, record->rawData);
+            std::cout << std::endl;
+        }
+    }
+
+    if (globalConfig()->decoder().dump_sectors())
+    {
+        SectorCollector collector(false);
+        collector.add(trackSectors);
+        auto sectors = collector.sectors();
+        std::ranges::sort(sectors,
+            [](const auto& o1, const auto& o2)
+            {
+                return *o1 < *o2;
+            });
+
+        std::cout << "\nDecoded sectors follow:\n\n";
+        for (const auto& sector : sectors)
+        {
+            std::cout << fmt::format(
+                "{}.{:02}.{:02}: I+{:.2f}us with {:.2f}us clock: "
+                "status {}\n",
+                sector->logicalCylinder,
+                sector->logicalHead,
+                sector->logicalSector,
+                sector->headerStartTime / 1000.0,
+                sector->clock / 1000.0,
+                Sector::statusToString(sector->status));
+            hexdump(std::cout, sector->data);
+            std::cout << std::endl;
+        }
+    }
+
+    /* track can't be modified below this point. */
+    log(TrackReadLogMessage{trackFluxes, trackSectors});
+
+    SectorCollector collector;
+    for (auto& [ch, sector] : disk.sectorsByPhysicalLocation)
+        collector.add(sector);
+    disk.image = std::make_shared<Image>(collector.sectors());
+
+    std::set<CylinderHead> logicalTracks;
+    for (const auto& flux : trackFluxes)
+        if (const auto& ltl = flux->ptl->logicalTrackLayout)
+            logicalTracks.insert({ltl->logicalCylinder, ltl->logicalHead});
+    for (const auto& sector : trackSectors)
+        logicalTracks.insert(sector->trackLocation());
+
+    /* Log a _copy_ of the disk structure so that the logger
+     * doesn't see the disk get mutated in subsequent reads. */
+    log(DiskReadLogMessage{std::make_shared<Disk>(disk), logicalTracks});
+}
+
+static void setRetryPassRevolutions(int pass)
+{
+    const auto& revolutions =
+        globalConfig()->decoder().deferred_retries().revolutions();
+    if (!revolutions.empty())
+        globalConfig().setTransient("drive.revolutions",
+            std::to_string(
+                revolutions[std::min(pass, revolutions.size()) - 1]));
+}
+
 void readDiskCommand(const DiskLayout& diskLayout,
     FluxSource& fluxSource,
     Decoder& decoder,
@@ -721,11 +1223,45 @@ void readDiskCommand(const DiskLayout& diskLayout,
         disk.rotationalPeriod = measureDiskRotation();
     else
         disk.rotationalPeriod = getRotationalPeriodFromConfig();
+    fluxSource.setReadOrder(getReadOrder(diskLayout));
+
+    /* With deferred retries, the first pass reads each group once, and any
+     * which could do with another go are retried in later passes. This
+     * avoids stalling on one bad track, and lets the retries be done in
+     * whatever order moves the head least. */
+
+    const auto& deferredRetries = globalConfig()->decoder().deferred_retries();
+    bool deferred = deferredRetries.enabled();
+    FluxSourceIteratorHolder fluxSourceIteratorHolder(fluxSource);
+    std::map<CylinderHead, std::set<const Fluxmap*>> swept;
+    std::vector<std::shared_ptr<const LogicalTrackLayout>> failed;
+    unsigned retriedGroups = 0;
 
     {
         std::unique_ptr<FluxSink> outputFluxSink;
         if (outputFluxSinkFactory)
             outputFluxSink = outputFluxSinkFactory->create();
+
+        /* Flux is only copied once a group is finished with, so that retried
+         * groups don't get written twice. */
+
+        auto writeFlux =
+            [&](const std::vector<std::shared_ptr<const Track>>& trackFluxes)
+        {
+            if (outputFluxSink)
+            {
+                for (const auto& data : trackFluxes)
+                {
+                    TraceSpan span("sink write",
+                        {{"cylinder", data->ptl->physicalCylinder},
+                            {"head", data->ptl->physicalHead}});
+                    outputFluxSink->addFlux(data->ptl->physicalCylinder,
+                        data->ptl->physicalHead,
+                        *data->fluxmap);
+                }
+            }
+        };
+
         unsigned index = 0;
         for (auto& [logicalLocation, ltl] : diskLayout.layoutByLogicalLocation)
         {
@@ -738,112 +1274,118 @@ void readDiskCommand(const DiskLayout& diskLayout,
 
             auto& trackFluxes = tracksByLogicalLocation[logicalLocation];
             std::vector<std::shared_ptr<const Sector>> trackSectors;
-            readAndDecodeTrack(diskLayout,
-                fluxSource,
-                decoder,
-                ltl,
-                trackFluxes,
-                trackSectors);
-
-            /* Replace all tracks on the disk by the new combined set. */
-
-            for (const auto& flux : trackFluxes)
-                disk.tracksByPhysicalLocation.erase(CylinderHead{
-                    flux->ptl->physicalCylinder, flux->ptl->physicalHead});
-            for (const auto& flux : trackFluxes)
-                disk.tracksByPhysicalLocation.emplace(
-                    CylinderHead{
-                        flux->ptl->physicalCylinder, flux->ptl->physicalHead},
-                    flux);
-
-            /* Likewise for sectors. */
-
-            for (const auto& sector : trackSectors)
-                disk.sectorsByPhysicalLocation.erase(
-                    sector->physicalLocation.value());
-            for (const auto& sector : trackSectors)
-                disk.sectorsByPhysicalLocation.emplace(
-                    sector->physicalLocation.value(), sector);
-
-            if (outputFluxSink)
+            if (deferred)
             {
-                for (const auto& data : trackFluxes)
-                    outputFluxSink->addFlux(data->ptl->physicalCylinder,
-                        data->ptl->physicalHead,
-                        *data->fluxmap);
+                auto result = readAndDecodeGroup(diskLayout,
+                    fluxSourceIteratorHolder,
+                    decoder,
+                    ltl,
+                    trackFluxes,
+                    trackSectors,
+                    swept[logicalLocation]);
+                if (result == BAD_AND_CAN_RETRY)
+                    failed.push_back(ltl);
+                else
+                    writeFlux(trackFluxes);
             }
-
-            if (globalConfig()->decoder().dump_records())
+            else
             {
-                std::vector<std::shared_ptr<const Record>> sorted_records;
-
-                for (const auto& data : trackFluxes)
-                    sorted_records.insert(sorted_records.end(),
-                        data->records.begin(),
-                        data->records.end());
+                readAndDecodeTrack(diskLayout,
+                    fluxSource,
+                    fluxSourceIteratorHolder,
+                    decoder,
+                    ltl,
+                    trackFluxes,
+                    trackSectors);
+                writeFlux(trackFluxes);
+            }
 
-                std::sort(sorted_records.begin(),
-                    sorted_records.end(),
-                    [](const auto& o1, const auto& o2)
-                    {
-                        return o1->startTime < o2->startTime;
-                    });
+            updateDisk(disk, trackFluxes, trackSectors);
+        }
 
-                std::cout << "\nRaw (undecoded) records follow:\n\n";
-                for (const auto& record : sorted_records)
+        retriedGroups = failed.size();
+        if (!failed.empty())
+        {
+            double revolutions = globalConfig()->drive().revolutions();
+            int retries = globalConfig()->decoder().retries();
+            for (int pass = 1; !failed.empty(); pass++)
+            {
+                if (pass > retries)
                 {
-                    std::cout << fmt::format("I+{:.2f}us with {:.2f}us clock\n",
-                        record->startTime / 1000.0,
-                        record->clock / 1000.0);
-                    hexdump(std::cout, record->rawData);
-                    std::cout << std::endl;
+                    log("giving up on {} tracks", failed.size());
+                    break;
                 }
-            }
 
-            if (globalConfig()->decoder().dump_sectors())
-            {
-                auto sectors = collectSectors(trackSectors, false);
-                std::ranges::sort(sectors,
-                    [](const auto& o1, const auto& o2)
-                    {
-                        return *o1 < *o2;
-                    });
-
-                std::cout << "\nDecoded sectors follow:\n\n";
-                for (const auto& sector : sectors)
+                setRetryPassRevolutions(pass);
+                log("retry pass {}: {} tracks at {} revolutions",
+                    pass,
+                    failed.size(),
+                    globalConfig()->drive().revolutions());
+                bool recalibrate = fluxSource.isHardware() &&
+                                   (globalConfig()->drive().error_behaviour() ==
+                                       DriveProto::RECALIBRATE);
+                if (recalibrate)
                 {
-                    std::cout << fmt::format(
-                        "{}.{:02}.{:02}: I+{:.2f}us with {:.2f}us clock: "
-                        "status {}\n",
-                        sector->logicalCylinder,
-                        sector->logicalHead,
-                        sector->logicalSector,
-                        sector->headerStartTime / 1000.0,
-                        sector->clock / 1000.0,
-                        Sector::statusToString(sector->status));
-                    hexdump(std::cout, sector->data);
-                    std::cout << std::endl;
+                    fluxSource.recalibrate();
+                    fluxSourceIteratorHolder.moveHead(0);
                 }
-            }
 
-            /* track can't be modified below this point. */
-            log(TrackReadLogMessage{trackFluxes, trackSectors});
+                std::vector<std::shared_ptr<const LogicalTrackLayout>>
+                    stillFailed;
+                for (const auto& ltl : orderForMinimumTravel(
+                         failed, fluxSourceIteratorHolder.cylinder()))
+                {
+                    testForEmergencyStop();
+
+                    /* Recalibrating has already been done, once for the whole
+                     * pass, rather than once per track. */
+
+                    if (fluxSource.isHardware() && !recalibrate)
+                        adjustTrackOnError(fluxSource,
+                            fluxSourceIteratorHolder,
+                            ltl->physicalCylinder);
+
+                    CylinderHead logicalLocation{
+                        ltl->logicalCylinder, ltl->logicalHead};
+                    auto& trackFluxes =
+                        tracksByLogicalLocation[logicalLocation];
+                    std::vector<std::shared_ptr<const Sector>> trackSectors;
+                    auto result = readAndDecodeGroup(diskLayout,
+                        fluxSourceIteratorHolder,
+                        decoder,
+                        ltl,
+                        trackFluxes,
+                        trackSectors,
+                        swept[logicalLocation]);
+                    if (result == BAD_AND_CAN_RETRY)
+                        stillFailed.push_back(ltl);
+                    else
+                        writeFlux(trackFluxes);
 
-            std::vector<std::shared_ptr<const Sector>> all_sectors;
-            for (auto& [ch, sector] : disk.sectorsByPhysicalLocation)
-                all_sectors.push_back(sector);
-            all_sectors = collectSectors(all_sectors);
-            disk.image = std::make_shared<Image>(all_sectors);
+                    updateDisk(disk, trackFluxes, trackSectors);
+                }
+                failed = stillFailed;
+            }
 
-            /* Log a _copy_ of the disk structure so that the logger
-             * doesn't see the disk get mutated in subsequent reads. */
-            log(DiskReadLogMessage{std::make_shared<Disk>(disk)});
+            globalConfig().setTransient(
+                "drive.revolutions", std::to_string(revolutions));
+            for (const auto& ltl : failed)
+                writeFlux(tracksByLogicalLocation[{
+                    ltl->logicalCylinder, ltl->logicalHead}]);
         }
     }
 
     if (!disk.image)
         disk.image = std::make_shared<Image>();
 
+    if (fluxSource.isHardware())
+        log("{} seeks, {} cylinders of head travel",
+            fluxSourceIteratorHolder.seeks(),
+            fluxSourceIteratorHolder.travel());
+    if (deferred)
+        log("{} tracks needed retrying, of which {} were recovered",
+            retriedGroups,
+            retriedGroups - failed.size());
     log(EndOperationLogMessage{"Read complete"});
 }
 
@@ -858,5 +1400,73 @@ void readDiskCommand(const DiskLayout& diskLayout,
     writer.printMap(*disk.image);
     if (globalConfig()->decoder().has_write_csv_to())
         writer.writeCsv(*disk.image, globalConfig()->decoder().write_csv_to());
+
+    TraceSpan span("image write");
     writer.writeImage(*disk.image);
 }
+
+static void readDiskJob(const ReadJob& job)
+{
+    log("{}: reading drive {} to '{}'", job.serial, job.drive, job.output);
+
+    auto diskLayout = createDiskLayout(globalConfig());
+    auto fluxSource = FluxSource::create(globalConfig());
+    auto decoder = Arch::createDecoder(globalConfig());
+    auto writer = ImageWriter::create(globalConfig());
+    readDiskCommand(*diskLayout, *fluxSource, *decoder, *writer);
+}
+
+void readDisksCommand(const std::vector<ReadJob>& jobs)
+{
+    /* Each job gets its own copy of the config, with its drive and output
+     * filled in. All the devices are opened up front, so that any missing
+     * ones are noticed before anything starts. */
+
+    std::vector<Config> configs;
+    configs.reserve(jobs.size());
+    std::map<std::string, std::vector<unsigned>> jobsByDevice;
+    for (unsigned i = 0; i < jobs.size(); i++)
+    {
+        const auto& job = jobs[i];
+        getUsb(job.serial);
+        jobsByDevice[job.serial].push_back(i);
+
+        Config& config = configs.emplace_back(globalConfig());
+        config.overrides()->mutable_drive()->set_drive(job.drive);
+        config.setImageWriter(job.output);
+    }
+
+    /* Each device gets a thread, which runs that device's jobs one after the
+     * other. */
+
+    std::mutex failuresMutex;
+    std::vector<std::string> failures;
+    std::vector<std::thread> pool;
+    for (const auto& [serial, indices] : jobsByDevice)
+        pool.emplace_back(
+            [&, serial, indices]
+            {
+                UsbBinding usbBinding(serial);
+                for (unsigned i : indices)
+                {
+                    ConfigBinding configBinding(configs[i]);
+                    try
+                    {
+                        readDiskJob(jobs[i]);
+                    }
+                    catch (const ErrorException& e)
+                    {
+                        std::lock_guard<std::mutex> lock(failuresMutex);
+                        failures.push_back(fmt::format(
+                            "{}: {}", jobs[i].output, e.message));
+                    }
+                }
+            });
+    for (auto& thread : pool)
+        thread.join();
+
+    for (const auto& failure : failures)
+        warning(failure);
+    if (!failures.empty())
+        error("{} of {} disks could not be read", failures.size(), jobs.size());
+}
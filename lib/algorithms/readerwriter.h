@@ -37,6 +37,9 @@ struct TrackReadLogMessage
 struct DiskReadLogMessage
 {
     std::shared_ptr<const Disk> disk;
+
+    /* The logical tracks whose sectors may have changed. */
+    std::set<CylinderHead> logicalTracks;
 };
 
 struct BeginReadOperationLogMessage
@@ -61,6 +64,22 @@ struct EndWriteOperationLogMessage
 {
 };
 
+struct VerifyTrackLogMessage
+{
+    unsigned matched;
+    unsigned mismatched;
+    unsigned missing;
+    unsigned spurious;
+};
+
+struct ParameterSweepLogMessage
+{
+    /* Each set of decoder parameters which found sectors the normal ones
+     * didn't, and how many. */
+    std::vector<std::pair<std::string, unsigned>> winners;
+    unsigned recovered;
+};
+
 struct BeginOperationLogMessage
 {
     std::string message;
@@ -76,6 +95,12 @@ struct OperationProgressLogMessage
     unsigned progress;
 };
 
+/* Works out how fast the disk in the current drive is spinning (unless
+ * drive.rotational_period_ms is already set) and records it in the config, so
+ * that hardware reads know how long a revolution is. */
+
+extern nanoseconds_t measureDiskRotation();
+
 extern void writeTracks(const DiskLayout& diskLayout,
     FluxSinkFactory& fluxSinkFactory,
     const std::function<std::unique_ptr<const Fluxmap>(
@@ -128,4 +153,20 @@ extern void readDiskCommand(const DiskLayout& diskLayout,
     Decoder& decoder,
     ImageWriter& writer);
 
+/* One disk to read, from the given drive on the device with the given serial
+ * number, into an image file. */
+
+struct ReadJob
+{
+    std::string serial;
+    int drive;
+    std::string output;
+};
+
+/* Reads several disks at once, using the current config for everything except
+ * the drive and output file. Jobs on different devices run in parallel; jobs
+ * on the same device run one after another. */
+
+extern void readDisksCommand(const std::vector<ReadJob>& jobs);
+
 #endif
@@ -8,6 +8,7 @@
 #include <fmt/ranges.h>
 
 static Config config;
+static thread_local Config* threadConfig = nullptr;
 
 enum ConstructorMode
 {
@@ -173,7 +174,17 @@ void renderLogMessage(LogRenderer& r, std::shared_ptr<const OptionLogMessage> m)
 
 Config& globalConfig()
 {
-    return config;
+    return threadConfig ? *threadConfig : config;
+}
+
+ConfigBinding::ConfigBinding(Config& config): _previous(threadConfig)
+{
+    threadConfig = &config;
+}
+
+ConfigBinding::~ConfigBinding()
+{
+    threadConfig = _previous;
 }
 
 ConfigProto* Config::combined()
@@ -187,4 +187,19 @@ private:
 
 extern Config& globalConfig();
 
+/* While one of these exists, globalConfig() on the thread which created it
+ * returns the given config instead of the process-wide one. This lets several
+ * operations with different settings run at once. Copies of the global config
+ * refer to its options, so it mustn't be changed while they're in use. */
+
+class ConfigBinding
+{
+public:
+    ConfigBinding(Config& config);
+    ~ConfigBinding();
+
+private:
+    Config* _previous;
+};
+
 #endif
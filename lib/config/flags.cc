@@ -4,6 +4,7 @@
 #include "lib/config/proto.h"
 #include "lib/core/utils.h"
 #include "lib/core/logger.h"
+#include "lib/core/trace.h"
 #include <google/protobuf/text_format.h>
 #include <regex>
 #include <fstream>
@@ -16,6 +17,7 @@ static void doHelp();
 static void doLoadConfig(const std::string& filename);
 static void doShowConfig();
 static void doDoc();
+static void doTraceTo(const std::string& filename);
 
 static FlagGroup helpGroup;
 static ActionFlag helpFlag = ActionFlag({"--help"}, "Shows the help.", doHelp);
@@ -32,6 +34,10 @@ static ActionFlag showConfigFlag({"--show-config", "-C"},
 static ActionFlag docFlag(
     {"--doc"}, "Shows the available configuration options and halts.", doDoc);
 
+static ActionFlag traceToFlag({"--trace-to"},
+    "Writes a timing trace of the run to a file, in Chrome trace format.",
+    doTraceTo);
+
 FlagGroup::FlagGroup()
 {
     currentFlagGroup = this;
@@ -194,6 +200,11 @@ static void doLoadConfig(const std::string& filename)
     globalConfig().readBaseConfigFile(filename);
 }
 
+static void doTraceTo(const std::string& filename)
+{
+    Trace::traceTo(filename);
+}
+
 void FlagGroup::parseFlagsWithConfigFiles(int argc,
     const char* argv[],
     const std::map<std::string, const ConfigProto*>& configFiles)
@@ -6,18 +6,24 @@ cxxlibrary(
         "./bitmap.cc",
         "./bytes.cc",
         "./crc.cc",
+        "./crccorrector.cc",
         "./hexdump.cc",
         "./utils.cc",
         "./logger.cc",
         "./logrenderer.cc",
+        "./mappedfile.cc",
+        "./trace.cc",
     ],
     hdrs={
         "lib/core/bitmap.h": "./bitmap.h",
         "lib/core/bytes.h": "./bytes.h",
         "lib/core/crc.h": "./crc.h",
+        "lib/core/crccorrector.h": "./crccorrector.h",
         "lib/core/globals.h": "./globals.h",
         "lib/core/utils.h": "./utils.h",
         "lib/core/logger.h": "./logger.h",
+        "lib/core/mappedfile.h": "./mappedfile.h",
+        "lib/core/trace.h": "./trace.h",
     },
     deps=[
         "dep/agg",
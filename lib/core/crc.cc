@@ -107,3 +107,13 @@ uint32_t crcbrother(const Bytes& bytes)
 
     return crc & 0xFFFFFF;
 }
+
+uint64_t fnv1a64(uint64_t hash, const Bytes& bytes)
+{
+    for (uint8_t b : bytes)
+    {
+        hash ^= b;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
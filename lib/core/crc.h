@@ -6,6 +6,8 @@
 #define MODBUS_POLY_REF 0xa001
 #define BROTHER_POLY 0x000201
 
+#define FNV1A64_INIT 0xcbf29ce484222325ULL
+
 struct crcspec
 {
     unsigned width;
@@ -24,6 +26,10 @@ extern uint16_t crc16(uint16_t poly, uint16_t init, const Bytes& bytes);
 extern uint16_t crc16ref(uint16_t poly, uint16_t init, const Bytes& bytes);
 extern uint32_t crcbrother(const Bytes& bytes);
 
+/* Not a CRC, but a fast 64-bit digest used for comparing sector payloads
+ * without having to keep the payloads themselves around. */
+extern uint64_t fnv1a64(uint64_t hash, const Bytes& bytes);
+
 static inline uint16_t crc16(uint16_t poly, const Bytes& bytes)
 {
     return crc16(poly, 0xffff, bytes);
@@ -34,4 +40,9 @@ static inline uint16_t crc16ref(uint16_t poly, const Bytes& bytes)
     return crc16ref(poly, 0xffff, bytes);
 }
 
+static inline uint64_t fnv1a64(const Bytes& bytes)
+{
+    return fnv1a64(FNV1A64_INIT, bytes);
+}
+
 #endif
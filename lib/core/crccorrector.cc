@@ -0,0 +1,141 @@
+#include "lib/core/globals.h"
+#include "lib/core/bytes.h"
+#include "lib/core/crccorrector.h"
+
+/* Each table entry is either AMBIGUOUS or (exponent << 2) | kind, where the
+ * exponent identifies the (first) bit of the block which was flipped, or
+ * the bit of the check value. */
+
+enum
+{
+    DATA_SINGLE,
+    DATA_PAIR,
+    CHECK_SINGLE,
+    CHECK_PAIR
+};
+
+static constexpr int64_t AMBIGUOUS = -1;
+
+static void insert(std::unordered_map<uint64_t, int64_t>& table,
+    uint64_t syndrome,
+    int64_t value)
+{
+    auto [it, inserted] = table.try_emplace(syndrome, value);
+    if (!inserted)
+        it->second = AMBIGUOUS;
+}
+
+CrcCorrector::CrcCorrector(
+    Algorithm algorithm, unsigned width, uint64_t poly, bool adjacentPairs):
+    _algorithm(algorithm),
+    _width(width),
+    _poly(poly),
+    _mask((width == 64) ? UINT64_MAX : ((1ULL << width) - 1)),
+    _adjacentPairs(adjacentPairs)
+{
+}
+
+/* Clocks a zero bit through the CRC register. */
+
+uint64_t CrcCorrector::step(uint64_t v) const
+{
+    if (_algorithm == CRC_LSB_FIRST)
+        return (v & 1) ? ((v >> 1) ^ _poly) : (v >> 1);
+
+    uint64_t top = 1ULL << (_width - 1);
+    return ((v & top) ? ((v << 1) ^ _poly) : (v << 1)) & _mask;
+}
+
+/* Flipping a bit of the block changes the check value by the seed stepped
+ * some number of times, depending on how far from the end of the block the
+ * bit is; this maps that number back to the byte and bit. */
+
+std::pair<unsigned, uint8_t> CrcCorrector::locate(
+    unsigned length, unsigned e) const
+{
+    unsigned p = length * 8 - e;
+    if (_algorithm == CRC_MSB_FIRST)
+        return {p / 8, 0x80 >> (p % 8)};
+    return {p / 8, 1 << (p % 8)};
+}
+
+const CrcCorrector::Table& CrcCorrector::tableFor(unsigned length)
+{
+    auto it = _tables.find(length);
+    if (it != _tables.end())
+        return it->second;
+
+    Table& table = _tables[length];
+    unsigned bits = length * 8;
+    table.reserve(bits * (_adjacentPairs ? 2 : 1) + _width * 2);
+
+    /* A bit enters the register at the top (or bottom), and is then clocked
+     * once for itself and once for every bit after it. */
+
+    uint64_t v = (_algorithm == CRC_MSB_FIRST) ? (1ULL << (_width - 1)) : 1;
+    v = step(v);
+
+    uint64_t previous = 0;
+    for (unsigned i = 0; i < bits; i++)
+    {
+        int64_t e = i + 1;
+        insert(table, v, (e << 2) | DATA_SINGLE);
+        if (_adjacentPairs && i)
+            insert(table, v ^ previous, ((e - 1) << 2) | DATA_PAIR);
+        previous = v;
+        v = step(v);
+    }
+
+    for (unsigned i = 0; i < _width; i++)
+    {
+        int64_t e = i;
+        insert(table, 1ULL << i, (e << 2) | CHECK_SINGLE);
+        if (_adjacentPairs && (i != (_width - 1)))
+            insert(table, 3ULL << i, (e << 2) | CHECK_PAIR);
+    }
+
+    return table;
+}
+
+bool CrcCorrector::correct(
+    Bytes& block, uint64_t got, uint64_t wanted, unsigned first)
+{
+    uint64_t syndrome = (got ^ wanted) & _mask;
+    if (!syndrome)
+        return true;
+    if (block.empty())
+        return false;
+
+    const Table& table = tableFor(block.size());
+    auto it = table.find(syndrome);
+    if ((it == table.end()) || (it->second == AMBIGUOUS))
+        return false;
+
+    unsigned e = it->second >> 2;
+    switch (it->second & 3)
+    {
+        case CHECK_SINGLE:
+        case CHECK_PAIR:
+            return true;
+
+        case DATA_SINGLE:
+        {
+            auto [byte, bit] = locate(block.size(), e);
+            if (byte < first)
+                return false;
+            block[byte] ^= bit;
+            return true;
+        }
+
+        default:
+        {
+            auto [byte1, bit1] = locate(block.size(), e);
+            auto [byte2, bit2] = locate(block.size(), e + 1);
+            if ((byte1 < first) || (byte2 < first))
+                return false;
+            block[byte1] ^= bit1;
+            block[byte2] ^= bit2;
+            return true;
+        }
+    }
+}
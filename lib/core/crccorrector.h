@@ -0,0 +1,54 @@
+#ifndef CRCCORRECTOR_H
+#define CRCCORRECTOR_H
+
+#include <unordered_map>
+
+/* Repairs small errors in a block protected by a CRC. Because a CRC is linear,
+ * the difference between the check value calculated from the data as read and
+ * the one read from disk (the syndrome) depends only on which bits are wrong,
+ * not on the data. So the syndrome of every single bit flip (and, optionally,
+ * every flip of two adjacent bits) is precomputed once per block length, and
+ * then correcting a block is just a table lookup. Syndromes which more than
+ * one error pattern could have caused are never corrected --- which, for a
+ * weak polynomial whose period is shorter than the block, is all of them. */
+
+class CrcCorrector
+{
+public:
+    enum Algorithm
+    {
+        /* crc16() and friends: bytes are fed in MSB first. */
+        CRC_MSB_FIRST,
+
+        /* crc16ref() and friends: bytes are fed in LSB first. */
+        CRC_LSB_FIRST,
+    };
+
+    CrcCorrector(
+        Algorithm algorithm, unsigned width, uint64_t poly, bool adjacentPairs);
+
+    /* Tries to repair block, which is everything the check value covers. got
+     * is the check value calculated from the block and wanted is the one read
+     * from disk. Only bits from byte first onwards may be changed. Returns
+     * true if the error was found (it may have been in the check value
+     * itself, in which case the block is left alone). */
+
+    bool correct(
+        Bytes& block, uint64_t got, uint64_t wanted, unsigned first = 0);
+
+private:
+    using Table = std::unordered_map<uint64_t, int64_t>;
+
+    const Table& tableFor(unsigned length);
+    uint64_t step(uint64_t v) const;
+    std::pair<unsigned, uint8_t> locate(unsigned length, unsigned e) const;
+
+    Algorithm _algorithm;
+    unsigned _width;
+    uint64_t _poly;
+    uint64_t _mask;
+    bool _adjacentPairs;
+    std::map<unsigned, Table> _tables;
+};
+
+#endif
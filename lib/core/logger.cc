@@ -1,6 +1,7 @@
 #include "lib/core/globals.h"
 #include "lib/core/bytes.h"
 #include "lib/core/logger.h"
+#include <mutex>
 
 static bool indented = false;
 
@@ -18,6 +19,11 @@ void log(const char* m)
 
 void log(const AnyLogMessage& message)
 {
+    /* Flux sources may read ahead on background threads, and those reads
+     * log too. */
+
+    static std::recursive_mutex mutex;
+    std::lock_guard<std::recursive_mutex> lock(mutex);
     loggerImpl(message);
 }
 
@@ -19,6 +19,8 @@ struct BeginReadOperationLogMessage;
 struct EndReadOperationLogMessage;
 struct BeginWriteOperationLogMessage;
 struct EndWriteOperationLogMessage;
+struct VerifyTrackLogMessage;
+struct ParameterSweepLogMessage;
 struct BeginOperationLogMessage;
 struct EndOperationLogMessage;
 struct OperationProgressLogMessage;
@@ -53,6 +55,10 @@ extern void renderLogMessage(
     LogRenderer& r, std::shared_ptr<const BeginWriteOperationLogMessage> m);
 extern void renderLogMessage(
     LogRenderer& r, std::shared_ptr<const EndWriteOperationLogMessage> m);
+extern void renderLogMessage(
+    LogRenderer& r, std::shared_ptr<const VerifyTrackLogMessage> m);
+extern void renderLogMessage(
+    LogRenderer& r, std::shared_ptr<const ParameterSweepLogMessage> m);
 extern void renderLogMessage(
     LogRenderer& r, std::shared_ptr<const BeginOperationLogMessage> m);
 extern void renderLogMessage(
@@ -73,6 +79,8 @@ typedef std::variant<std::shared_ptr<const std::string>,
     std::shared_ptr<const EndReadOperationLogMessage>,
     std::shared_ptr<const BeginWriteOperationLogMessage>,
     std::shared_ptr<const EndWriteOperationLogMessage>,
+    std::shared_ptr<const VerifyTrackLogMessage>,
+    std::shared_ptr<const ParameterSweepLogMessage>,
     std::shared_ptr<const BeginOperationLogMessage>,
     std::shared_ptr<const EndOperationLogMessage>,
     std::shared_ptr<const OperationProgressLogMessage>,
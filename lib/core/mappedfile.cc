@@ -0,0 +1,96 @@
+#include "lib/core/globals.h"
+#include "lib/core/mappedfile.h"
+
+#if defined(_WIN32) || defined(__WIN32__)
+#include <windows.h>
+
+MappedFile::MappedFile(const std::string& filename)
+{
+    _file = CreateFileA(filename.c_str(),
+        /* dwDesiredAccess= */ GENERIC_READ,
+        /* dwShareMode= */ FILE_SHARE_READ,
+        /* lpSecurityAttribues= */ nullptr,
+        /* dwCreationDisposition= */ OPEN_EXISTING,
+        /* dwFlagsAndAttributes= */ FILE_ATTRIBUTE_NORMAL,
+        /* hTemplateFile= */ nullptr);
+    if (_file == INVALID_HANDLE_VALUE)
+        error("cannot open input file '{}': error {}",
+            filename,
+            (int)GetLastError());
+
+    auto fail = [&](const char* what)
+    {
+        int e = GetLastError();
+        if (_mapping)
+            CloseHandle(_mapping);
+        CloseHandle(_file);
+        error("cannot {} '{}': error {}", what, filename, e);
+    };
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(_file, &size))
+        fail("get size of");
+    _size = size.QuadPart;
+    if (_size == 0)
+        return;
+
+    _mapping =
+        CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!_mapping)
+        fail("map");
+    _data = (const uint8_t*)MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!_data)
+        fail("map");
+}
+
+MappedFile::~MappedFile()
+{
+    if (_data)
+        UnmapViewOfFile(_data);
+    if (_mapping)
+        CloseHandle(_mapping);
+    CloseHandle(_file);
+}
+
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::string& filename)
+{
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd == -1)
+        error("cannot open input file '{}': {}", filename, strerror(errno));
+
+    struct stat st;
+    if (fstat(fd, &st) == -1)
+    {
+        close(fd);
+        error("cannot stat '{}': {}", filename, strerror(errno));
+    }
+
+    /* The mapping stays valid after the file is closed. */
+
+    _size = st.st_size;
+    if (_size != 0)
+    {
+        void* p = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED)
+        {
+            close(fd);
+            error("cannot map '{}': {}", filename, strerror(errno));
+        }
+        _data = (const uint8_t*)p;
+    }
+    close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+    if (_data)
+        munmap((void*)_data, _size);
+}
+
+#endif
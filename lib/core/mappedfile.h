@@ -0,0 +1,35 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+/* A read-only view of an entire file, mapped into memory rather than read, so
+ * that large files can be indexed without copying them. */
+
+class MappedFile
+{
+public:
+    MappedFile(const std::string& filename);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const uint8_t* data() const
+    {
+        return _data;
+    }
+
+    size_t size() const
+    {
+        return _size;
+    }
+
+private:
+    const uint8_t* _data = nullptr;
+    size_t _size = 0;
+#if defined(_WIN32) || defined(__WIN32__)
+    void* _file;
+    void* _mapping = nullptr;
+#endif
+};
+
+#endif
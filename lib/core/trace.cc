@@ -0,0 +1,219 @@
+#include "lib/core/globals.h"
+#include "lib/core/trace.h"
+#include <chrono>
+#include <fstream>
+#include <thread>
+
+/* Each slot remembers which event it holds, as its index plus one (zero means
+ * empty). A writer claims a slot by swapping this for WRITING, so that if the
+ * ring wraps while a slow writer is still copying its event in, a second
+ * writer to the same slot gives up rather than scribbling over it. */
+
+static constexpr uint64_t WRITING = ~0ULL;
+
+struct Slot
+{
+    std::atomic<uint64_t> sequence = 0;
+    Trace::Event event;
+};
+
+static std::vector<Slot> buffer;
+static std::atomic<uint64_t> nextEvent;
+static std::atomic<unsigned> activeWriters;
+static std::chrono::steady_clock::time_point epoch;
+static std::string traceFilename;
+
+static std::atomic<uint32_t> nextThread = 1;
+static thread_local uint32_t thisThread = nextThread++;
+
+void Trace::enable(size_t capacity)
+{
+    disable();
+    buffer = std::vector<Slot>(std::max<size_t>(capacity, 1));
+    nextEvent = 0;
+    epoch = std::chrono::steady_clock::now();
+    _enabled = true;
+}
+
+void Trace::disable()
+{
+    /* Writers register themselves before checking whether tracing is on, so
+     * once this has seen no writers, no more can start. After this the buffer
+     * can be read (or replaced) safely. */
+
+    _enabled = false;
+    while (activeWriters)
+        std::this_thread::yield();
+}
+
+void Trace::traceTo(const std::string& filename)
+{
+    /* Commands can finish by calling exit() from anywhere, so the trace is
+     * written from an exit handler rather than relying on main() returning.
+     */
+
+    static bool registered = false;
+    if (!registered)
+        std::atexit(finish);
+    registered = true;
+
+    traceFilename = filename;
+    enable();
+}
+
+void Trace::finish()
+{
+    if (traceFilename.empty())
+        return;
+    disable();
+
+    /* This is called on the way out after errors, so it only warns. */
+
+    std::ofstream stream(traceFilename);
+    writeChromeTrace(stream);
+    stream.close();
+    if (stream.fail())
+        warning("cannot write trace file '{}'", traceFilename);
+    if (dropped())
+        warning("trace buffer overflowed; the oldest {} events were lost",
+            dropped());
+    traceFilename.clear();
+}
+
+uint64_t Trace::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - epoch)
+        .count();
+}
+
+void Trace::record(const Event& event)
+{
+    if (!isEnabled())
+        return;
+
+    activeWriters++;
+    if (_enabled)
+    {
+        uint64_t index = nextEvent++;
+        Slot& slot = buffer[index % buffer.size()];
+        uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            /* Someone else is writing this slot, or has already put a newer
+             * event in it; this one is dropped. */
+
+            if ((sequence == WRITING) || (sequence > index))
+                break;
+            if (slot.sequence.compare_exchange_weak(
+                    sequence, WRITING, std::memory_order_acquire))
+            {
+                slot.event = event;
+                slot.event.thread = thisThread;
+                slot.sequence.store(index + 1, std::memory_order_release);
+                break;
+            }
+        }
+    }
+    activeWriters--;
+}
+
+void Trace::counter(const char* name, int64_t value)
+{
+    if (!isEnabled())
+        return;
+
+    Event event = {.type = Event::COUNTER, .name = name, .start = now()};
+    event.numArgs = 1;
+    event.args[0] = {"value", value};
+    record(event);
+}
+
+std::vector<Trace::Event> Trace::events()
+{
+    std::vector<Event> events;
+    uint64_t count = nextEvent;
+    uint64_t first = count - std::min<uint64_t>(count, buffer.size());
+    for (uint64_t i = first; i < count; i++)
+    {
+        const Slot& slot = buffer[i % buffer.size()];
+        if (slot.sequence.load(std::memory_order_acquire) == (i + 1))
+            events.push_back(slot.event);
+    }
+    return events;
+}
+
+uint64_t Trace::dropped()
+{
+    return nextEvent - events().size();
+}
+
+static std::string quoteJson(const char* s)
+{
+    std::string result = "\"";
+    for (; *s; s++)
+    {
+        char c = *s;
+        if ((c == '"') || (c == '\\'))
+            result += fmt::format("\\{}", c);
+        else if ((uint8_t)c < 0x20)
+            result += fmt::format("\\u{:04x}", (int)c);
+        else
+            result += c;
+    }
+    return result + "\"";
+}
+
+void Trace::writeChromeTrace(std::ostream& stream)
+{
+    /* Timestamps in this format are in (fractional) microseconds. */
+
+    stream << "{\"traceEvents\":[\n";
+    bool first = true;
+    for (const auto& event : events())
+    {
+        if (!first)
+            stream << ",\n";
+        first = false;
+
+        stream << fmt::format("{{\"name\":{},\"ph\":\"{}\",\"pid\":1,"
+                              "\"tid\":{},\"ts\":{:.3f}",
+            quoteJson(event.name),
+            (event.type == Event::SPAN) ? 'X' : 'C',
+            event.thread,
+            event.start / 1e3);
+        if (event.type == Event::SPAN)
+            stream << fmt::format(",\"dur\":{:.3f}", event.duration / 1e3);
+        if (event.numArgs)
+        {
+            stream << ",\"args\":{";
+            for (unsigned i = 0; i < event.numArgs; i++)
+                stream << fmt::format("{}{}:{}",
+                    i ? "," : "",
+                    quoteJson(event.args[i].name),
+                    event.args[i].value);
+            stream << "}";
+        }
+        stream << "}";
+    }
+    stream << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+void TraceSpan::begin(const char* name, std::initializer_list<TraceArg> args)
+{
+    _name = name;
+    _numArgs = std::min<size_t>(args.size(), Trace::MAX_ARGS);
+    std::copy_n(args.begin(), _numArgs, _args);
+    _start = Trace::now();
+}
+
+void TraceSpan::end()
+{
+    Trace::Event event = {.type = Trace::Event::SPAN,
+        .name = _name,
+        .start = _start,
+        .duration = Trace::now() - _start,
+        .numArgs = _numArgs};
+    std::copy_n(_args, _numArgs, event.args);
+    Trace::record(event);
+}
@@ -0,0 +1,112 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+
+/* Lightweight tracing of where the time goes. Spans and counters are recorded
+ * into a fixed-size ring buffer, so a long run keeps the most recent events,
+ * and can be written out in the Chrome trace event format for viewing in
+ * Perfetto or chrome://tracing. Tracing is off by default, in which case a
+ * span costs a single relaxed atomic load.
+ *
+ * Names are stored as pointers, so they must be string literals (or otherwise
+ * live forever). */
+
+struct TraceArg
+{
+    const char* name;
+    int64_t value;
+};
+
+class Trace
+{
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 256 * 1024;
+    static constexpr unsigned MAX_ARGS = 2;
+
+    struct Event
+    {
+        enum Type : uint8_t
+        {
+            SPAN,
+            COUNTER,
+        };
+
+        Type type;
+        uint32_t thread;
+        const char* name;
+
+        /* In nanoseconds since tracing was enabled. */
+        uint64_t start;
+        uint64_t duration;
+
+        unsigned numArgs;
+        TraceArg args[MAX_ARGS];
+    };
+
+public:
+    static bool isEnabled()
+    {
+        return _enabled.load(std::memory_order_relaxed);
+    }
+
+    /* Starts tracing, throwing away anything recorded so far. */
+    static void enable(size_t capacity = DEFAULT_CAPACITY);
+    static void disable();
+
+    /* Starts tracing, and arranges for finish() to write the trace to a
+     * file. finish() is also run automatically when the program exits. */
+    static void traceTo(const std::string& filename);
+
+    /* Writes the trace file, if one was asked for. */
+    static void finish();
+
+    static void counter(const char* name, int64_t value);
+    static void record(const Event& event);
+
+    /* Nanoseconds since tracing was enabled. */
+    static uint64_t now();
+
+    /* The surviving events, oldest first, and how many were overwritten or
+     * lost. Only call these once tracing has been disabled. */
+    static std::vector<Event> events();
+    static uint64_t dropped();
+
+    static void writeChromeTrace(std::ostream& stream);
+
+private:
+    static inline std::atomic<bool> _enabled = false;
+};
+
+/* Records the time between construction and destruction as a span. */
+
+class TraceSpan
+{
+public:
+    TraceSpan(const char* name, std::initializer_list<TraceArg> args = {})
+    {
+        if (Trace::isEnabled())
+            begin(name, args);
+    }
+
+    ~TraceSpan()
+    {
+        if (_name)
+            end();
+    }
+
+private:
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+    void begin(const char* name, std::initializer_list<TraceArg> args);
+    void end();
+
+private:
+    const char* _name = nullptr;
+    uint64_t _start;
+    unsigned _numArgs;
+    TraceArg _args[Trace::MAX_ARGS];
+};
+
+#endif
@@ -6,6 +6,9 @@
 #include <fstream>
 #include <sys/time.h>
 #include <stdarg.h>
+#include <thread>
+#include <atomic>
+#include <mutex>
 
 bool emergencyStop = false;
 
@@ -126,6 +129,49 @@ void testForEmergencyStop()
         throw EmergencyStopException();
 }
 
+void parallelFor(unsigned count,
+    unsigned threads,
+    const std::function<void(unsigned)>& fn)
+{
+    std::atomic<unsigned> next = 0;
+    std::mutex failureMutex;
+    std::exception_ptr failure;
+    auto worker = [&]
+    {
+        for (;;)
+        {
+            unsigned i = next++;
+            if (i >= count)
+                return;
+
+            try
+            {
+                fn(i);
+            }
+            catch (...)
+            {
+                std::scoped_lock lock(failureMutex);
+                if (!failure)
+                    failure = std::current_exception();
+                next = count;
+            }
+        }
+    };
+
+    if (!threads)
+        threads = std::max(1U, std::thread::hardware_concurrency());
+    threads = std::min(threads, count);
+
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < threads; i++)
+        pool.emplace_back(worker);
+    worker();
+    for (auto& t : pool)
+        t.join();
+    if (failure)
+        std::rethrow_exception(failure);
+}
+
 std::string toIso8601(time_t t)
 {
     auto* tm = std::gmtime(&t);
@@ -23,6 +23,15 @@ extern int countSetBits(uint32_t word);
 extern uint32_t unbcd(uint32_t bcd);
 extern int findLowestSetBit(uint64_t value);
 
+/* Calls fn(i) for every i from 0 to count-1, spread across up to the given
+ * number of threads (zero means one per core); the calling thread does some
+ * of the work too. If any call throws, the remaining ones are skipped and
+ * the first exception is rethrown once every thread has finished. */
+
+extern void parallelFor(unsigned count,
+    unsigned threads,
+    const std::function<void(unsigned)>& fn);
+
 extern void fillBitmapTo(std::vector<bool>& bitmap,
     unsigned& cursor,
     unsigned terminateAt,
@@ -4,23 +4,33 @@ cxxlibrary(
     name="data",
     srcs=[
         "./disk.cc",
+        "./fluxhistogram.cc",
         "./fluxmap.cc",
         "./fluxmapreader.cc",
         "./fluxpattern.cc",
+        "./fluxpyramid.cc",
+        "./fluxscan.cc",
         "./image.cc",
         "./layout.cc",
         "./locations.cc",
         "./sector.cc",
+        "./sectorcollector.cc",
+        "./sectorgrid.cc",
     ],
     hdrs={
         "lib/data/disk.h": "./disk.h",
+        "lib/data/fluxhistogram.h": "./fluxhistogram.h",
         "lib/data/fluxmap.h": "./fluxmap.h",
         "lib/data/sector.h": "./sector.h",
+        "lib/data/sectorcollector.h": "./sectorcollector.h",
+        "lib/data/sectorgrid.h": "./sectorgrid.h",
         "lib/data/layout.h": "./layout.h",
         "lib/data/locations.h": "./locations.h",
         "lib/data/image.h": "./image.h",
         "lib/data/fluxmapreader.h": "./fluxmapreader.h",
         "lib/data/fluxpattern.h": "./fluxpattern.h",
+        "lib/data/fluxpyramid.h": "./fluxpyramid.h",
+        "lib/data/fluxscan.h": "./fluxscan.h",
     },
     deps=["lib/core", "lib/config", "+protocol", "dep+lexy_lib"],
 )
@@ -0,0 +1,366 @@
+#include "lib/core/globals.h"
+#include "lib/data/fluxmap.h"
+#include "lib/data/fluxhistogram.h"
+#include "protocol.h"
+#include <algorithm>
+#include <thread>
+#include <span>
+#include <math.h>
+
+/* Consecutive pulses very often land in the same bucket, which makes the
+ * increments depend on each other; spreading them over several
+ * sub-histograms lets them overlap. */
+static constexpr unsigned LANES = 4;
+
+/* Don't bother with threads for less than this much bytecode. */
+static constexpr size_t MIN_BYTES_PER_THREAD = 256 * 1024;
+
+/* Granularity used to find the start of a window without scanning from the
+ * beginning of the fluxmap. */
+static constexpr size_t INDEX_CHUNK_SIZE = 16 * 1024;
+
+static constexpr uint64_t FOREVER = UINT64_MAX;
+
+namespace
+{
+    /* A piece of bytecode which starts just after a pulse (or at the
+     * beginning of the data), and the time at which it starts. */
+
+    struct Chunk
+    {
+        const uint8_t* start;
+        const uint8_t* end;
+        uint64_t startTicks;
+    };
+
+    struct TickWindow
+    {
+        uint64_t start = 0;
+        uint64_t end = FOREVER;
+    };
+}
+
+static TickWindow toTicks(const FluxHistogram::Window& window)
+{
+    TickWindow tw;
+    if (window.start > 0)
+        tw.start = ceil(window.start / NS_PER_TICK);
+    if (window.end < 0)
+        tw.end = 0;
+    else if (std::isfinite(window.end))
+        tw.end = ceil(window.end / NS_PER_TICK);
+    return tw;
+}
+
+static unsigned threadsFor(size_t bytes)
+{
+    unsigned threads = std::max(1U, std::thread::hardware_concurrency());
+    return std::clamp<size_t>(bytes / MIN_BYTES_PER_THREAD, 1, threads);
+}
+
+/* Splits the bytecode into pieces of roughly chunkSize bytes, each of which
+ * ends with a pulse (apart from the last). If calculateTicks is set then the
+ * start time of each chunk is also filled in. */
+
+static std::vector<Chunk> splitIntoChunks(const uint8_t* ptr,
+    size_t len,
+    uint64_t startTicks,
+    size_t chunkSize,
+    bool calculateTicks)
+{
+    std::vector<Chunk> chunks;
+    const uint8_t* end = ptr + len;
+    while (ptr != end)
+    {
+        const uint8_t* p = ptr + std::min(chunkSize, (size_t)(end - ptr));
+        while ((p != end) && !(p[-1] & F_BIT_PULSE))
+            p++;
+
+        chunks.push_back(Chunk{ptr, p, startTicks});
+        if (calculateTicks)
+        {
+            uint64_t ticks = 0;
+            for (const uint8_t* q = ptr; q != p; q++)
+                ticks += *q & 0x3f;
+            startTicks += ticks;
+        }
+        ptr = p;
+    }
+    return chunks;
+}
+
+template <bool WINDOWED>
+static uint64_t countIntervals(const uint8_t* ptr,
+    const uint8_t* end,
+    uint64_t now,
+    const TickWindow& window,
+    uint32_t* lanes,
+    unsigned numBuckets)
+{
+    uint64_t intervals = 0;
+    unsigned lane = 0;
+    uint32_t interval = 0;
+    while (ptr != end)
+    {
+        uint8_t b = *ptr++;
+        interval += b & 0x3f;
+        if (b & F_BIT_PULSE)
+        {
+            /* now is the time at which this interval started. */
+
+            if (!WINDOWED || (now >= window.start))
+            {
+                if (interval < numBuckets)
+                    lanes[lane * numBuckets + interval]++;
+                lane = (lane + 1) % LANES;
+                intervals++;
+            }
+
+            if (WINDOWED)
+            {
+                now += interval;
+                if (now >= window.end)
+                    break;
+            }
+            interval = 0;
+        }
+    }
+    return intervals;
+}
+
+/* Counts the intervals in a consecutive run of chunks, spread across as many
+ * threads as seem worthwhile, and adds them to the histogram. */
+
+static uint64_t countChunks(std::span<const Chunk> chunks,
+    const TickWindow& window,
+    bool windowed,
+    std::vector<uint32_t>& buckets)
+{
+    if (chunks.empty())
+        return 0;
+
+    unsigned numBuckets = buckets.size();
+    size_t bytes = chunks.back().end - chunks.front().start;
+    unsigned threads = std::min<size_t>(threadsFor(bytes), chunks.size());
+
+    std::vector<std::vector<uint32_t>> lanes(
+        threads, std::vector<uint32_t>(LANES * numBuckets));
+    std::vector<uint64_t> intervals(threads);
+    auto worker = [&](unsigned thread)
+    {
+        const Chunk& first = chunks[thread * chunks.size() / threads];
+        const Chunk& last = chunks[(thread + 1) * chunks.size() / threads - 1];
+        intervals[thread] = windowed
+                                ? countIntervals<true>(first.start,
+                                      last.end,
+                                      first.startTicks,
+                                      window,
+                                      &lanes[thread][0],
+                                      numBuckets)
+                                : countIntervals<false>(first.start,
+                                      last.end,
+                                      first.startTicks,
+                                      window,
+                                      &lanes[thread][0],
+                                      numBuckets);
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned thread = 1; thread < threads; thread++)
+        pool.emplace_back(worker, thread);
+    worker(0);
+    for (auto& t : pool)
+        t.join();
+
+    uint64_t total = 0;
+    for (unsigned thread = 0; thread < threads; thread++)
+    {
+        for (unsigned lane = 0; lane < LANES; lane++)
+            for (unsigned i = 0; i < numBuckets; i++)
+                buckets[i] += lanes[thread][lane * numBuckets + i];
+        total += intervals[thread];
+    }
+    return total;
+}
+
+/* Counts a window using a precomputed chunk index, only looking at the chunks
+ * which can contain intervals starting inside the window. */
+
+static uint64_t countWindow(const std::vector<Chunk>& chunks,
+    const TickWindow& window,
+    std::vector<uint32_t>& buckets)
+{
+    auto first = std::ranges::upper_bound(
+        chunks, window.start, {}, &Chunk::startTicks);
+    if (first != chunks.begin())
+        first--;
+    auto last =
+        std::ranges::lower_bound(chunks, window.end, {}, &Chunk::startTicks);
+    if (first >= last)
+        return 0;
+
+    return countChunks(
+        std::span<const Chunk>(first, last), window, true, buckets);
+}
+
+FluxHistogram::FluxHistogram(unsigned buckets): _buckets(buckets) {}
+
+FluxHistogram::FluxHistogram(const Fluxmap& fluxmap, unsigned buckets):
+    _buckets(buckets)
+{
+    add(fluxmap);
+}
+
+FluxHistogram::FluxHistogram(
+    const Fluxmap& fluxmap, const Window& window, unsigned buckets):
+    _buckets(buckets)
+{
+    add(fluxmap, window);
+}
+
+void FluxHistogram::add(
+    const uint8_t* ptr, size_t len, const Window& window, uint64_t startTicks)
+{
+    if (!len)
+        return;
+
+    TickWindow tw = toTicks(window);
+    if ((tw.start <= startTicks) && (tw.end == FOREVER))
+    {
+        /* Everything is wanted, so there's no need to track time. */
+
+        auto chunks = splitIntoChunks(
+            ptr, len, startTicks, len / threadsFor(len) + 1, false);
+        _intervals += countChunks(chunks, tw, false, _buckets);
+    }
+    else
+    {
+        auto chunks =
+            splitIntoChunks(ptr, len, startTicks, INDEX_CHUNK_SIZE, true);
+        _intervals += countWindow(chunks, tw, _buckets);
+    }
+}
+
+std::vector<FluxHistogram> FluxHistogram::perWindow(const Fluxmap& fluxmap,
+    const std::vector<Window>& windows,
+    unsigned buckets)
+{
+    auto chunks = splitIntoChunks(
+        fluxmap.ptr(), fluxmap.bytes(), 0, INDEX_CHUNK_SIZE, true);
+
+    std::vector<FluxHistogram> results;
+    for (const auto& window : windows)
+    {
+        FluxHistogram& h = results.emplace_back(buckets);
+        h._intervals = countWindow(chunks, toTicks(window), h._buckets);
+    }
+    return results;
+}
+
+std::vector<FluxHistogram> FluxHistogram::perRevolution(
+    const Fluxmap& fluxmap, unsigned buckets)
+{
+    std::vector<Window> windows;
+    Window window;
+    for (nanoseconds_t mark : fluxmap.getIndexMarks())
+    {
+        window.end = mark;
+        windows.push_back(window);
+        window.start = mark;
+    }
+    window.end = std::numeric_limits<nanoseconds_t>::infinity();
+    windows.push_back(window);
+
+    return perWindow(fluxmap, windows, buckets);
+}
+
+FluxHistogram& FluxHistogram::operator+=(const FluxHistogram& other)
+{
+    if (other._buckets.size() > _buckets.size())
+        _buckets.resize(other._buckets.size());
+    for (unsigned i = 0; i < other._buckets.size(); i++)
+        _buckets[i] += other._buckets[i];
+    _intervals += other._intervals;
+    return *this;
+}
+
+uint32_t FluxHistogram::max() const
+{
+    if (_buckets.empty())
+        return 0;
+    return *std::max_element(_buckets.begin(), _buckets.end());
+}
+
+FluxHistogram::ClockData FluxHistogram::guessClock(
+    double noiseFloorFactor, double signalLevelFactor) const
+{
+    ClockData data = {};
+    std::copy_n(_buckets.begin(),
+        std::min<size_t>(_buckets.size(), std::size(data.buckets)),
+        std::begin(data.buckets));
+
+    uint32_t max =
+        *std::max_element(std::begin(data.buckets), std::end(data.buckets));
+    uint32_t min =
+        *std::min_element(std::begin(data.buckets), std::end(data.buckets));
+    data.noiseFloor = min + (max - min) * noiseFloorFactor;
+    data.signalLevel = min + (max - min) * signalLevelFactor;
+
+    /* Find a point solidly within the first pulse. */
+
+    int pulseindex = 0;
+    while (pulseindex < 256)
+    {
+        if (data.buckets[pulseindex] > data.signalLevel)
+            break;
+        pulseindex++;
+    }
+    if (pulseindex == 256)
+        return data;
+
+    /* Find the upper and lower bounds of the pulse. */
+
+    int peaklo = pulseindex;
+    while (peaklo > 0)
+    {
+        if (data.buckets[peaklo] < data.noiseFloor)
+            break;
+        peaklo--;
+    }
+
+    int peakhi = pulseindex;
+    while (peakhi < 255)
+    {
+        if (data.buckets[peakhi] < data.noiseFloor)
+            break;
+        peakhi++;
+    }
+
+    /* Find the total accumulated size of the pulse. */
+
+    uint32_t total_size = 0;
+    for (int i = peaklo; i < peakhi; i++)
+        total_size += data.buckets[i];
+
+    /* Now find the median. */
+
+    uint32_t count = 0;
+    int median = peaklo;
+    while (median < peakhi)
+    {
+        count += data.buckets[median];
+        if (count > (total_size / 2))
+            break;
+        median++;
+    }
+
+    /*
+     * Okay, the median should now be a good candidate for the (or a) clock.
+     * How this maps onto the actual clock rate depends on the encoding.
+     */
+
+    data.peakStart = peaklo * NS_PER_TICK;
+    data.peakEnd = peakhi * NS_PER_TICK;
+    data.median = median * NS_PER_TICK;
+    return data;
+}
@@ -0,0 +1,117 @@
+#ifndef FLUXHISTOGRAM_H
+#define FLUXHISTOGRAM_H
+
+#include "lib/data/fluxmap.h"
+
+/* A histogram of the intervals between pulses in a Fluxmap, in ticks. The scan
+ * is done directly over the bytecode; large fluxmaps are split into chunks
+ * (each starting just after a pulse, so no interval is broken) which are
+ * counted in parallel and then merged. */
+
+class FluxHistogram
+{
+public:
+    static constexpr unsigned DEFAULT_BUCKETS = 256;
+
+    /* A window of time within a fluxmap. Only intervals which start inside the
+     * window are counted. */
+
+    struct Window
+    {
+        nanoseconds_t start = 0;
+        nanoseconds_t end = std::numeric_limits<nanoseconds_t>::infinity();
+    };
+
+    struct ClockData
+    {
+        nanoseconds_t median;
+        uint32_t noiseFloor;
+        uint32_t signalLevel;
+        nanoseconds_t peakStart;
+        nanoseconds_t peakEnd;
+        uint32_t buckets[256];
+    };
+
+public:
+    FluxHistogram(unsigned buckets = DEFAULT_BUCKETS);
+    FluxHistogram(const Fluxmap& fluxmap, unsigned buckets = DEFAULT_BUCKETS);
+    FluxHistogram(const Fluxmap& fluxmap,
+        const Window& window,
+        unsigned buckets = DEFAULT_BUCKETS);
+
+    /* Returns one histogram for each span of the fluxmap delimited by index
+     * marks (including any partial revolutions at either end). */
+
+    static std::vector<FluxHistogram> perRevolution(
+        const Fluxmap& fluxmap, unsigned buckets = DEFAULT_BUCKETS);
+
+    /* Returns one histogram for each of the supplied windows. */
+
+    static std::vector<FluxHistogram> perWindow(const Fluxmap& fluxmap,
+        const std::vector<Window>& windows,
+        unsigned buckets = DEFAULT_BUCKETS);
+
+public:
+    /* Adds the intervals from raw bytecode. The first interval is measured
+     * from the start of the data, so this should start just after a pulse (or
+     * at the beginning of the fluxmap). startTicks is the time of the first
+     * byte, used when applying the window. */
+
+    void add(const uint8_t* ptr,
+        size_t len,
+        const Window& window,
+        uint64_t startTicks = 0);
+
+    void add(const uint8_t* ptr, size_t len)
+    {
+        add(ptr, len, Window());
+    }
+
+    void add(const Fluxmap& fluxmap, const Window& window)
+    {
+        add(fluxmap.ptr(), fluxmap.bytes(), window);
+    }
+
+    void add(const Fluxmap& fluxmap)
+    {
+        add(fluxmap, Window());
+    }
+
+    FluxHistogram& operator+=(const FluxHistogram& other);
+
+    unsigned size() const
+    {
+        return _buckets.size();
+    }
+
+    uint32_t operator[](unsigned interval) const
+    {
+        return _buckets[interval];
+    }
+
+    const std::vector<uint32_t>& buckets() const
+    {
+        return _buckets;
+    }
+
+    /* Number of intervals counted, including the ones too long to fit in any
+     * bucket. */
+
+    uint64_t intervals() const
+    {
+        return _intervals;
+    }
+
+    uint32_t max() const;
+
+    /* Tries to guess the clock by finding the smallest common interval. */
+
+    ClockData guessClock(double noiseFloorFactor = 0.01,
+        double signalLevelFactor = 0.05) const;
+
+private:
+    std::vector<uint32_t> _buckets;
+    uint64_t _intervals = 0;
+};
+
+#endif
@@ -1,8 +1,14 @@
 #include "lib/core/globals.h"
 #include "lib/data/fluxmap.h"
 #include "lib/data/fluxmapreader.h"
+#include "lib/data/fluxscan.h"
 #include "protocol.h"
 #include <mutex>
+#include <atomic>
+
+/* Memory used by, and available to, the interval views of all fluxmaps. */
+static std::atomic<size_t> intervalsUsed = 0;
+static std::atomic<size_t> intervalsBudget = 256 * 1024 * 1024;
 
 Fluxmap& Fluxmap::appendBytes(const Bytes& bytes)
 {
@@ -14,7 +20,7 @@ Fluxmap& Fluxmap::appendBytes(const Bytes& bytes)
 
 Fluxmap& Fluxmap::appendBytes(const uint8_t* ptr, size_t len)
 {
-    flushIndexMarks();
+    flushCaches();
 
     ByteWriter bw(_bytes);
     bw.seekToEnd();
@@ -50,13 +56,14 @@ Fluxmap& Fluxmap::appendInterval(uint32_t ticks)
 
 Fluxmap& Fluxmap::appendPulse()
 {
+    flushCaches();
     findLastByte() |= 0x80;
     return *this;
 }
 
 Fluxmap& Fluxmap::appendIndex()
 {
-    flushIndexMarks();
+    flushCaches();
     findLastByte() |= 0x40;
     return *this;
 }
@@ -87,16 +94,22 @@ const std::vector<nanoseconds_t>& Fluxmap::getIndexMarks() const
     if (!_indexMarks.has_value())
     {
         _indexMarks = std::make_optional<std::vector<nanoseconds_t>>();
-        FluxmapReader fmr(*this);
+
+        /* This can't use a FluxmapReader, as that would want the lock. */
+
+        const uint8_t* p = ptr();
+        const uint8_t* end = p + _bytes.size();
+        unsigned ticks = 0;
         nanoseconds_t oldt = -1;
         for (;;)
         {
-            unsigned ticks;
-            if (!fmr.findEvent(F_BIT_INDEX, ticks))
+            p = scanFlux(p, end, F_BIT_INDEX, false, ticks);
+            if (p == end)
                 break;
+            ticks += *p++ & 0x3f;
 
             /* Debounce. */
-            nanoseconds_t t = fmr.tell().ns();
+            nanoseconds_t t = ticks * NS_PER_TICK;
             if (t != oldt)
                 _indexMarks->push_back(t);
             oldt = t;
@@ -105,8 +118,83 @@ const std::vector<nanoseconds_t>& Fluxmap::getIndexMarks() const
     return *_indexMarks;
 }
 
-void Fluxmap::flushIndexMarks()
+size_t Fluxmap::Intervals::memoryUsed() const
+{
+    return (intervals.capacity() + byteOffsets.capacity() +
+               indexes.capacity()) *
+           sizeof(uint32_t);
+}
+
+std::shared_ptr<const Fluxmap::Intervals> Fluxmap::getIntervals() const
+{
+    std::scoped_lock lock(_mutationMutex);
+    if (_intervals)
+        return _intervals;
+
+    /* Reserve the worst case (every byte a pulse) before building anything;
+     * the excess is given back afterwards. */
+
+    size_t reserved = _bytes.size() * 2 * sizeof(uint32_t);
+    size_t used = intervalsUsed;
+    do
+    {
+        if ((used + reserved) > intervalsBudget)
+            return nullptr;
+    } while (!intervalsUsed.compare_exchange_weak(used, used + reserved));
+
+    auto intervals = new Intervals();
+    intervals->bytes = _bytes.size();
+    intervals->intervals.reserve(_bytes.size());
+    intervals->byteOffsets.reserve(_bytes.size());
+
+    const uint8_t* start = ptr();
+    const uint8_t* end = start + _bytes.size();
+    const uint8_t* p = start;
+    unsigned ticks = 0;
+    unsigned total = 0;
+    while (p != end)
+    {
+        p = scanFlux(p, end, F_BIT_PULSE | F_BIT_INDEX, false, ticks);
+        if (p == end)
+            break;
+
+        uint8_t b = *p++;
+        ticks += b & 0x3f;
+        if (b & F_BIT_INDEX)
+            intervals->indexes.push_back(intervals->intervals.size());
+        if (b & F_BIT_PULSE)
+        {
+            intervals->intervals.push_back(ticks);
+            intervals->byteOffsets.push_back(p - start);
+            total += ticks;
+            ticks = 0;
+        }
+    }
+    intervals->ticks = total + ticks;
+
+    intervals->intervals.shrink_to_fit();
+    intervals->byteOffsets.shrink_to_fit();
+    intervals->indexes.shrink_to_fit();
+    size_t size = intervals->memoryUsed();
+    intervalsUsed -= reserved - size;
+
+    _intervals = std::shared_ptr<const Intervals>(intervals,
+        [=](const Intervals* view)
+        {
+            intervalsUsed -= size;
+            delete view;
+        });
+    return _intervals;
+}
+
+void Fluxmap::setIntervalsBudget(size_t bytes)
+{
+    intervalsBudget = bytes;
+}
+
+void Fluxmap::flushCaches()
 {
     std::scoped_lock lock(_mutationMutex);
     _indexMarks = {};
+    _intervals = nullptr;
 }
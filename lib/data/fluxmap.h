@@ -28,6 +28,28 @@ public:
         }
     };
 
+    /* A decoded view of the flux, so that the bytecode doesn't need parsing
+     * again every time the same fluxmap is read. */
+
+    struct Intervals
+    {
+        /* Ticks from the previous pulse (or the start) to each pulse. */
+        std::vector<uint32_t> intervals;
+
+        /* The byte offset just after each pulse (i.e. Position::bytes). */
+        std::vector<uint32_t> byteOffsets;
+
+        /* For each index mark, the number of the pulse it comes before (or is
+         * on). */
+        std::vector<uint32_t> indexes;
+
+        /* The size of the bytecode this was made from, and its duration. */
+        size_t bytes = 0;
+        unsigned ticks = 0;
+
+        size_t memoryUsed() const;
+    };
+
 public:
     Fluxmap() {}
 
@@ -85,9 +107,19 @@ public:
     std::vector<std::unique_ptr<const Fluxmap>> split() const;
     const std::vector<nanoseconds_t>& getIndexMarks() const;
 
+    /* Returns the decoded view of the flux, building it the first time. This
+     * returns null if building it would go over the memory budget shared by
+     * all fluxmaps. */
+
+    std::shared_ptr<const Intervals> getIntervals() const;
+
+    /* Sets the total memory the views of all fluxmaps may use. */
+
+    static void setIntervalsBudget(size_t bytes);
+
 private:
     uint8_t& findLastByte();
-    void flushIndexMarks();
+    void flushCaches();
 
 private:
     nanoseconds_t _duration = 0;
@@ -95,6 +127,7 @@ private:
     Bytes _bytes;
     mutable std::mutex _mutationMutex;
     mutable std::optional<std::vector<nanoseconds_t>> _indexMarks;
+    mutable std::shared_ptr<const Intervals> _intervals;
 };
 
 #endif
@@ -3,39 +3,59 @@
 #include "lib/data/fluxmap.h"
 #include "lib/data/fluxmapreader.h"
 #include "lib/data/fluxpattern.h"
+#include "lib/data/fluxscan.h"
 #include "lib/config/proto.h"
 #include "protocol.h"
 #include <numeric>
+#include <algorithm>
 #include <math.h>
 #include <strings.h>
 
 FluxmapReader::FluxmapReader(const Fluxmap& fluxmap):
+    FluxmapReader(fluxmap, globalConfig()->decoder())
+{
+}
+
+FluxmapReader::FluxmapReader(
+    const Fluxmap& fluxmap, const DecoderProto& config):
     _fluxmap(fluxmap),
     _bytes(fluxmap.ptr()),
     _size(fluxmap.bytes()),
-    _config(globalConfig()->decoder())
+    _config(config),
+    _intervals(fluxmap.getIntervals())
 {
+    if (_intervals && (_intervals->bytes != _size))
+        _intervals = nullptr;
     rewind();
 }
 
-void FluxmapReader::getNextEvent(int& event, unsigned& ticks)
+/* Moves to just after the next byte which stopMask (and stopOnZero) say is
+ * interesting, returning it, or returns -1 at the end of the data. ticks is
+ * set to the time taken to get there. */
+
+int FluxmapReader::advanceTo(
+    uint8_t stopMask, bool stopOnZero, unsigned& ticks)
 {
     ticks = 0;
+    const uint8_t* end = _bytes + _size;
+    const uint8_t* p =
+        scanFlux(_bytes + _pos.bytes, end, stopMask, stopOnZero, ticks);
 
-    while (!eof())
+    int b = -1;
+    if (p != end)
     {
-        uint8_t b = _bytes[_pos.bytes++];
+        b = *p++;
         ticks += b & 0x3f;
-        if (!b || (b & (F_BIT_PULSE | F_BIT_INDEX)))
-        {
-            _pos.ticks += ticks;
-            event = b & 0xc0;
-            return;
-        }
     }
-
+    _pos.bytes = p - _bytes;
     _pos.ticks += ticks;
-    event = F_EOF;
+    return b;
+}
+
+void FluxmapReader::getNextEvent(int& event, unsigned& ticks)
+{
+    int b = advanceTo(F_BIT_PULSE | F_BIT_INDEX, true, ticks);
+    event = (b == -1) ? F_EOF : (b & 0xc0);
 }
 
 void FluxmapReader::skipToEvent(int event)
@@ -51,31 +71,65 @@ int FluxmapReader::getCurrentEvent()
     return _bytes[_pos.bytes] & 0xc0;
 }
 
-bool FluxmapReader::findEvent(int event, unsigned& ticks)
-{
-    ticks = 0;
+/* Returns true if the position is just after a pulse (or at the start), so
+ * that the interval view can be used from here. */
 
-    while (!eof())
+bool FluxmapReader::atPulse()
+{
+    const auto& offsets = _intervals->byteOffsets;
+    if (_pos.bytes != _pulseBytes)
     {
-        unsigned thisTicks;
-        int thisEvent;
-        getNextEvent(thisEvent, thisTicks);
-        ticks += thisTicks;
+        _pulse = std::upper_bound(offsets.begin(), offsets.end(), _pos.bytes) -
+                 offsets.begin();
+        _pulseBytes = _pos.bytes;
+    }
+    return _pulse ? (offsets[_pulse - 1] == _pos.bytes) : (_pos.bytes == 0);
+}
 
-        if (thisEvent == F_EOF)
-            return false;
+/* findEvent(F_BIT_PULSE) using the interval view. */
 
-        if ((event == thisEvent) || (event & thisEvent))
-            return true;
+bool FluxmapReader::nextPulse(unsigned& ticks)
+{
+    const auto& intervals = *_intervals;
+    if (_pulse == intervals.intervals.size())
+    {
+        ticks = intervals.ticks - _pos.ticks;
+        _pos.ticks = intervals.ticks;
+        _pos.bytes = _pulseBytes = _size;
+        return false;
     }
 
-    return false;
+    ticks = intervals.intervals[_pulse];
+    _pos.ticks += ticks;
+    _pos.bytes = _pulseBytes = intervals.byteOffsets[_pulse++];
+    return true;
+}
+
+bool FluxmapReader::findEvent(int event, unsigned& ticks)
+{
+    if ((event == F_BIT_PULSE) && _intervals && atPulse())
+        return nextPulse(ticks);
+
+    /* This stops at the same place as calling getNextEvent() until it returns
+     * a matching event would, but skips the others in bulk. */
+
+    return advanceTo(
+               event & (F_BIT_PULSE | F_BIT_INDEX), event == F_DESYNC, ticks) !=
+           -1;
+}
+
+unsigned FluxmapReader::debounceThresholdTicks(nanoseconds_t clock) const
+{
+    return (clock * _config.pulse_debounce_threshold()) / NS_PER_TICK;
 }
 
 unsigned FluxmapReader::readInterval(nanoseconds_t clock)
 {
-    unsigned thresholdTicks =
-        (clock * _config.pulse_debounce_threshold()) / NS_PER_TICK;
+    return readIntervalWithThreshold(debounceThresholdTicks(clock));
+}
+
+unsigned FluxmapReader::readIntervalWithThreshold(unsigned thresholdTicks)
+{
     unsigned ticks = 0;
 
     while (ticks <= thresholdTicks)
@@ -145,7 +199,8 @@ nanoseconds_t FluxmapReader::seekToPattern(
     while (!eof())
     {
         FluxMatch match;
-        if (pattern.matches(&*candidates.end(), match))
+        if (pattern.matches(
+                &*candidates.end(), match, _config.bit_error_threshold()))
         {
             seek(positions[intervalCount - match.intervals]);
             _pos.zeroes = match.zeroes;
@@ -173,87 +228,3 @@ void FluxmapReader::seekToIndexMark()
     skipToEvent(F_BIT_INDEX);
     _pos.zeroes = 0;
 }
-
-/*
- * Tries to guess the clock by finding the smallest common interval.
- * Returns nanoseconds.
- */
-FluxmapReader::ClockData FluxmapReader::guessClock(
-    double noiseFloorFactor, double signalLevelFactor)
-{
-    ClockData data = {};
-
-    while (!eof())
-    {
-        unsigned interval;
-        findEvent(F_BIT_PULSE, interval);
-        if (interval > 0xff)
-            continue;
-        data.buckets[interval]++;
-    }
-
-    uint32_t max =
-        *std::max_element(std::begin(data.buckets), std::end(data.buckets));
-    uint32_t min =
-        *std::min_element(std::begin(data.buckets), std::end(data.buckets));
-    data.noiseFloor = min + (max - min) * noiseFloorFactor;
-    data.signalLevel = min + (max - min) * signalLevelFactor;
-
-    /* Find a point solidly within the first pulse. */
-
-    int pulseindex = 0;
-    while (pulseindex < 256)
-    {
-        if (data.buckets[pulseindex] > data.signalLevel)
-            break;
-        pulseindex++;
-    }
-    if (pulseindex == -1)
-        return data;
-
-    /* Find the upper and lower bounds of the pulse. */
-
-    int peaklo = pulseindex;
-    while (peaklo > 0)
-    {
-        if (data.buckets[peaklo] < data.noiseFloor)
-            break;
-        peaklo--;
-    }
-
-    int peakhi = pulseindex;
-    while (peakhi < 255)
-    {
-        if (data.buckets[peakhi] < data.noiseFloor)
-            break;
-        peakhi++;
-    }
-
-    /* Find the total accumulated size of the pulse. */
-
-    uint32_t total_size = 0;
-    for (int i = peaklo; i < peakhi; i++)
-        total_size += data.buckets[i];
-
-    /* Now find the median. */
-
-    uint32_t count = 0;
-    int median = peaklo;
-    while (median < peakhi)
-    {
-        count += data.buckets[median];
-        if (count > (total_size / 2))
-            break;
-        median++;
-    }
-
-    /*
-     * Okay, the median should now be a good candidate for the (or a) clock.
-     * How this maps onto the actual clock rate depends on the encoding.
-     */
-
-    data.peakStart = peaklo * NS_PER_TICK;
-    data.peakEnd = peakhi * NS_PER_TICK;
-    data.median = median * NS_PER_TICK;
-    return data;
-}
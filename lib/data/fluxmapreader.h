@@ -12,6 +12,7 @@ class FluxmapReader
 {
 public:
     FluxmapReader(const Fluxmap& fluxmap);
+    FluxmapReader(const Fluxmap& fluxmap, const DecoderProto& config);
     FluxmapReader(const Fluxmap&& fluxmap) = delete;
 
     void rewind()
@@ -48,6 +49,11 @@ public:
     bool findEvent(int event, unsigned& ticks);
     unsigned readInterval(nanoseconds_t clock); /* with debounce support */
 
+    /* The same, but with the debounce threshold (from
+     * debounceThresholdTicks()) worked out in advance. */
+    unsigned readIntervalWithThreshold(unsigned thresholdTicks);
+    unsigned debounceThresholdTicks(nanoseconds_t clock) const;
+
     /* Important! You can only reliably seek to 1 bits. */
     void seek(nanoseconds_t ns);
     void seekToByte(unsigned byte);
@@ -57,18 +63,10 @@ public:
     nanoseconds_t seekToPattern(
         const FluxMatcher& pattern, const FluxMatcher*& matching);
 
-    struct ClockData
-    {
-        nanoseconds_t median;
-        uint32_t noiseFloor;
-        uint32_t signalLevel;
-        nanoseconds_t peakStart;
-        nanoseconds_t peakEnd;
-        uint32_t buckets[256];
-    };
-
-    ClockData guessClock(
-        double noiseFloorFactor = 0.01, double signalLevelFactor = 0.05);
+private:
+    int advanceTo(uint8_t stopMask, bool stopOnZero, unsigned& ticks);
+    bool atPulse();
+    bool nextPulse(unsigned& ticks);
 
 private:
     const Fluxmap& _fluxmap;
@@ -76,6 +74,12 @@ private:
     const size_t _size;
     Fluxmap::Position _pos;
     const DecoderProto& _config;
+
+    /* The fluxmap's interval view, if it has one, and the number of the next
+     * pulse as of when the position was _pulseBytes. */
+    std::shared_ptr<const Fluxmap::Intervals> _intervals;
+    unsigned _pulse = 0;
+    unsigned _pulseBytes = 0;
 };
 
 #endif
@@ -45,10 +45,16 @@ FluxPattern::FluxPattern(unsigned bits, uint64_t pattern): _bits(bits)
     }
 }
 
-bool FluxPattern::matches(const unsigned* end, FluxMatch& match) const
+bool FluxMatcher::matches(const unsigned* intervals, FluxMatch& match) const
 {
-    const double clockDecodeThreshold =
-        globalConfig()->decoder().bit_error_threshold();
+    return matches(
+        intervals, match, globalConfig()->decoder().bit_error_threshold());
+}
+
+bool FluxPattern::matches(
+    const unsigned* end, FluxMatch& match, double bitErrorThreshold) const
+{
+    const double clockDecodeThreshold = bitErrorThreshold;
     const unsigned* start = end - _intervals.size();
     unsigned candidatelength = std::accumulate(start, end - _lowzero, 0);
     if (!candidatelength)
@@ -89,11 +95,13 @@ FluxMatchers::FluxMatchers(
         _intervals = std::max(_intervals, matcher->intervals());
 }
 
-bool FluxMatchers::matches(const unsigned* intervals, FluxMatch& match) const
+bool FluxMatchers::matches(const unsigned* intervals,
+    FluxMatch& match,
+    double bitErrorThreshold) const
 {
     for (const auto* matcher : _matchers)
     {
-        if (matcher->matches(intervals, match))
+        if (matcher->matches(intervals, match, bitErrorThreshold))
             return true;
     }
     return false;
@@ -21,8 +21,13 @@ class FluxMatcher
 public:
     virtual ~FluxMatcher() {}
 
-    /* Returns the number of intervals matched */
-    virtual bool matches(const unsigned* intervals, FluxMatch& match) const = 0;
+    /* Returns the number of intervals matched. bitErrorThreshold is the
+     * amount of timing error to tolerate, in fractions of a clock; the
+     * two-argument version uses the one from the global config. */
+    virtual bool matches(const unsigned* intervals,
+        FluxMatch& match,
+        double bitErrorThreshold) const = 0;
+    bool matches(const unsigned* intervals, FluxMatch& match) const;
     virtual unsigned intervals() const = 0;
 };
 
@@ -31,7 +36,10 @@ class FluxPattern : public FluxMatcher
 public:
     FluxPattern(unsigned bits, uint64_t patterns);
 
-    bool matches(const unsigned* intervals, FluxMatch& match) const override;
+    using FluxMatcher::matches;
+    bool matches(const unsigned* intervals,
+        FluxMatch& match,
+        double bitErrorThreshold) const override;
 
     unsigned intervals() const override
     {
@@ -55,7 +63,10 @@ class FluxMatchers : public FluxMatcher
 public:
     FluxMatchers(const std::initializer_list<const FluxMatcher*> matchers);
 
-    bool matches(const unsigned* intervals, FluxMatch& match) const override;
+    using FluxMatcher::matches;
+    bool matches(const unsigned* intervals,
+        FluxMatch& match,
+        double bitErrorThreshold) const override;
 
     unsigned intervals() const override
     {
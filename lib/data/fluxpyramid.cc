@@ -0,0 +1,123 @@
+#include "lib/core/globals.h"
+#include "lib/data/fluxmap.h"
+#include "lib/data/fluxpyramid.h"
+#include "protocol.h"
+#include <math.h>
+
+FluxPyramid::Bucket& FluxPyramid::Bucket::operator+=(const Bucket& other)
+{
+    pulses += other.pulses;
+    minInterval = std::min(minInterval, other.minInterval);
+    maxInterval = std::max(maxInterval, other.maxInterval);
+    return *this;
+}
+
+FluxPyramid::FluxPyramid(const Fluxmap& fluxmap)
+{
+    /* Level 0 comes straight from the bytecode. */
+
+    std::vector<Bucket> buckets((fluxmap.ticks() >> BASE_SHIFT) + 1);
+    const uint8_t* start = fluxmap.ptr();
+    const uint8_t* end = start + fluxmap.bytes();
+    const uint8_t* ptr = start;
+    unsigned now = 0;
+    unsigned interval = 0;
+    while (ptr != end)
+    {
+        uint8_t b = *ptr;
+        unsigned then = now + (b & 0x3f);
+        while ((_seekPositions.size() << SEEK_SHIFT) <= then)
+            _seekPositions.push_back(
+                {.bytes = (unsigned)(ptr - start), .ticks = now});
+
+        ptr++;
+        now = then;
+        interval += b & 0x3f;
+        if (b & F_BIT_PULSE)
+        {
+            Bucket& bucket = buckets[now >> BASE_SHIFT];
+            uint16_t clamped = std::min<unsigned>(interval, UINT16_MAX);
+            bucket.pulses++;
+            bucket.minInterval = std::min(bucket.minInterval, clamped);
+            bucket.maxInterval = std::max(bucket.maxInterval, clamped);
+            interval = 0;
+        }
+    }
+    _levels.push_back(std::move(buckets));
+
+    /* Each subsequent level merges pairs of buckets from the one below,
+     * until there's only one left. */
+
+    while (_levels.back().size() > 1)
+    {
+        const auto& below = _levels.back();
+        std::vector<Bucket> above((below.size() + 1) / 2);
+        for (unsigned i = 0; i < below.size(); i++)
+            above[i / 2] += below[i];
+        _levels.push_back(std::move(above));
+    }
+
+    for (const auto& level : _levels)
+    {
+        uint32_t max = 0;
+        for (const auto& bucket : level)
+            max = std::max(max, bucket.pulses);
+        _maxPulses.push_back(max);
+    }
+}
+
+double FluxPyramid::maxDensity(unsigned level) const
+{
+    return (double)_maxPulses[level] / bucketTicks(level);
+}
+
+unsigned FluxPyramid::levelFor(double ticksPerColumn) const
+{
+    unsigned level = 0;
+    while (((level + 1) < _levels.size()) &&
+           (bucketTicks(level + 1) <= ticksPerColumn))
+        level++;
+    return level;
+}
+
+std::vector<FluxPyramid::Summary> FluxPyramid::columns(
+    double startTicks, double ticksPerColumn, unsigned count) const
+{
+    unsigned level = levelFor(ticksPerColumn);
+    const auto& buckets = _levels[level];
+    double width = bucketTicks(level);
+    int64_t size = buckets.size();
+
+    std::vector<Summary> results(count);
+    for (unsigned i = 0; i < count; i++)
+    {
+        /* A column gets every bucket which starts inside it. If the buckets
+         * are bigger than the columns, it gets the one it's inside instead. */
+
+        double start = startTicks + i * ticksPerColumn;
+        int64_t first = ceil(start / width);
+        int64_t last = ceil((start + ticksPerColumn) / width);
+        if (first >= last)
+        {
+            first = floor(start / width);
+            last = first + 1;
+        }
+        first = std::clamp<int64_t>(first, 0, size);
+        last = std::clamp<int64_t>(last, 0, size);
+
+        Summary& summary = results[i];
+        for (int64_t j = first; j < last; j++)
+            summary += buckets[j];
+        summary.ticks = (last - first) * width;
+    }
+    return results;
+}
+
+Fluxmap::Position FluxPyramid::seekPosition(double startTicks) const
+{
+    if (_seekPositions.empty() || (startTicks < 0))
+        return {};
+    size_t block = std::min<size_t>(
+        (size_t)startTicks >> SEEK_SHIFT, _seekPositions.size() - 1);
+    return _seekPositions[block];
+}
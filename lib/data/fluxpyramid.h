@@ -0,0 +1,103 @@
+#ifndef FLUXPYRAMID_H
+#define FLUXPYRAMID_H
+
+#include "lib/data/fluxmap.h"
+
+/* A summary of a Fluxmap at several resolutions, for drawing it at any zoom
+ * level without walking the flux. Level 0 divides the fluxmap into buckets of
+ * BASE_TICKS ticks; each level after that has buckets twice the size of the
+ * one before. Each pulse (and the interval which ends with it) is counted in
+ * the bucket it falls in.
+ *
+ * Building one reads all the flux, which may take a while for big fluxmaps,
+ * so callers on a UI thread should do it somewhere else. They're not cached
+ * on the Fluxmap; whoever builds one decides how long to keep it. */
+
+class FluxPyramid
+{
+public:
+    static constexpr unsigned BASE_SHIFT = 5;
+    static constexpr unsigned BASE_TICKS = 1 << BASE_SHIFT;
+    static constexpr unsigned SEEK_SHIFT = 10;
+
+    /* Intervals are in ticks, and are clamped to UINT16_MAX. If pulses is 0
+     * then minInterval and maxInterval are meaningless. */
+
+    struct Bucket
+    {
+        uint32_t pulses = 0;
+        uint16_t minInterval = UINT16_MAX;
+        uint16_t maxInterval = 0;
+
+        Bucket& operator+=(const Bucket& other);
+    };
+
+    struct Summary : public Bucket
+    {
+        /* The amount of time the summary actually covers, which is rounded
+         * to whole buckets. */
+
+        unsigned ticks = 0;
+
+        /* Pulses per tick. */
+
+        double density() const
+        {
+            return ticks ? ((double)pulses / ticks) : 0.0;
+        }
+    };
+
+public:
+    FluxPyramid(const Fluxmap& fluxmap);
+
+public:
+    unsigned levels() const
+    {
+        return _levels.size();
+    }
+
+    unsigned bucketTicks(unsigned level) const
+    {
+        return BASE_TICKS << level;
+    }
+
+    const std::vector<Bucket>& level(unsigned level) const
+    {
+        return _levels[level];
+    }
+
+    /* The highest density of any single bucket in this level, in pulses per
+     * tick; useful for scaling. */
+
+    double maxDensity(unsigned level) const;
+
+    /* Returns the coarsest level whose buckets are no bigger than
+     * ticksPerColumn (or level 0 if they're all bigger). */
+
+    unsigned levelFor(double ticksPerColumn) const;
+
+    /* Summarises count consecutive columns, each ticksPerColumn wide, starting
+     * at startTicks. This costs O(count) regardless of the zoom level.
+     * Columns outside the fluxmap are empty. */
+
+    std::vector<Summary> columns(
+        double startTicks, double ticksPerColumn, unsigned count) const;
+
+    /* Returns a position in the fluxmap at or before startTicks, such that
+     * reading forward from it finds every pulse from startTicks onwards.
+     * Within the fluxmap it's only about 1 << SEEK_SHIFT ticks early at
+     * most, so that drawing individual pulses can start near the left edge
+     * of the window rather than at the beginning of the fluxmap. */
+
+    Fluxmap::Position seekPosition(double startTicks) const;
+
+private:
+    std::vector<std::vector<Bucket>> _levels;
+    std::vector<uint32_t> _maxPulses;
+
+    /* The position just before the first byte ending at or after the start
+     * of each 1 << SEEK_SHIFT tick block. */
+    std::vector<Fluxmap::Position> _seekPositions;
+};
+
+#endif
@@ -0,0 +1,169 @@
+#include "lib/core/globals.h"
+#include "lib/data/fluxscan.h"
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#define HAVE_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define HAVE_NEON 1
+#endif
+
+/* Runs of uninteresting bytes are usually very short when looking for the
+ * next event of any kind, so this many bytes are checked by hand before
+ * bothering with the vector code. */
+static constexpr unsigned PROLOGUE = 2;
+
+using ScanFunction = const uint8_t* (*)(const uint8_t* ptr,
+    const uint8_t* end,
+    uint8_t stopMask,
+    bool stopOnZero,
+    unsigned& ticks);
+
+static inline bool stops(uint8_t b, uint8_t stopMask, bool stopOnZero)
+{
+    return (b & stopMask) || (stopOnZero && !b);
+}
+
+const uint8_t* scanFluxScalar(const uint8_t* ptr,
+    const uint8_t* end,
+    uint8_t stopMask,
+    bool stopOnZero,
+    unsigned& ticks)
+{
+    while ((ptr != end) && !stops(*ptr, stopMask, stopOnZero))
+        ticks += *ptr++ & 0x3f;
+    return ptr;
+}
+
+/* Each of the vector versions finds the first block containing a stopping
+ * byte, and then leaves the scalar version to find exactly where it is. */
+
+#if HAVE_X86
+static const uint8_t* scanSse2(const uint8_t* ptr,
+    const uint8_t* end,
+    uint8_t stopMask,
+    bool stopOnZero,
+    unsigned& ticks)
+{
+    const __m128i mask = _mm_set1_epi8(stopMask);
+    const __m128i zeroStops = _mm_set1_epi8(stopOnZero ? 0xff : 0);
+    const __m128i tickBits = _mm_set1_epi8(0x3f);
+    const __m128i zero = _mm_setzero_si128();
+
+    while ((end - ptr) >= 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)ptr);
+        __m128i quiet = _mm_andnot_si128(
+            _mm_and_si128(_mm_cmpeq_epi8(v, zero), zeroStops),
+            _mm_cmpeq_epi8(_mm_and_si128(v, mask), zero));
+        if (_mm_movemask_epi8(quiet) != 0xffff)
+            break;
+
+        __m128i sums = _mm_sad_epu8(_mm_and_si128(v, tickBits), zero);
+        ticks += _mm_cvtsi128_si32(sums) + _mm_extract_epi16(sums, 4);
+        ptr += 16;
+    }
+    return scanFluxScalar(ptr, end, stopMask, stopOnZero, ticks);
+}
+
+__attribute__((target("avx2"))) static const uint8_t* scanAvx2(
+    const uint8_t* ptr,
+    const uint8_t* end,
+    uint8_t stopMask,
+    bool stopOnZero,
+    unsigned& ticks)
+{
+    const __m256i mask = _mm256_set1_epi8(stopMask);
+    const __m256i zeroStops = _mm256_set1_epi8(stopOnZero ? 0xff : 0);
+    const __m256i tickBits = _mm256_set1_epi8(0x3f);
+    const __m256i zero = _mm256_setzero_si256();
+
+    while ((end - ptr) >= 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i*)ptr);
+        __m256i quiet = _mm256_andnot_si256(
+            _mm256_and_si256(_mm256_cmpeq_epi8(v, zero), zeroStops),
+            _mm256_cmpeq_epi8(_mm256_and_si256(v, mask), zero));
+        if (_mm256_movemask_epi8(quiet) != -1)
+            break;
+
+        __m256i sums = _mm256_sad_epu8(_mm256_and_si256(v, tickBits), zero);
+        ticks += _mm256_extract_epi64(sums, 0) + _mm256_extract_epi64(sums, 1) +
+                 _mm256_extract_epi64(sums, 2) + _mm256_extract_epi64(sums, 3);
+        ptr += 32;
+    }
+    return scanSse2(ptr, end, stopMask, stopOnZero, ticks);
+}
+#endif
+
+#if HAVE_NEON
+static const uint8_t* scanNeon(const uint8_t* ptr,
+    const uint8_t* end,
+    uint8_t stopMask,
+    bool stopOnZero,
+    unsigned& ticks)
+{
+    const uint8x16_t mask = vdupq_n_u8(stopMask);
+    const uint8x16_t zeroStops = vdupq_n_u8(stopOnZero ? 0xff : 0);
+    const uint8x16_t tickBits = vdupq_n_u8(0x3f);
+
+    while ((end - ptr) >= 16)
+    {
+        uint8x16_t v = vld1q_u8(ptr);
+        uint8x16_t stopping =
+            vorrq_u8(vtstq_u8(v, mask), vandq_u8(vceqzq_u8(v), zeroStops));
+        if (vmaxvq_u8(stopping))
+            break;
+
+        ticks += vaddlvq_u8(vandq_u8(v, tickBits));
+        ptr += 16;
+    }
+    return scanFluxScalar(ptr, end, stopMask, stopOnZero, ticks);
+}
+#endif
+
+namespace
+{
+    struct Implementation
+    {
+        const char* name;
+        ScanFunction scan;
+    };
+}
+
+static Implementation chooseImplementation()
+{
+#if HAVE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return {"avx2", scanAvx2};
+    return {"sse2", scanSse2};
+#elif HAVE_NEON
+    return {"neon", scanNeon};
+#else
+    return {"scalar", scanFluxScalar};
+#endif
+}
+
+static const Implementation implementation = chooseImplementation();
+
+const uint8_t* scanFlux(const uint8_t* ptr,
+    const uint8_t* end,
+    uint8_t stopMask,
+    bool stopOnZero,
+    unsigned& ticks)
+{
+    for (unsigned i = 0; i < PROLOGUE; i++)
+    {
+        if ((ptr == end) || stops(*ptr, stopMask, stopOnZero))
+            return ptr;
+        ticks += *ptr++ & 0x3f;
+    }
+    return implementation.scan(ptr, end, stopMask, stopOnZero, ticks);
+}
+
+const char* scanFluxImplementation()
+{
+    return implementation.name;
+}
@@ -0,0 +1,32 @@
+#ifndef FLUXSCAN_H
+#define FLUXSCAN_H
+
+/* Fast scanning of flux bytecode. Most bytes in a capture are either events
+ * the caller isn't interested in or 0x3f continuation bytes, so rather than
+ * looking at them one at a time the bytecode is checked in vector-sized
+ * blocks (using whatever this machine has), with the ticks of every byte
+ * skipped over summed in bulk. */
+
+/* Returns the first byte in [ptr, end) which has any of the bits in stopMask
+ * set, or (if stopOnZero is set) is zero, or end if there isn't one. The ticks
+ * of every byte before it are added to ticks. */
+
+extern const uint8_t* scanFlux(const uint8_t* ptr,
+    const uint8_t* end,
+    uint8_t stopMask,
+    bool stopOnZero,
+    unsigned& ticks);
+
+/* The same, one byte at a time. */
+
+extern const uint8_t* scanFluxScalar(const uint8_t* ptr,
+    const uint8_t* end,
+    uint8_t stopMask,
+    bool stopOnZero,
+    unsigned& ticks);
+
+/* The name of the implementation scanFlux() is using. */
+
+extern const char* scanFluxImplementation();
+
+#endif
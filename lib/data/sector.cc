@@ -1,10 +1,16 @@
 #include "lib/core/globals.h"
+#include "lib/core/crc.h"
 #include "lib/data/disk.h"
 #include "lib/data/sector.h"
 #include "lib/data/layout.h"
 
 Sector::Sector(const LogicalLocation& location): LogicalLocation(location) {}
 
+uint64_t Sector::dataDigest() const
+{
+    return fnv1a64(data);
+}
+
 std::string Sector::statusToString(Status status)
 {
     switch (status)
@@ -19,6 +25,8 @@ std::string Sector::statusToString(Status status)
             return "present but no data found";
         case Status::CONFLICT:
             return "conflicting data";
+        case Status::CORRECTED:
+            return "corrected";
         default:
             return fmt::format("unknown error {}", (int)status);
     }
@@ -38,11 +46,19 @@ std::string Sector::statusToChar(Status status)
             return "!";
         case Status::CONFLICT:
             return "*";
+        case Status::CORRECTED:
+            return "c";
         default:
             return "?";
     }
 }
 
+bool Sector::isGoodStatus(Status status, bool acceptCorrected)
+{
+    return (status == Status::OK) ||
+           (acceptCorrected && (status == Status::CORRECTED));
+}
+
 Sector::Status Sector::stringToStatus(const std::string& value)
 {
     if (value == "OK")
@@ -55,6 +71,8 @@ Sector::Status Sector::stringToStatus(const std::string& value)
         return Status::DATA_MISSING;
     if (value == "conflicting data")
         return Status::CONFLICT;
+    if (value == "corrected")
+        return Status::CORRECTED;
     return Status::INTERNAL_ERROR;
 }
 
@@ -18,12 +18,24 @@ struct Sector : public LogicalLocation
         DATA_MISSING,
         CONFLICT,
         INTERNAL_ERROR,
+        CORRECTED,
     };
 
     static std::string statusToString(Status status);
     static std::string statusToChar(Status status);
     static Status stringToStatus(const std::string& value);
 
+    /* Whether a sector with this status counts as a good read. Corrected
+     * sectors only do if the user has said to accept them. */
+
+    static bool isGoodStatus(Status status, bool acceptCorrected);
+
+    /* A cheap digest of data, for comparing payloads. This is calculated
+     * every time, so callers which compare a sector repeatedly should keep
+     * it. */
+
+    uint64_t dataDigest() const;
+
     Status status = Status::INTERNAL_ERROR;
     uint32_t position = 0;
     nanoseconds_t clock = 0;
@@ -0,0 +1,87 @@
+#include "lib/core/globals.h"
+#include "lib/data/sector.h"
+#include "lib/data/sectorcollector.h"
+
+static uint64_t toKey(const LogicalLocation& location)
+{
+    return ((uint64_t)location.logicalCylinder << 40) ^
+           ((uint64_t)location.logicalHead << 32) ^ location.logicalSector;
+}
+
+static std::shared_ptr<const Sector> asConflict(
+    const std::shared_ptr<const Sector>& sector)
+{
+    auto s = std::make_shared<Sector>(*sector);
+    s->status = Sector::CONFLICT;
+    return s;
+}
+
+SectorCollector::SectorCollector(bool collapseConflicts):
+    _collapseConflicts(collapseConflicts)
+{
+}
+
+void SectorCollector::add(const std::shared_ptr<const Sector>& sector)
+{
+    auto [it, inserted] = _index.try_emplace(toKey(*sector), _sectors.size());
+    if (inserted)
+    {
+        _sectors.push_back(sector);
+        _digests.push_back(std::nullopt);
+        return;
+    }
+
+    auto& left = _sectors[it->second];
+    auto& leftDigest = _digests[it->second];
+    auto& right = sector;
+    if ((left->status == Sector::OK) && (right->status == Sector::OK))
+    {
+        bool same = left->data.size() == right->data.size();
+        if (same)
+        {
+            if (!leftDigest)
+                leftDigest = left->dataDigest();
+            same = *leftDigest == right->dataDigest();
+        }
+
+        if (!same)
+        {
+            if (!_collapseConflicts)
+                _conflicts.push_back(asConflict(right));
+            left = asConflict(left);
+        }
+        return;
+    }
+
+    if (left->status == Sector::CONFLICT)
+        return;
+    if ((right->status == Sector::CONFLICT) || (right->status == Sector::OK) ||
+        ((right->status == Sector::CORRECTED) &&
+            (left->status != Sector::OK) &&
+            (left->status != Sector::CORRECTED)))
+    {
+        left = right;
+        leftDigest.reset();
+    }
+}
+
+void SectorCollector::add(
+    const std::vector<std::shared_ptr<const Sector>>& sectors)
+{
+    for (const auto& sector : sectors)
+        add(sector);
+}
+
+bool SectorCollector::contains(const LogicalLocation& location) const
+{
+    return _index.contains(toKey(location));
+}
+
+std::vector<std::shared_ptr<const Sector>> SectorCollector::sectors() const
+{
+    std::vector<std::shared_ptr<const Sector>> results;
+    results.reserve(_sectors.size() + _conflicts.size());
+    results.insert(results.end(), _sectors.begin(), _sectors.end());
+    results.insert(results.end(), _conflicts.begin(), _conflicts.end());
+    return results;
+}
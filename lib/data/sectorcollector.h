@@ -0,0 +1,45 @@
+#ifndef SECTORCOLLECTOR_H
+#define SECTORCOLLECTOR_H
+
+#include "lib/data/locations.h"
+#include <unordered_map>
+
+struct Sector;
+
+/* Deduplicates sectors as they arrive: there's one entry for each logical
+ * location, preferring good sectors to corrected ones and corrected ones to
+ * bad ones, and two good sectors with different data collapse into a
+ * CONFLICT. Sectors can be added a revolution at a time without reconsidering
+ * the ones already seen.
+ *
+ * Payloads are compared by size and 64-bit digest rather than by contents.
+ * The digest of a kept sector is only calculated the first time it's needed,
+ * and then remembered, so sectors must not be changed after being added. */
+
+class SectorCollector
+{
+public:
+    /* If collapseConflicts is false, the second sector of a conflicting pair
+     * is kept as well (marked as a CONFLICT) rather than being dropped. */
+
+    SectorCollector(bool collapseConflicts = true);
+
+    void add(const std::shared_ptr<const Sector>& sector);
+    void add(const std::vector<std::shared_ptr<const Sector>>& sectors);
+
+    bool contains(const LogicalLocation& location) const;
+
+    /* One sector per location, in the order in which the locations were first
+     * seen, followed by any uncollapsed conflicts. */
+
+    std::vector<std::shared_ptr<const Sector>> sectors() const;
+
+private:
+    bool _collapseConflicts;
+    std::unordered_map<uint64_t, unsigned> _index;
+    std::vector<std::shared_ptr<const Sector>> _sectors;
+    std::vector<std::optional<uint64_t>> _digests;
+    std::vector<std::shared_ptr<const Sector>> _conflicts;
+};
+
+#endif
@@ -0,0 +1,104 @@
+#include "lib/core/globals.h"
+#include "lib/data/layout.h"
+#include "lib/data/image.h"
+#include "lib/data/sector.h"
+#include "lib/data/sectorgrid.h"
+#include <algorithm>
+
+SectorGrid::SectorGrid(const DiskLayout& diskLayout, Kind kind): _kind(kind)
+{
+    if (diskLayout.layoutByLogicalLocation.empty())
+        return;
+
+    /* Both kinds of grid have the same columns, covering every sector ID
+     * used anywhere on the disk. */
+
+    unsigned minSector = UINT_MAX;
+    unsigned maxSector = 0;
+    for (const auto& [ch, ltl] : diskLayout.layoutByLogicalLocation)
+    {
+        if (ltl->filesystemSectorOrder.empty())
+            continue;
+        minSector = std::min(
+            minSector, *std::ranges::min_element(ltl->filesystemSectorOrder));
+        maxSector = std::max(
+            maxSector, *std::ranges::max_element(ltl->filesystemSectorOrder));
+    }
+    if (minSector > maxSector)
+        return;
+    _minSector = minSector;
+    _columns = maxSector - minSector + 1;
+
+    _bounds = (kind == PHYSICAL) ? diskLayout.getPhysicalBounds()
+                                 : diskLayout.getLogicalBounds();
+    _heads = _bounds.maxHead - _bounds.minHead + 1;
+    _rows = (_bounds.maxCylinder - _bounds.minCylinder + 1) * _heads;
+
+    _cells.resize(_rows * _columns);
+    _locations.resize(_rows * _columns);
+    for (unsigned row = 0; row < _rows; row++)
+    {
+        CylinderHead ch = {cylinderForRow(row), headForRow(row)};
+        std::shared_ptr<const LogicalTrackLayout> ltl;
+        if (kind == PHYSICAL)
+        {
+            auto ptl = findOrDefault(diskLayout.layoutByPhysicalLocation, ch);
+            if (ptl)
+                ltl = ptl->logicalTrackLayout;
+        }
+        else
+            ltl = findOrDefault(diskLayout.layoutByLogicalLocation, ch);
+        if (!ltl)
+            continue;
+
+        for (unsigned column = 0; column < _columns; column++)
+        {
+            LogicalLocation location = {ltl->logicalCylinder,
+                ltl->logicalHead,
+                sectorForColumn(column)};
+            unsigned index = row * _columns + column;
+            _locations[index] = location;
+            _cellsByTrack[location.trackLocation()].push_back(index);
+            auto blockId = findOptionally(
+                diskLayout.blockIdByLogicalSectorLocation, location);
+            if (blockId.has_value())
+                _cells[index].blockId = *blockId;
+        }
+    }
+}
+
+bool SectorGrid::update(const Image* image)
+{
+    bool changed = false;
+    for (unsigned i = 0; i < _cells.size(); i++)
+        changed |= updateCell(image, i);
+    return changed;
+}
+
+bool SectorGrid::update(
+    const Image* image, const std::set<CylinderHead>& tracks)
+{
+    bool changed = false;
+    for (const auto& track : tracks)
+    {
+        auto it = _cellsByTrack.find(track);
+        if (it != _cellsByTrack.end())
+            for (unsigned i : it->second)
+                changed |= updateCell(image, i);
+    }
+    return changed;
+}
+
+bool SectorGrid::updateCell(const Image* image, unsigned index)
+{
+    std::shared_ptr<const Sector> sector;
+    if (image && _locations[index].has_value())
+        sector = image->get(*_locations[index]);
+
+    Cell& cell = _cells[index];
+    if (sector == cell.sector)
+        return false;
+    cell.sector = sector;
+    cell.status = sector ? sector->status : Sector::MISSING;
+    return true;
+}
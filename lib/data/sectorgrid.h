@@ -0,0 +1,108 @@
+#ifndef SECTORGRID_H
+#define SECTORGRID_H
+
+#include "lib/data/layout.h"
+#include "lib/data/sector.h"
+
+class Image;
+
+/* A dense table of the state of every sector on a disk, for drawing sector
+ * maps. There is one row for each track (cylinder-major) and one column for
+ * each sector ID. The shape comes from the layout and is fixed; the contents
+ * are refreshed from an image with update(), either all at once or just the
+ * cells showing particular logical tracks. */
+
+class SectorGrid
+{
+public:
+    enum Kind
+    {
+        /* Rows are logical tracks. */
+        LOGICAL,
+
+        /* Rows are physical tracks, showing the logical track stored on
+         * them. */
+        PHYSICAL,
+    };
+
+    struct Cell
+    {
+        /* Null if the sector hasn't been read (or there isn't one). */
+        std::shared_ptr<const Sector> sector;
+        Sector::Status status = Sector::MISSING;
+
+        /* -1 if the sector isn't part of the filesystem. */
+        int blockId = -1;
+    };
+
+public:
+    SectorGrid(const DiskLayout& diskLayout, Kind kind);
+
+public:
+    /* Refreshes the cells from the image, which may be null. Returns true if
+     * anything changed. */
+
+    bool update(const Image* image);
+
+    /* As above, but only for the cells showing the given logical tracks. */
+
+    bool update(const Image* image, const std::set<CylinderHead>& tracks);
+
+    Kind kind() const
+    {
+        return _kind;
+    }
+
+    unsigned rows() const
+    {
+        return _rows;
+    }
+
+    unsigned columns() const
+    {
+        return _columns;
+    }
+
+    unsigned cylinderForRow(unsigned row) const
+    {
+        return _bounds.minCylinder + row / _heads;
+    }
+
+    unsigned headForRow(unsigned row) const
+    {
+        return _bounds.minHead + row % _heads;
+    }
+
+    unsigned sectorForColumn(unsigned column) const
+    {
+        return _minSector + column;
+    }
+
+    const Cell& at(unsigned row, unsigned column) const
+    {
+        return _cells[row * _columns + column];
+    }
+
+    const std::vector<Cell>& cells() const
+    {
+        return _cells;
+    }
+
+private:
+    Kind _kind;
+    DiskLayout::LayoutBounds _bounds;
+    unsigned _heads = 0;
+    unsigned _rows = 0;
+    unsigned _minSector = 0;
+    unsigned _columns = 0;
+    std::vector<Cell> _cells;
+
+    /* The logical location shown in each cell, if any, and the cells showing
+     * each logical track. */
+    std::vector<std::optional<LogicalLocation>> _locations;
+    std::map<CylinderHead, std::vector<unsigned>> _cellsByTrack;
+
+    bool updateCell(const Image* image, unsigned index);
+};
+
+#endif
@@ -11,12 +11,17 @@
 #include "lib/data/image.h"
 #include "lib/decoders/decoders.pb.h"
 #include "lib/data/layout.h"
+#include "lib/core/crccorrector.h"
+#include "lib/core/trace.h"
 #include <numeric>
 
 std::shared_ptr<Track> Decoder::decodeToSectors(
     std::shared_ptr<const Fluxmap> fluxmap,
-    const std::shared_ptr<const PhysicalTrackLayout>& ptl)
+    const std::shared_ptr<const PhysicalTrackLayout>& ptl,
+    bool stopWhenComplete)
 {
+    TraceSpan span("decode",
+        {{"cylinder", ptl->physicalCylinder}, {"head", ptl->physicalHead}});
     _ltl = ptl->logicalTrackLayout;
 
     _trackdata = std::make_shared<Track>();
@@ -24,7 +29,7 @@ std::shared_ptr<Track> Decoder::decodeToSectors(
     _trackdata->ptl = ptl;
     _trackdata->ltl = ptl->logicalTrackLayout;
 
-    FluxmapReader fmr(*fluxmap);
+    FluxmapReader fmr(*fluxmap, _config);
     _fmr = &fmr;
 
     auto newSector = [&]
@@ -35,6 +40,13 @@ std::shared_ptr<Track> Decoder::decodeToSectors(
         _sector->status = Sector::MISSING;
     };
 
+    /* The sectors which still need a good read, if we're stopping early. */
+
+    std::set<unsigned> wanted;
+    if (stopWhenComplete)
+        wanted.insert(
+            _ltl->diskSectorOrder.begin(), _ltl->diskSectorOrder.end());
+
     newSector();
     beginTrack();
     for (;;)
@@ -91,11 +103,27 @@ std::shared_ptr<Track> Decoder::decodeToSectors(
 
         if (_sector->status != Sector::MISSING)
             _trackdata->allSectors.push_back(_sector);
+
+        if (!wanted.empty() && isGoodRead(*_sector, *_ltl))
+        {
+            wanted.erase(_sector->logicalSector);
+            if (wanted.empty())
+                break;
+        }
     }
 
     return _trackdata;
 }
 
+bool Decoder::isGoodRead(
+    const Sector& sector, const LogicalTrackLayout& ltl) const
+{
+    return Sector::isGoodStatus(
+               sector.status, _config.crc_correction().accept()) &&
+           (sector.logicalCylinder == ltl.logicalCylinder) &&
+           (sector.logicalHead == ltl.logicalHead);
+}
+
 void Decoder::pushRecord(
     const Fluxmap::Position& start, const Fluxmap::Position& end)
 {
@@ -114,6 +142,17 @@ void Decoder::pushRecord(
     _recordBits.clear();
 }
 
+bool Decoder::correctCrcError(CrcCorrector& corrector,
+    Bytes& block,
+    uint64_t got,
+    uint64_t wanted,
+    unsigned first)
+{
+    if (!_config.crc_correction().enabled())
+        return false;
+    return corrector.correct(block, got, wanted, first);
+}
+
 void Decoder::resetFluxDecoder()
 {
     _decoder.reset(new FluxDecoder(_fmr, _sector->clock, _config));
@@ -177,3 +216,34 @@ uint64_t Decoder::readRaw64()
 {
     return toBytes(readRawBits(64)).reader().read_be64();
 }
+
+StreamingDecoder::StreamingDecoder(Decoder& decoder,
+    const std::shared_ptr<const PhysicalTrackLayout>& ptl,
+    nanoseconds_t interval):
+    _decoder(decoder),
+    _ptl(ptl),
+    _interval(interval)
+{
+    const auto& order = ptl->logicalTrackLayout->diskSectorOrder;
+    _wanted.insert(order.begin(), order.end());
+}
+
+bool StreamingDecoder::feed(const Fluxmap& fluxmap)
+{
+    if (_wanted.empty())
+        return true;
+    if ((fluxmap.duration() - _lastCheckTime) < _interval)
+        return false;
+
+    auto piece = std::make_shared<Fluxmap>();
+    piece->appendBytes(fluxmap.rawBytes().slice(_previousCheckBytes));
+    _previousCheckBytes = _lastCheckBytes;
+    _lastCheckBytes = fluxmap.bytes();
+    _lastCheckTime = fluxmap.duration();
+
+    auto track = _decoder.decodeToSectors(piece, _ptl, true);
+    for (const auto& sector : track->allSectors)
+        if (_decoder.isGoodRead(*sector, *_ptl->logicalTrackLayout))
+            _wanted.erase(sector->logicalSector);
+    return _wanted.empty();
+}
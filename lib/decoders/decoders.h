@@ -7,6 +7,7 @@
 #include "lib/decoders/fluxdecoder.h"
 
 class Config;
+class CrcCorrector;
 class DecoderProto;
 class FluxMatcher;
 class Fluxmap;
@@ -53,9 +54,14 @@ public:
     };
 
 public:
+    /* Decodes all the sectors in the fluxmap. If stopWhenComplete is set,
+     * decoding stops as soon as every sector the layout expects has been read
+     * correctly, rather than carrying on to the end of the flux. */
+
     std::shared_ptr<Track> decodeToSectors(
         std::shared_ptr<const Fluxmap> fluxmap,
-        const std::shared_ptr<const PhysicalTrackLayout>& ptl);
+        const std::shared_ptr<const PhysicalTrackLayout>& ptl,
+        bool stopWhenComplete = false);
 
     void pushRecord(
         const Fluxmap::Position& start, const Fluxmap::Position& end);
@@ -98,12 +104,27 @@ public:
         return _fmr->getDuration();
     }
 
+    /* Returns true if sector is a good read of one of the sectors which ltl
+     * expects (OK, or CORRECTED if corrected sectors are being accepted). */
+
+    bool isGoodRead(
+        const Sector& sector, const LogicalTrackLayout& ltl) const;
+
 protected:
     virtual void beginTrack() {};
     virtual nanoseconds_t advanceToNextRecord() = 0;
     virtual void decodeSectorRecord() = 0;
     virtual void decodeDataRecord() {};
 
+    /* If CRC correction is enabled, tries to repair block, whose calculated
+     * check value got doesn't match the one read from disk; see CrcCorrector.
+     */
+    bool correctCrcError(CrcCorrector& corrector,
+        Bytes& block,
+        uint64_t got,
+        uint64_t wanted,
+        unsigned first = 0);
+
     const DecoderProto& _config;
     std::shared_ptr<const LogicalTrackLayout> _ltl;
     std::shared_ptr<Track> _trackdata;
@@ -115,4 +136,37 @@ private:
     FluxmapReader* _fmr = nullptr;
 };
 
+/* Decodes a track while its flux is still arriving, so that a read can be
+ * stopped as soon as every expected sector has been seen. The fluxmap passed
+ * to each call to feed() must be the previous one with more data appended.
+ * Rather than decoding everything each time, only the flux since the check
+ * before last is decoded; as checks are interval apart, any sector shorter
+ * than interval is seen whole by at least one of them. */
+
+class StreamingDecoder
+{
+public:
+    StreamingDecoder(Decoder& decoder,
+        const std::shared_ptr<const PhysicalTrackLayout>& ptl,
+        nanoseconds_t interval);
+
+    /* Returns true once the track is complete. */
+
+    bool feed(const Fluxmap& fluxmap);
+
+    bool complete() const
+    {
+        return _wanted.empty();
+    }
+
+private:
+    Decoder& _decoder;
+    std::shared_ptr<const PhysicalTrackLayout> _ptl;
+    nanoseconds_t _interval;
+    std::set<unsigned> _wanted;
+    nanoseconds_t _lastCheckTime = 0;
+    size_t _lastCheckBytes = 0;
+    size_t _previousCheckBytes = 0;
+};
+
 #endif
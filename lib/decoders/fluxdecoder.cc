@@ -23,8 +23,25 @@ FluxDecoder::FluxDecoder(
     _clock_min(bitcell * (1.0 - _pll_adjust)),
     _clock_max(bitcell * (1.0 + _pll_adjust)),
     _flux(0),
-    _leading_zeroes(fmr->tell().zeroes)
+    _leading_zeroes(fmr->tell().zeroes),
+    _fixed_point(config.fixed_point_pll())
 {
+    if (_fixed_point)
+    {
+        auto toQ16 = [](double value)
+        {
+            return (int64_t)llround(value * 0x10000);
+        };
+
+        _debounce_ticks = _fmr->debounceThresholdTicks(_clock_centre);
+        _q_pll_adjust = toQ16(_pll_adjust);
+        _q_pll_keep = toQ16(1.0 - _pll_phase);
+        _q_flux_scale = toQ16(_flux_scale);
+        _q_clock = toQ16(bitcell / NS_PER_TICK);
+        _q_clock_centre = _q_clock;
+        _q_clock_min = toQ16(_clock_min / NS_PER_TICK);
+        _q_clock_max = toQ16(_clock_max / NS_PER_TICK);
+    }
 }
 
 bool FluxDecoder::readBit()
@@ -40,6 +57,9 @@ bool FluxDecoder::readBit()
         return true;
     }
 
+    if (_fixed_point)
+        return readFixedPointBit();
+
     while (!_fmr->eof() && (_flux < (_clock / 2)))
     {
         _flux += nextFlux() * _flux_scale;
@@ -90,6 +110,43 @@ bool FluxDecoder::readBit()
     return true;
 }
 
+/* The same algorithm as above, step for step, but in integers. */
+
+bool FluxDecoder::readFixedPointBit()
+{
+    while (!_fmr->eof() && (_q_flux < (_q_clock / 2)))
+    {
+        _q_flux +=
+            _fmr->readIntervalWithThreshold(_debounce_ticks) * _q_flux_scale;
+        _clocked_zeroes = 0;
+    }
+
+    _q_flux -= _q_clock;
+    if (_q_flux >= (_q_clock / 2))
+    {
+        _clocked_zeroes++;
+        _goodbits++;
+        return false;
+    }
+
+    if (_clocked_zeroes <= 3)
+        _q_clock += (_q_flux * _q_pll_adjust) >> 16;
+    else
+    {
+        _q_clock += ((_q_clock_centre - _q_clock) * _q_pll_adjust) >> 16;
+
+        if (_goodbits >= 256)
+            _sync_lost = true;
+        _goodbits = 0;
+    }
+
+    _q_clock = std::clamp(_q_clock, _q_clock_min, _q_clock_max);
+    _q_flux = (_q_flux * _q_pll_keep) >> 16;
+
+    _goodbits++;
+    return true;
+}
+
 std::vector<bool> FluxDecoder::readBits(unsigned count)
 {
     std::vector<bool> result;
@@ -20,6 +20,7 @@ public:
 
 private:
     nanoseconds_t nextFlux();
+    bool readFixedPointBit();
 
 private:
     FluxmapReader* _fmr;
@@ -36,6 +37,20 @@ private:
     bool _index = false;
     bool _sync_lost = false;
     int _leading_zeroes;
+
+    /* State for the fixed-point PLL. Times are in ticks and the factors are
+     * fractions, all Q16. */
+
+    bool _fixed_point;
+    unsigned _debounce_ticks;
+    int64_t _q_pll_adjust;
+    int64_t _q_pll_keep;
+    int64_t _q_flux_scale;
+    int64_t _q_clock;
+    int64_t _q_clock_centre;
+    int64_t _q_clock_min;
+    int64_t _q_clock_max;
+    int64_t _q_flux = 0;
 };
 
 #endif
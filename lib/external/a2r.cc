@@ -0,0 +1,211 @@
+#include "lib/core/globals.h"
+#include "lib/data/fluxmap.h"
+#include "lib/external/a2r.h"
+
+static uint32_t read_le16(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t read_le32(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/* A bounds-checked cursor over one chunk. */
+
+namespace
+{
+    class Cursor
+    {
+    public:
+        Cursor(const uint8_t* ptr, const uint8_t* end): _ptr(ptr), _end(end)
+        {
+        }
+
+        bool eof() const
+        {
+            return _ptr == _end;
+        }
+
+        const uint8_t* take(size_t len)
+        {
+            if ((size_t)(_end - _ptr) < len)
+                error("A2R file is truncated");
+            const uint8_t* p = _ptr;
+            _ptr += len;
+            return p;
+        }
+
+        unsigned read_8()
+        {
+            return *take(1);
+        }
+
+        unsigned read_le16()
+        {
+            return ::read_le16(take(2));
+        }
+
+        uint32_t read_le32()
+        {
+            return ::read_le32(take(4));
+        }
+
+    private:
+        const uint8_t* _ptr;
+        const uint8_t* _end;
+    };
+}
+
+static bool isTiming(unsigned type)
+{
+    return (type == A2R_TIMING) || (type == A2R_XTIMING);
+}
+
+static void indexStrm(A2rIndex& index, Cursor cursor)
+{
+    for (;;)
+    {
+        unsigned location = cursor.read_8();
+        if (location == 0xff)
+            break;
+
+        unsigned type = cursor.read_8();
+        uint32_t len = cursor.read_le32();
+        uint32_t loopPoint = cursor.read_le32();
+        const uint8_t* data = cursor.take(len);
+        if (isTiming(type))
+            index.captures.push_back(A2rCapture{
+                location, data, len, {loopPoint}, A2R_NS_PER_TICK * 1000});
+    }
+}
+
+static void indexRwcp(A2rIndex& index, Cursor cursor)
+{
+    unsigned version = cursor.read_8();
+    if (version != 1)
+        error("unsupported A2R RWCP chunk version {}", version);
+    uint32_t resolution = cursor.read_le32();
+    cursor.take(11);
+
+    for (;;)
+    {
+        unsigned mark = cursor.read_8();
+        if (mark == 'X')
+            break;
+        if (mark != 'C')
+            error("corrupt A2R RWCP chunk");
+
+        A2rCapture capture;
+        unsigned type = cursor.read_8();
+        capture.location = cursor.read_le16();
+        unsigned indexCount = cursor.read_8();
+        for (unsigned i = 0; i < indexCount; i++)
+            capture.indexes.push_back(cursor.read_le32());
+        capture.size = cursor.read_le32();
+        capture.data = cursor.take(capture.size);
+        capture.picosecondsPerTick = resolution;
+        if (isTiming(type))
+            index.captures.push_back(capture);
+    }
+}
+
+A2rIndex indexA2r(const uint8_t* data, size_t size)
+{
+    A2rIndex index;
+    if ((size < 8) || (data[0] != 'A') || (data[1] != '2') ||
+        (data[2] != 'R') || (data[4] != 0xff))
+        error("this is not an A2R file");
+    switch (data[3])
+    {
+        case '2':
+            index.version = 2;
+            break;
+
+        case '3':
+            index.version = 3;
+            break;
+
+        default:
+            error("unsupported A2R version");
+    }
+
+    bool seenInfo = false;
+    const uint8_t* end = data + size;
+    Cursor chunks(data + 8, end);
+    while (!chunks.eof())
+    {
+        uint32_t id = chunks.read_le32();
+        uint32_t len = chunks.read_le32();
+        const uint8_t* chunk = chunks.take(len);
+        Cursor cursor(chunk, chunk + len);
+
+        switch (id)
+        {
+            case A2R_CHUNK_INFO:
+                cursor.take(33);
+                index.diskType = cursor.read_8();
+                seenInfo = true;
+                break;
+
+            case A2R_CHUNK_STRM:
+                indexStrm(index, cursor);
+                break;
+
+            case A2R_CHUNK_RWCP:
+                indexRwcp(index, cursor);
+                break;
+        }
+    }
+
+    if (!seenInfo)
+        error("A2R file has no INFO chunk");
+    return index;
+}
+
+std::unique_ptr<Fluxmap> readA2rCapture(const A2rCapture& capture)
+{
+    /* Times are kept in A2R ticks and converted as a running total, so that
+     * rounding doesn't accumulate. */
+
+    double scale = capture.picosecondsPerTick / (NS_PER_TICK * 1000.0);
+    auto toTicks = [&](uint64_t a2rTicks)
+    {
+        return (uint64_t)(a2rTicks * scale);
+    };
+
+    auto fluxmap = std::make_unique<Fluxmap>();
+    uint64_t now = 0;
+    uint64_t emitted = 0;
+    auto emit = [&](uint64_t a2rTicks)
+    {
+        uint64_t ticks = toTicks(a2rTicks);
+        fluxmap->appendInterval(ticks - emitted);
+        emitted = ticks;
+    };
+
+    auto index = capture.indexes.begin();
+    const uint8_t* p = capture.data;
+    const uint8_t* end = p + capture.size;
+    while (p != end)
+    {
+        uint8_t b;
+        do
+        {
+            b = *p++;
+            now += b;
+        } while ((b == 0xff) && (p != end));
+
+        while ((index != capture.indexes.end()) && (*index <= now))
+        {
+            emit(*index++);
+            fluxmap->appendIndex();
+        }
+
+        emit(now);
+        fluxmap->appendPulse();
+    }
+
+    return fluxmap;
+}
@@ -3,6 +3,7 @@
 
 // The canonical reference for the A2R format is:
 // https://applesaucefdc.com/a2r2-reference/ All data is stored little-endian
+// Version 3 (https://applesaucefdc.com/a2r/) replaces STRM with RWCP.
 
 // Note: The first chunk begins at byte offset 8, not 12 as given in a2r2
 // reference version 2.0.1
@@ -10,6 +11,7 @@
 #define A2R_CHUNK_INFO (0x4F464E49)
 #define A2R_CHUNK_STRM (0x4D525453)
 #define A2R_CHUNK_META (0x4154454D)
+#define A2R_CHUNK_RWCP (0x50435752)
 
 #define A2R_INFO_CHUNK_VERSION (1)
 
@@ -30,4 +32,36 @@ extern const uint8_t a2r2_fileheader[8];
 
 #define A2R_NS_PER_TICK (125)
 
+class Fluxmap;
+
+/* One capture in an A2R file, pointing into the raw file. indexes are the
+ * times of the index pulses from the start of the capture, in ticks. */
+
+struct A2rCapture
+{
+    unsigned location;
+    const uint8_t* data;
+    uint32_t size;
+    std::vector<uint32_t> indexes;
+    uint32_t picosecondsPerTick;
+};
+
+struct A2rIndex
+{
+    unsigned version;
+    unsigned diskType;
+
+    /* Every timing capture, in file order. */
+    std::vector<A2rCapture> captures;
+};
+
+/* Indexes an A2R v2 or v3 file in a single pass. Only the chunk and capture
+ * headers are looked at, not the flux itself. */
+
+extern A2rIndex indexA2r(const uint8_t* data, size_t size);
+
+/* Converts one capture into a fluxmap. */
+
+extern std::unique_ptr<Fluxmap> readA2rCapture(const A2rCapture& capture);
+
 #endif
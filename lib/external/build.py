@@ -7,6 +7,7 @@ protocc(name="fl2_proto_lib", srcs=[".+fl2_proto"], deps=["+protobuf_lib"])
 cxxlibrary(
     name="external",
     srcs=[
+        "./a2r.cc",
         "./catweasel.cc",
         "./csvreader.cc",
         "./fl2.cc",
@@ -14,6 +15,7 @@ cxxlibrary(
         "./greaseweazle.cc",
         "./kryoflux.cc",
         "./ldbs.cc",
+        "./scp.cc",
     ],
     hdrs={
         "lib/external/a2r.h": "./a2r.h",
@@ -3,6 +3,14 @@
 #include "lib/core/bytes.h"
 #include "lib/external/greaseweazle.h"
 
+void writeGreaseweazle28(ByteWriter& bw, uint32_t val)
+{
+    bw.write_8(1 | ((val << 1) & 0xff));
+    bw.write_8(1 | ((val >> 6) & 0xff));
+    bw.write_8(1 | ((val >> 13) & 0xff));
+    bw.write_8(1 | ((val >> 20) & 0xff));
+}
+
 Bytes fluxEngineToGreaseweazle(const Bytes& fldata, nanoseconds_t clock)
 {
     Bytes gwdata;
@@ -11,14 +19,6 @@ Bytes fluxEngineToGreaseweazle(const Bytes& fldata, nanoseconds_t clock)
     uint32_t ticks_fl = 0;
     uint32_t ticks_gw = 0;
 
-    auto write_28 = [&](uint32_t val)
-    {
-        bw.write_8(1 | (val << 1) & 0xff);
-        bw.write_8(1 | (val >> 6) & 0xff);
-        bw.write_8(1 | (val >> 13) & 0xff);
-        bw.write_8(1 | (val >> 20) & 0xff);
-    };
-
     while (!br.eof())
     {
         uint8_t b = br.read_8();
@@ -41,7 +41,7 @@ Bytes fluxEngineToGreaseweazle(const Bytes& fldata, nanoseconds_t clock)
                 {
                     bw.write_8(255);
                     bw.write_8(FLUXOP_SPACE);
-                    write_28(delta - 249);
+                    writeGreaseweazle28(bw, delta - 249);
                     bw.write_8(249);
                 }
             }
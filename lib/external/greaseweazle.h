@@ -13,6 +13,11 @@ extern Bytes fluxEngineToGreaseweazle(const Bytes& fldata, nanoseconds_t clock);
 extern Bytes greaseweazleToFluxEngine(const Bytes& gwdata, nanoseconds_t clock);
 extern Bytes stripPartialRotation(const Bytes& fldata);
 
+/* Writes a 28-bit operand of a Greaseweazle flux opcode, seven bits per byte
+ * with the low bit set so that it can never be mistaken for end of stream. */
+
+extern void writeGreaseweazle28(ByteWriter& bw, uint32_t val);
+
 /* Copied from
  * https://github.com/keirf/Greaseweazle/blob/master/inc/cdc_acm_protocol.h.
  *
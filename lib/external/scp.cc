@@ -0,0 +1,121 @@
+#include "lib/core/globals.h"
+#include "lib/core/bytes.h"
+#include "lib/data/fluxmap.h"
+#include "protocol.h"
+#include "lib/external/scp.h"
+#include <thread>
+
+/* Cells are converted in blocks of this size; the conversion of each block to
+ * ticks has no branches, so the compiler can vectorise it. */
+static constexpr unsigned BLOCK_SIZE = 256;
+
+/* Don't bother with threads for tracks smaller than this. */
+static constexpr uint32_t MIN_CELLS_PER_THREAD = 32 * 1024;
+
+static inline void encodeInterval(uint32_t ticks, std::vector<uint8_t>& out)
+{
+    while (ticks >= 0x3f)
+    {
+        out.push_back(0x3f);
+        ticks -= 0x3f;
+    }
+    out.push_back(F_BIT_PULSE | ticks);
+}
+
+Bytes convertScpCells(const uint8_t* cells,
+    uint32_t count,
+    uint32_t overflow,
+    nanoseconds_t resolution)
+{
+    auto out = std::make_shared<std::vector<uint8_t>>();
+    out->reserve(count + count / 4);
+
+    /* pending is kept as a double, and the arithmetic done in the same order,
+     * so that the results exactly match the obvious cell-at-a-time loop. */
+
+    nanoseconds_t pending = overflow * (nanoseconds_t)0x10000;
+    uint16_t values[BLOCK_SIZE];
+    int32_t ticks[BLOCK_SIZE];
+    for (uint32_t base = 0; base < count; base += BLOCK_SIZE)
+    {
+        unsigned len = std::min<uint32_t>(BLOCK_SIZE, count - base);
+        const uint8_t* p = cells + base * 2;
+
+        unsigned zeroes = 0;
+        for (unsigned i = 0; i < len; i++)
+        {
+            uint16_t value = (p[i * 2] << 8) | p[i * 2 + 1];
+            values[i] = value;
+            zeroes += (value == 0);
+            ticks[i] = value * resolution / NS_PER_TICK;
+        }
+
+        if (!zeroes && !pending)
+        {
+            for (unsigned i = 0; i < len; i++)
+                encodeInterval(ticks[i], *out);
+            continue;
+        }
+
+        /* Slow path: there are overflow cells to deal with. */
+
+        for (unsigned i = 0; i < len; i++)
+        {
+            uint16_t value = values[i];
+            if (value)
+            {
+                encodeInterval(
+                    (uint32_t)((value + pending) * resolution / NS_PER_TICK),
+                    *out);
+                pending = 0;
+            }
+            else
+                pending += 0x10000;
+        }
+    }
+
+    return Bytes(out);
+}
+
+std::unique_ptr<Fluxmap> readScpRevolutions(
+    const std::vector<ScpRevolutionCells>& revolutions,
+    nanoseconds_t resolution)
+{
+    std::vector<Bytes> converted(revolutions.size());
+    auto worker = [&](unsigned revolution)
+    {
+        const auto& r = revolutions[revolution];
+        converted[revolution] =
+            convertScpCells(r.cells, r.count, r.overflow, resolution);
+    };
+
+    uint32_t totalCells = 0;
+    for (const auto& r : revolutions)
+        totalCells += r.count;
+
+    if ((revolutions.size() > 1) && (totalCells >= MIN_CELLS_PER_THREAD))
+    {
+        std::vector<std::thread> pool;
+        for (unsigned revolution = 1; revolution < revolutions.size();
+            revolution++)
+            pool.emplace_back(worker, revolution);
+        worker(0);
+        for (auto& t : pool)
+            t.join();
+    }
+    else
+    {
+        for (unsigned revolution = 0; revolution < revolutions.size();
+            revolution++)
+            worker(revolution);
+    }
+
+    auto fluxmap = std::make_unique<Fluxmap>();
+    for (unsigned revolution = 0; revolution < converted.size(); revolution++)
+    {
+        if (revolution != 0)
+            fluxmap->appendIndex();
+        fluxmap->appendBytes(converted[revolution]);
+    }
+    return fluxmap;
+}
@@ -46,4 +46,30 @@ struct ScpTrack
     ScpTrackRevolution revolution[5];
 };
 
+/* The cell data for one revolution, pointing into the raw file. overflow is
+ * the number of 0x0000 cells at the end of the previous revolution(s), each
+ * of which adds 0x10000 to the first interval of this one. */
+
+struct ScpRevolutionCells
+{
+    const uint8_t* cells;
+    uint32_t count;
+    uint32_t overflow;
+};
+
+/* Converts 16-bit big-endian cells of the given resolution into bytecode (no
+ * index marks are added). */
+
+extern Bytes convertScpCells(const uint8_t* cells,
+    uint32_t count,
+    uint32_t overflow,
+    nanoseconds_t resolution);
+
+/* Converts a track's worth of revolutions into a fluxmap, with an index mark
+ * between each one. Large tracks are converted in parallel. */
+
+extern std::unique_ptr<Fluxmap> readScpRevolutions(
+    const std::vector<ScpRevolutionCells>& revolutions,
+    nanoseconds_t resolution);
+
 #endif
@@ -22,17 +22,29 @@ static uint32_t ticks_to_a2r(uint32_t ticks)
     return ticks * NS_PER_TICK / A2R_NS_PER_TICK;
 }
 
+/* Tracks are written to the file as they arrive rather than being buffered
+ * until the end, so memory use doesn't grow with the size of the image. The
+ * STRM chunk's length isn't known until the sink is closed, so it's patched
+ * in then, and the META chunk goes after it. */
+
 class A2RSink : public FluxSink
 {
 public:
     A2RSink(const std::string& filename):
-        _filename(filename),
-        _bytes{},
-        _writer(_bytes.writer())
+        _of(filename, std::ios::out | std::ios::binary)
     {
+        if (!_of.is_open())
+            error("cannot open output file");
+
         time_t now{std::time(nullptr)};
         auto t = gmtime(&now);
         _metadata["image_date"] = fmt::format("{:%FT%TZ}", *t);
+
+        writeHeader();
+        writeInfo();
+
+        _strmLengthOffset = (uint32_t)_of.tellp() + 4;
+        writeChunkHeader(A2R_CHUNK_STRM, 0);
     }
 
     ~A2RSink()
@@ -42,40 +54,43 @@ public:
         auto [minCylinder, maxCylinder, minHead, maxHead] =
             diskLayout->getPhysicalBounds();
 
-        _minCylinder = minCylinder;
-        _maxCylinder = maxCylinder;
-        _minHead = minHead;
-        _maxHead = maxHead;
-
-        log("A2R: writing A2R {} file containing {} tracks...",
-            (_minHead == _maxHead) ? "single sided" : "double sided",
-            _maxCylinder - _minCylinder + 1);
+        log("A2R: wrote A2R {} file containing {} tracks",
+            (minHead == maxHead) ? "single sided" : "double sided",
+            maxCylinder - minCylinder + 1);
 
-        writeHeader();
-        writeInfo();
-        writeStream();
+        writeStreamEnd();
         writeMeta();
-
-        std::ofstream of(_filename, std::ios::out | std::ios::binary);
-        if (!of.is_open())
-            error("cannot open output file");
-        _bytes.writeTo(of);
-        of.close();
+        _of.close();
     }
 
 private:
+    void write(const Bytes& bytes)
+    {
+        bytes.writeTo(_of);
+        if (!_of)
+            error("failed to write A2R file");
+    }
+
+    void writeChunkHeader(uint32_t chunk_id, uint32_t length)
+    {
+        Bytes header;
+        auto writer = header.writer();
+        writer.write_le32(chunk_id);
+        writer.write_le32(length);
+        write(header);
+    }
+
     void writeChunkAndData(uint32_t chunk_id, const Bytes& data)
     {
-        _writer.write_le32(chunk_id);
-        _writer.write_le32(data.size());
-        _writer += data;
+        writeChunkHeader(chunk_id, data.size());
+        write(data);
     }
 
     void writeHeader()
     {
         static const uint8_t a2r2_fileheader[] = {
             'A', '2', 'R', '2', 0xff, 0x0a, 0x0d, 0x0a};
-        _writer += Bytes(a2r2_fileheader, sizeof(a2r2_fileheader));
+        write(Bytes(a2r2_fileheader, sizeof(a2r2_fileheader)));
     }
 
     void writeInfo()
@@ -111,13 +126,20 @@ private:
         writeChunkAndData(A2R_CHUNK_META, meta);
     }
 
-    void writeStream()
+    void writeStreamEnd()
     {
         // A STRM always ends with a 255, even though this could ALSO
         // indicate the first byte of a multi-byte sequence
-        _strmWriter.write_8(255);
+        write(Bytes{255});
+        _strmLength++;
+
+        /* Now the length is known, go back and fill it in. */
 
-        writeChunkAndData(A2R_CHUNK_STRM, _strmBytes);
+        Bytes length;
+        length.writer().write_le32(_strmLength);
+        _of.seekp(_strmLengthOffset);
+        write(length);
+        _of.seekp(0, std::ios::end);
     }
 
 public:
@@ -205,30 +227,26 @@ public:
             write_flux();
         }
 
-        uint32_t chunk_size = 10 + trackBytes.size();
-
+        Bytes header;
+        auto headerWriter = header.writer();
         if (globalConfig()->drive().drive_type() == DRIVETYPE_APPLE2)
-            _strmWriter.write_8(cylinder);
+            headerWriter.write_8(cylinder);
         else
-            _strmWriter.write_8((cylinder << 1) | head);
-
-        _strmWriter.write_8(A2R_TIMING);
-        _strmWriter.write_le32(trackBytes.size());
-        _strmWriter.write_le32(ticks_to_a2r(loopPoint));
-        _strmWriter += trackBytes;
+            headerWriter.write_8((cylinder << 1) | head);
+
+        headerWriter.write_8(A2R_TIMING);
+        headerWriter.write_le32(trackBytes.size());
+        headerWriter.write_le32(ticks_to_a2r(loopPoint));
+        write(header);
+        write(trackBytes);
+        _strmLength += header.size() + trackBytes.size();
     }
 
 private:
-    std::string _filename;
-    Bytes _bytes;
-    ByteWriter _writer;
-    Bytes _strmBytes;
-    ByteWriter _strmWriter{_strmBytes.writer()};
+    std::ofstream _of;
     std::map<std::string, std::string> _metadata;
-    int _minHead;
-    int _maxHead;
-    int _minCylinder;
-    int _maxCylinder;
+    uint32_t _strmLengthOffset;
+    uint32_t _strmLength = 0;
 };
 
 class A2RFluxSinkFactory : public FluxSinkFactory
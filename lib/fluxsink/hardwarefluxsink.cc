@@ -3,6 +3,7 @@
 #include "lib/config/flags.h"
 #include "lib/data/fluxmap.h"
 #include "lib/core/logger.h"
+#include "lib/core/trace.h"
 #include "lib/config/proto.h"
 #include "lib/usb/usb.h"
 #include "lib/fluxsink/fluxsink.h"
@@ -10,15 +11,25 @@
 
 class HardwareSink : public FluxSink
 {
+public:
+    HardwareSink(): _usb(getUsb()) {}
+
     void addFlux(int track, int side, const Fluxmap& fluxmap) override
     {
         auto& drive = globalConfig()->drive();
-        usbSetDrive(drive.drive(), drive.high_density(), drive.index_mode());
-        usbSeek(track);
+        _usb.setDrive(drive.drive(), drive.high_density(), drive.index_mode());
+        {
+            TraceSpan span("seek", {{"cylinder", track}});
+            _usb.seek(track);
+        }
 
-        return usbWrite(
+        TraceSpan span("write", {{"cylinder", track}, {"head", side}});
+        return _usb.write(
             side, fluxmap.rawBytes(), drive.hard_sector_threshold_ns());
     }
+
+private:
+    USB& _usb;
 };
 
 class HardwareFluxSinkFactory : public FluxSinkFactory
@@ -24,6 +24,7 @@ cxxlibrary(
         "./hardwarefluxsource.cc",
         "./kryofluxfluxsource.cc",
         "./memoryfluxsource.cc",
+        "./prefetchingfluxsource.cc",
         "./scpfluxsource.cc",
         "./testpatternfluxsource.cc",
     ],
@@ -25,7 +25,8 @@ std::unique_ptr<FluxSource> FluxSource::create(const FluxSourceProto& config)
             return createEraseFluxSource(config.erase());
 
         case FLUXTYPE_KRYOFLUX:
-            return createKryofluxFluxSource(config.kryoflux());
+            return createPrefetchingFluxSource(
+                createKryofluxFluxSource(config.kryoflux()), config.prefetch());
 
         case FLUXTYPE_TEST_PATTERN:
             return createTestPatternFluxSource(config.test_pattern());
@@ -40,13 +41,15 @@ std::unique_ptr<FluxSource> FluxSource::create(const FluxSourceProto& config)
             return createCwfFluxSource(config.cwf());
 
         case FLUXTYPE_DMK:
-            return createDmkFluxSource(config.dmk());
+            return createPrefetchingFluxSource(
+                createDmkFluxSource(config.dmk()), config.prefetch());
 
         case FLUXTYPE_FLUX:
             return createFl2FluxSource(config.fl2());
 
         case FLUXTYPE_FLX:
-            return createFlxFluxSource(config.flx());
+            return createPrefetchingFluxSource(
+                createFlxFluxSource(config.flx()), config.prefetch());
 
         default:
             return std::unique_ptr<FluxSource>();
@@ -11,6 +11,7 @@ class Disk;
 class EraseFluxSourceProto;
 class Fl2FluxSourceProto;
 class FluxSourceProto;
+class FluxSourcePrefetchProto;
 class FluxSpec;
 class Fluxmap;
 class HardwareFluxSourceProto;
@@ -27,6 +28,16 @@ public:
 
     virtual bool hasNext() const = 0;
     virtual std::unique_ptr<const Fluxmap> next() = 0;
+
+    /* Like next(), but a source reading from a real device may stop early
+     * once isComplete returns true for the flux read so far. Everything else
+     * just reads as normal. */
+
+    virtual std::unique_ptr<const Fluxmap> nextUntilComplete(
+        const std::function<bool(const Fluxmap&)>& isComplete)
+    {
+        return next();
+    }
 };
 
 class FluxSource
@@ -56,6 +67,10 @@ private:
     static std::unique_ptr<FluxSource> createTestPatternFluxSource(
         const TestPatternFluxSourceProto& config);
 
+    static std::unique_ptr<FluxSource> createPrefetchingFluxSource(
+        std::unique_ptr<FluxSource> fluxSource,
+        const FluxSourcePrefetchProto& config);
+
 public:
     static std::unique_ptr<FluxSource> createMemoryFluxSource(
         const Disk& flux);
@@ -81,6 +96,12 @@ public:
         return readFlux(location.cylinder, location.head);
     }
 
+    /* Tells the source which locations are going to be read, and in what
+     * order, so that it can fetch them ahead of time. Most sources ignore
+     * this. */
+
+    virtual void setReadOrder(const std::vector<CylinderHead>& locations) {}
+
     /* Recalibrates; seeks to cylinder 0 and ensures the head is in the right
      * place. */
 
@@ -3,6 +3,7 @@
 #include "lib/config/flags.h"
 #include "lib/data/fluxmap.h"
 #include "lib/core/logger.h"
+#include "lib/core/trace.h"
 #include "lib/config/proto.h"
 #include "lib/usb/usb.h"
 #include "lib/fluxsource/fluxsource.h"
@@ -14,7 +15,8 @@ private:
     class HardwareFluxSourceIterator : public FluxSourceIterator
     {
     public:
-        HardwareFluxSourceIterator(int track, int head):
+        HardwareFluxSourceIterator(USB& usb, int track, int head):
+            _usb(usb),
             _track(track),
             _head(head)
         {
@@ -28,12 +30,10 @@ private:
         std::unique_ptr<const Fluxmap> next() override
         {
             const auto& drive = globalConfig()->drive();
+            selectTrack();
 
-            usbSetDrive(
-                drive.drive(), drive.high_density(), drive.index_mode());
-            usbSeek(_track);
-
-            Bytes data = usbRead(_head,
+            TraceSpan span("capture", {{"cylinder", _track}, {"head", _head}});
+            Bytes data = _usb.read(_head,
                 drive.sync_with_index(),
                 drive.revolutions() * drive.rotational_period_ms() * 1e6,
                 drive.hard_sector_threshold_ns());
@@ -42,7 +42,46 @@ private:
             return fluxmap;
         }
 
+        std::unique_ptr<const Fluxmap> nextUntilComplete(
+            const std::function<bool(const Fluxmap&)>& isComplete) override
+        {
+            const auto& drive = globalConfig()->drive();
+            if (drive.max_revolutions() <= 0)
+                return next();
+            selectTrack();
+
+            /* The flux is checked as it arrives, and the device told to stop
+             * as soon as the track is complete. */
+
+            TraceSpan span("capture", {{"cylinder", _track}, {"head", _head}});
+            Fluxmap progress;
+            Bytes data = _usb.readStreaming(_head,
+                drive.sync_with_index(),
+                drive.max_revolutions() * drive.rotational_period_ms() * 1e6,
+                drive.hard_sector_threshold_ns(),
+                [&](const Bytes& chunk)
+                {
+                    progress.appendBytes(chunk);
+                    return isComplete(progress);
+                });
+            auto fluxmap = std::make_unique<Fluxmap>();
+            fluxmap->appendBytes(data);
+            return fluxmap;
+        }
+
     private:
+        void selectTrack()
+        {
+            const auto& drive = globalConfig()->drive();
+            _usb.setDrive(
+                drive.drive(), drive.high_density(), drive.index_mode());
+
+            TraceSpan span("seek", {{"cylinder", _track}});
+            _usb.seek(_track);
+        }
+
+    private:
+        USB& _usb;
         int _track;
         int _head;
     };
@@ -55,17 +94,18 @@ public:
 public:
     std::unique_ptr<FluxSourceIterator> readFlux(int track, int head) override
     {
-        return std::make_unique<HardwareFluxSourceIterator>(track, head);
+        return std::make_unique<HardwareFluxSourceIterator>(
+            usb(), track, head);
     }
 
     void recalibrate() override
     {
-        usbRecalibrate();
+        usb().recalibrate();
     }
 
     void seek(int track) override
     {
-        usbSeek(track);
+        usb().seek(track);
     }
 
     bool isHardware() override
@@ -73,8 +113,21 @@ public:
         return true;
     }
 
+private:
+    /* The device is picked on first use rather than on construction, so that
+     * creating a source doesn't go looking for hardware. Whichever device is
+     * in use on the reading thread at that point stays with the source. */
+
+    USB& usb()
+    {
+        if (!_usb)
+            _usb = &getUsb();
+        return *_usb;
+    }
+
 private:
     const HardwareFluxSourceProto& _config;
+    USB* _usb = nullptr;
     bool _measured;
 };
 
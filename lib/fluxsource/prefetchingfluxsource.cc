@@ -0,0 +1,251 @@
+#include "lib/core/globals.h"
+#include "lib/data/fluxmap.h"
+#include "lib/data/locations.h"
+#include "lib/fluxsource/fluxsource.pb.h"
+#include "lib/fluxsource/fluxsource.h"
+#include <future>
+
+/* Wraps a source which reads a file per track, and reads (and parses) the
+ * next few tracks in the read order on background threads while the current
+ * one is being decoded. Only the first read of each track is fetched ahead of
+ * time; rereads go straight to the underlying iterator.
+ *
+ * The underlying source's readFlux() gets called from several threads at
+ * once, so this is only suitable for sources where that's safe. */
+
+namespace
+{
+    struct Prefetched
+    {
+        std::unique_ptr<FluxSourceIterator> iterator;
+        std::unique_ptr<const Fluxmap> fluxmap;
+    };
+
+    class PrefetchedFluxSourceIterator : public FluxSourceIterator
+    {
+    public:
+        PrefetchedFluxSourceIterator(std::future<Prefetched> future,
+            std::function<void(const Fluxmap&)> onConsumed):
+            _future(std::move(future)),
+            _onConsumed(onConsumed)
+        {
+        }
+
+        ~PrefetchedFluxSourceIterator()
+        {
+            try
+            {
+                wait();
+            }
+            catch (...)
+            {
+            }
+            if (_prefetched.fluxmap)
+                _onConsumed(*_prefetched.fluxmap);
+        }
+
+        bool hasNext() const override
+        {
+            wait();
+            return _prefetched.fluxmap || _prefetched.iterator->hasNext();
+        }
+
+        std::unique_ptr<const Fluxmap> next() override
+        {
+            wait();
+            if (!_prefetched.fluxmap)
+                return _prefetched.iterator->next();
+
+            _onConsumed(*_prefetched.fluxmap);
+            return std::move(_prefetched.fluxmap);
+        }
+
+    private:
+        void wait() const
+        {
+            if (_future.valid())
+                _prefetched = _future.get();
+        }
+
+    private:
+        mutable std::future<Prefetched> _future;
+        mutable Prefetched _prefetched;
+        std::function<void(const Fluxmap&)> _onConsumed;
+    };
+}
+
+class PrefetchingFluxSource : public FluxSource
+{
+public:
+    PrefetchingFluxSource(std::unique_ptr<FluxSource> fluxSource,
+        const FluxSourcePrefetchProto& config):
+        _fluxSource(std::move(fluxSource)),
+        _config(config)
+    {
+        _extraConfig = _fluxSource->getExtraConfig();
+    }
+
+    ~PrefetchingFluxSource()
+    {
+        /* Any reads still running refer to the underlying source, so they
+         * have to finish before it goes away. */
+
+        for (auto& [ch, future] : _pending)
+            future.wait();
+        for (auto& future : _discarded)
+            future.wait();
+    }
+
+public:
+    void setReadOrder(const std::vector<CylinderHead>& locations) override
+    {
+        _order = locations;
+        _position = 0;
+        for (auto& [ch, future] : _pending)
+            discard(future);
+        _pending.clear();
+        startReads();
+    }
+
+    std::unique_ptr<FluxSourceIterator> readFlux(
+        int cylinder, int head) override
+    {
+        CylinderHead ch{(unsigned)cylinder, (unsigned)head};
+
+        /* Anything earlier in the read order than this has been skipped and
+         * won't be wanted. */
+
+        auto it = std::find(_order.begin() + _position, _order.end(), ch);
+        if (it != _order.end())
+        {
+            for (auto i = _order.begin() + _position; i != it; i++)
+            {
+                auto pending = _pending.find(*i);
+                if (pending != _pending.end())
+                {
+                    discard(pending->second);
+                    _pending.erase(pending);
+                }
+            }
+            _position = it - _order.begin() + 1;
+        }
+
+        auto pending = _pending.find(ch);
+        if (pending == _pending.end())
+        {
+            startReads();
+            return _fluxSource->readFlux(cylinder, head);
+        }
+
+        auto future = std::move(pending->second);
+        _pending.erase(pending);
+        startReads();
+
+        /* The iterator may outlive the source, so it only gets the byte
+         * count. */
+
+        return std::make_unique<PrefetchedFluxSourceIterator>(std::move(future),
+            [bytesHeld = _bytesHeld](const Fluxmap& fluxmap)
+            {
+                *bytesHeld -= fluxmap.bytes();
+            });
+    }
+
+    void recalibrate() override
+    {
+        _fluxSource->recalibrate();
+    }
+
+    void seek(int cylinder) override
+    {
+        _fluxSource->seek(cylinder);
+    }
+
+private:
+    /* Unwanted reads may still be running, and waiting for them would stall
+     * the decoder, so they're parked until they finish by themselves. */
+
+    void discard(std::future<Prefetched>& future)
+    {
+        _discarded.push_back(std::move(future));
+    }
+
+    void reapDiscarded()
+    {
+        std::erase_if(_discarded,
+            [&](auto& future)
+            {
+                if (future.wait_for(std::chrono::seconds(0)) !=
+                    std::future_status::ready)
+                    return false;
+
+                try
+                {
+                    auto prefetched = future.get();
+                    if (prefetched.fluxmap)
+                        *_bytesHeld -= prefetched.fluxmap->bytes();
+                }
+                catch (...)
+                {
+                    /* Nobody wanted this track, so nobody cares that it
+                     * failed. */
+                }
+                return true;
+            });
+    }
+
+    /* Starts reading tracks ahead of the current position, until either
+     * enough are in flight or too much memory is being used by the ones which
+     * have been read but not yet consumed. As track sizes aren't known until
+     * they've been read, the budget can be overshot by a few tracks. */
+
+    void startReads()
+    {
+        reapDiscarded();
+        size_t budget = (size_t)_config.memory_budget_mb() * 1024 * 1024;
+        for (unsigned i = _position; i < _order.size(); i++)
+        {
+            if ((_pending.size() >= (unsigned)_config.tracks()) ||
+                (*_bytesHeld >= budget))
+                break;
+
+            CylinderHead ch = _order[i];
+            if (_pending.contains(ch))
+                continue;
+
+            _pending[ch] = std::async(std::launch::async,
+                [this, ch]
+                {
+                    Prefetched prefetched;
+                    prefetched.iterator =
+                        _fluxSource->readFlux(ch.cylinder, ch.head);
+                    if (prefetched.iterator->hasNext())
+                    {
+                        prefetched.fluxmap = prefetched.iterator->next();
+                        *_bytesHeld += prefetched.fluxmap->bytes();
+                    }
+                    return prefetched;
+                });
+        }
+    }
+
+private:
+    std::unique_ptr<FluxSource> _fluxSource;
+    const FluxSourcePrefetchProto& _config;
+    std::vector<CylinderHead> _order;
+    unsigned _position = 0;
+    std::map<CylinderHead, std::future<Prefetched>> _pending;
+    std::vector<std::future<Prefetched>> _discarded;
+    std::shared_ptr<std::atomic<size_t>> _bytesHeld =
+        std::make_shared<std::atomic<size_t>>(0);
+};
+
+std::unique_ptr<FluxSource> FluxSource::createPrefetchingFluxSource(
+    std::unique_ptr<FluxSource> fluxSource,
+    const FluxSourcePrefetchProto& config)
+{
+    if (config.tracks() <= 0)
+        return fluxSource;
+    return std::make_unique<PrefetchingFluxSource>(
+        std::move(fluxSource), config);
+}
@@ -8,7 +8,7 @@
 #include "lib/external/scp.h"
 #include "lib/config/proto.h"
 #include "lib/core/logger.h"
-#include <fstream>
+#include "lib/core/mappedfile.h"
 
 static int trackno(int strack)
 {
@@ -28,20 +28,15 @@ static int strackno(int track, int side)
 class ScpFluxSource : public TrivialFluxSource
 {
 public:
-    ScpFluxSource(const ScpFluxSourceProto& config): _config(config)
+    ScpFluxSource(const ScpFluxSourceProto& config):
+        _config(config),
+        _file(_config.filename())
     {
-        _if.open(_config.filename(), std::ios::in | std::ios::binary);
-        if (!_if.is_open())
-            error("cannot open input file '{}': {}",
-                _config.filename(),
-                strerror(errno));
-
-        _if.read((char*)&_header, sizeof(_header));
-        check_for_error();
-
-        if ((_header.file_id[0] != 'S') || (_header.file_id[1] != 'C') ||
-            (_header.file_id[2] != 'P'))
+        if ((_file.size() < sizeof(_header)) ||
+            (_file.data()[0] != 'S') || (_file.data()[1] != 'C') ||
+            (_file.data()[2] != 'P'))
             error("input not a SCP file");
+        memcpy(&_header, _file.data(), sizeof(_header));
 
         _extraConfig.mutable_drive()->set_drive_type(
             (_header.flags & SCP_FLAG_96TPI) ? DRIVETYPE_80TRACK
@@ -63,6 +58,8 @@ public:
         _extraConfig.mutable_drive()->set_tracks(
             convertCylinderHeadsToString(chs));
 
+        indexTracks();
+
         log("SCP tracks {}-{}, heads {}-{}",
             trackno(_header.start_track),
             trackno(_header.end_track),
@@ -75,84 +72,90 @@ public:
     std::unique_ptr<const Fluxmap> readSingleFlux(int track, int side) override
     {
         int strack = strackno(track, side);
-        if (strack >= ARRAY_SIZE(_header.track))
+        if (strack >= _tracks.size())
             return std::make_unique<Fluxmap>();
-        uint32_t offset = Bytes(_header.track[strack], 4).reader().read_le32();
-        if (offset == 0)
+        const auto& revolutions = _tracks[strack];
+        if (revolutions.empty())
             return std::make_unique<Fluxmap>();
 
-        ScpTrackHeader trackHeader;
-        _if.seekg(offset, std::ios::beg);
-        _if.read((char*)&trackHeader, sizeof(trackHeader));
-        check_for_error();
-
-        if ((trackHeader.track_id[0] != 'T') ||
-            (trackHeader.track_id[1] != 'R') ||
-            (trackHeader.track_id[2] != 'K'))
-            error("corrupt SCP file");
-
-        std::vector<ScpTrackRevolution> revs(_header.revolutions);
-        for (int revolution = 0; revolution < _header.revolutions; revolution++)
-        {
-            ScpTrackRevolution trackrev;
-            _if.read((char*)&trackrev, sizeof(trackrev));
-            check_for_error();
-            revs[revolution] = trackrev;
-        }
+        return readScpRevolutions(revolutions, _resolution);
+    }
 
-        auto fluxmap = std::make_unique<Fluxmap>();
-        nanoseconds_t pending = 0;
-        unsigned inputBytes = 0;
-        for (int revolution = 0; revolution < _header.revolutions; revolution++)
-        {
-            if (revolution != 0)
-                fluxmap->appendIndex();
+    void recalibrate() override {}
 
-            uint32_t datalength =
-                Bytes(revs[revolution].length, 4).reader().read_le32();
-            uint32_t dataoffset =
-                Bytes(revs[revolution].offset, 4).reader().read_le32();
+private:
+    /* Finds the cell data for every revolution of every track up front, so
+     * that reading a track is just a matter of converting it. */
 
-            Bytes data(datalength * 2);
-            _if.seekg(dataoffset + offset, std::ios::beg);
-            _if.read((char*)data.begin(), data.size());
-            check_for_error();
+    void indexTracks()
+    {
+        const uint8_t* base = _file.data();
+        size_t size = _file.size();
 
-            ByteReader br(data);
-            for (int cell = 0; cell < datalength; cell++)
+        _tracks.resize(ARRAY_SIZE(_header.track));
+        for (int strack = 0; strack < ARRAY_SIZE(_header.track); strack++)
+        {
+            uint32_t offset =
+                Bytes(_header.track[strack], 4).reader().read_le32();
+            if (offset == 0)
+                continue;
+
+            size_t tableSize = sizeof(ScpTrackHeader) +
+                               _header.revolutions * sizeof(ScpTrackRevolution);
+            if ((offset > size) || (tableSize > (size - offset)))
+                error("corrupt SCP file");
+
+            ScpTrackHeader trackHeader;
+            memcpy(&trackHeader, base + offset, sizeof(trackHeader));
+            if ((trackHeader.track_id[0] != 'T') ||
+                (trackHeader.track_id[1] != 'R') ||
+                (trackHeader.track_id[2] != 'K'))
+                error("corrupt SCP file");
+
+            auto& revolutions = _tracks[strack];
+            uint32_t overflow = 0;
+            for (int revolution = 0; revolution < _header.revolutions;
+                revolution++)
             {
-                uint16_t interval = br.read_be16();
-                if (interval)
-                {
-                    fluxmap->appendInterval(
-                        (interval + pending) * _resolution / NS_PER_TICK);
-                    fluxmap->appendPulse();
-                    pending = 0;
-                }
+                ScpTrackRevolution trackrev;
+                memcpy(&trackrev,
+                    base + offset + sizeof(ScpTrackHeader) +
+                        revolution * sizeof(ScpTrackRevolution),
+                    sizeof(trackrev));
+
+                uint32_t datalength =
+                    Bytes(trackrev.length, 4).reader().read_le32();
+                uint32_t dataoffset =
+                    Bytes(trackrev.offset, 4).reader().read_le32();
+                size_t start = (size_t)offset + dataoffset;
+                if ((start > size) || ((size_t)datalength * 2 > (size - start)))
+                    error("corrupt SCP file");
+
+                const uint8_t* cells = base + start;
+                revolutions.push_back({cells, datalength, overflow});
+
+                /* Any overflow cells at the end of the revolution carry over
+                 * into the next one. */
+
+                uint32_t trailing = 0;
+                while ((trailing < datalength) &&
+                       !cells[(datalength - trailing - 1) * 2] &&
+                       !cells[(datalength - trailing - 1) * 2 + 1])
+                    trailing++;
+                if (trailing == datalength)
+                    overflow += trailing;
                 else
-                    pending += 0x10000;
+                    overflow = trailing;
             }
-
-            inputBytes += datalength * 2;
         }
-
-        return fluxmap;
-    }
-
-    void recalibrate() override {}
-
-private:
-    void check_for_error()
-    {
-        if (_if.fail())
-            error("SCP read I/O error: {}", strerror(errno));
     }
 
 private:
     const ScpFluxSourceProto& _config;
-    std::ifstream _if;
+    MappedFile _file;
     ScpHeader _header;
     nanoseconds_t _resolution;
+    std::vector<std::vector<ScpRevolutionCells>> _tracks;
 };
 
 std::unique_ptr<FluxSource> FluxSource::createScpFluxSource(
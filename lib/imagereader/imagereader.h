@@ -51,6 +51,11 @@ public:
         return _extraConfig;
     }
 
+    const ImageReaderProto& getConfig() const
+    {
+        return _config;
+    }
+
     /* Reads the image. */
 
     virtual std::unique_ptr<Image> readImage() = 0;
@@ -21,6 +21,14 @@ static int sectors_per_track(int track)
     return 17;
 }
 
+static uint32_t offset_of(int track, int sectorId)
+{
+    uint32_t offset = 0;
+    for (int i = 0; i < track; i++)
+        offset += sectors_per_track(i) * 256;
+    return offset + sectorId * 256;
+}
+
 class D64ImageWriter : public ImageWriter
 {
 public:
@@ -35,22 +43,48 @@ public:
         if (!outputFile.is_open())
             error("cannot open output file");
 
-        uint32_t offset = 0;
         for (int track = 0; track < 40; track++)
         {
             int sectorCount = sectors_per_track(track);
             for (int sectorId = 0; sectorId < sectorCount; sectorId++)
-            {
-                const auto& sector = image.get(track, 0, sectorId);
-                if (sector)
-                {
-                    outputFile.seekp(offset);
-                    outputFile.write((const char*)sector->data.cbegin(),
-                        sector->data.size());
-                }
-
-                offset += 256;
-            }
+                writeSector(outputFile, image, track, sectorId);
+        }
+    }
+
+    bool updateImage(const Image& image,
+        const std::set<LogicalLocation>& locations) override
+    {
+        std::fstream outputFile(_config.filename(),
+            std::ios::in | std::ios::out | std::ios::binary);
+        if (!outputFile.is_open())
+            return false;
+
+        for (const auto& location : locations)
+        {
+            int track = location.logicalCylinder;
+            int sectorId = location.logicalSector;
+            if ((track >= 40) || (location.logicalHead != 0) ||
+                (sectorId >= sectors_per_track(track)))
+                continue;
+            writeSector(outputFile, image, track, sectorId);
+        }
+        if (!outputFile)
+            error("cannot update output file");
+
+        log("D64: updated {} sectors", locations.size());
+        return true;
+    }
+
+private:
+    void writeSector(
+        std::ostream& outputFile, const Image& image, int track, int sectorId)
+    {
+        const auto& sector = image.get(track, 0, sectorId);
+        if (sector)
+        {
+            outputFile.seekp(offset_of(track, sectorId));
+            outputFile.write(
+                (const char*)sector->data.cbegin(), sector->data.size());
         }
     }
 };
@@ -12,8 +12,7 @@
 
 static const char LABEL[] = "FluxEngine image";
 
-static void write_and_update_checksum(
-    ByteWriter& bw, uint32_t& checksum, const Bytes& data)
+static void update_checksum(uint32_t& checksum, const Bytes& data)
 {
     ByteReader br(data);
     while (!br.eof())
@@ -21,7 +20,6 @@ static void write_and_update_checksum(
         uint32_t i = br.read_be16();
         checksum += i;
         checksum = (checksum >> 1) | (checksum << 31);
-        bw.write_be16(i);
     }
 }
 
@@ -33,25 +31,7 @@ public:
     void writeImage(const Image& image) override
     {
         const Geometry& geometry = image.getGeometry();
-
-        bool mfm = false;
-
-        switch (geometry.sectorSize)
-        {
-            case 524:
-                /* GCR disk */
-                break;
-
-            case 512:
-                /* MFM disk */
-                mfm = true;
-                break;
-
-            default:
-                error(
-                    "this image is not compatible with the DiskCopy 4.2 "
-                    "format");
-        }
+        bool mfm = isMfm(geometry);
 
         log("DC42: writing DiskCopy 4.2 image");
         log("DC42: {} tracks, {} sides, {} sectors, {} bytes per sector; {}",
@@ -61,72 +41,22 @@ public:
             geometry.sectorSize,
             mfm ? "MFM" : "GCR");
 
-        auto sectors_per_track = [&](int track) -> int
-        {
-            if (mfm)
-                return geometry.numSectors;
-
-            if (track < 16)
-                return 12;
-            if (track < 32)
-                return 11;
-            if (track < 48)
-                return 10;
-            if (track < 64)
-                return 9;
-            return 8;
-        };
-
         Bytes data;
         ByteWriter bw(data);
 
         /* Write the actual sectr data. */
 
-        uint32_t dataChecksum = 0;
-        uint32_t tagChecksum = 0;
-        uint32_t offset = 0x54;
-        uint32_t sectorDataStart = offset;
-        for (int track = 0; track < geometry.numCylinders; track++)
-        {
-            for (int side = 0; side < geometry.numHeads; side++)
-            {
-                int sectorCount = sectors_per_track(track);
-                for (int sectorId = 0; sectorId < sectorCount; sectorId++)
-                {
-                    const auto& sector = image.get(track, side, sectorId);
-                    if (sector)
-                    {
-                        bw.seek(offset);
-                        write_and_update_checksum(
-                            bw, dataChecksum, sector->data.slice(0, 512));
-                    }
-                    offset += 512;
-                }
-            }
-        }
-        uint32_t sectorDataEnd = offset;
-        if (!mfm)
-        {
-            for (int track = 0; track < geometry.numCylinders; track++)
+        Checksums checksums = forEachSector(image,
+            [&](const Sector& sector, uint32_t dataOffset, uint32_t tagOffset)
             {
-                for (int side = 0; side < geometry.numHeads; side++)
+                bw.seek(dataOffset);
+                bw += sector.data.slice(0, 512);
+                if (!mfm)
                 {
-                    int sectorCount = sectors_per_track(track);
-                    for (int sectorId = 0; sectorId < sectorCount; sectorId++)
-                    {
-                        const auto& sector = image.get(track, side, sectorId);
-                        if (sector)
-                        {
-                            bw.seek(offset);
-                            write_and_update_checksum(
-                                bw, tagChecksum, sector->data.slice(512, 12));
-                        }
-                        offset += 12;
-                    }
+                    bw.seek(tagOffset);
+                    bw += sector.data.slice(512, 12);
                 }
-            }
-        }
-        uint32_t tagDataEnd = offset;
+            });
 
         /* Write the header. */
 
@@ -158,16 +88,146 @@ public:
         bw.write_8(sizeof(LABEL));
         bw.append(LABEL);
         bw.seek(0x40);
-        bw.write_be32(sectorDataEnd - sectorDataStart); /* data size */
-        bw.write_be32(tagDataEnd - sectorDataEnd);      /* tag size */
-        bw.write_be32(dataChecksum);                    /* data checksum */
-        bw.write_be32(tagChecksum);                     /* tag checksum */
-        bw.write_8(encoding);                           /* encoding */
-        bw.write_8(format);                             /* format byte */
-        bw.write_be16(0x0100);                          /* magic number */
+        bw.write_be32(checksums.dataSize);     /* data size */
+        bw.write_be32(checksums.tagSize);      /* tag size */
+        bw.write_be32(checksums.dataChecksum); /* data checksum */
+        bw.write_be32(checksums.tagChecksum);  /* tag checksum */
+        bw.write_8(encoding);                  /* encoding */
+        bw.write_8(format);                    /* format byte */
+        bw.write_be16(0x0100);                 /* magic number */
 
         data.writeToFile(_config.filename());
     }
+
+    bool updateImage(const Image& image,
+        const std::set<LogicalLocation>& locations) override
+    {
+        const Geometry& geometry = image.getGeometry();
+        bool mfm = isMfm(geometry);
+
+        std::fstream outputFile(_config.filename(),
+            std::ios::in | std::ios::out | std::ios::binary);
+        if (!outputFile.is_open())
+            return false;
+
+        /* The checksums cover the whole disk, so they're recalculated from
+         * the image while the changed sectors are patched. */
+
+        Checksums checksums = forEachSector(image,
+            [&](const Sector& sector, uint32_t dataOffset, uint32_t tagOffset)
+            {
+                if (!locations.contains(sector))
+                    return;
+                outputFile.seekp(dataOffset);
+                sector.data.slice(0, 512).writeTo(outputFile);
+                if (!mfm)
+                {
+                    outputFile.seekp(tagOffset);
+                    sector.data.slice(512, 12).writeTo(outputFile);
+                }
+            });
+
+        Bytes header;
+        ByteWriter bw(header);
+        bw.write_be32(checksums.dataChecksum);
+        bw.write_be32(checksums.tagChecksum);
+        outputFile.seekp(0x48);
+        header.writeTo(outputFile);
+        if (!outputFile)
+            error("cannot update output file");
+
+        log("DC42: updated {} sectors", locations.size());
+        return true;
+    }
+
+private:
+    struct Checksums
+    {
+        uint32_t dataSize;
+        uint32_t tagSize;
+        uint32_t dataChecksum = 0;
+        uint32_t tagChecksum = 0;
+    };
+
+    bool isMfm(const Geometry& geometry)
+    {
+        switch (geometry.sectorSize)
+        {
+            case 524:
+                /* GCR disk */
+                return false;
+
+            case 512:
+                /* MFM disk */
+                return true;
+
+            default:
+                error(
+                    "this image is not compatible with the DiskCopy 4.2 "
+                    "format");
+        }
+    }
+
+    /* Calls cb with the data and tag offsets in the file of every sector
+     * present in the image, and calculates the checksums as it goes. */
+
+    Checksums forEachSector(const Image& image,
+        const std::function<void(
+            const Sector& sector, uint32_t dataOffset, uint32_t tagOffset)>& cb)
+    {
+        const Geometry& geometry = image.getGeometry();
+        bool mfm = isMfm(geometry);
+
+        auto sectors_per_track = [&](int track) -> int
+        {
+            if (mfm)
+                return geometry.numSectors;
+
+            if (track < 16)
+                return 12;
+            if (track < 32)
+                return 11;
+            if (track < 48)
+                return 10;
+            if (track < 64)
+                return 9;
+            return 8;
+        };
+
+        unsigned sectorCount = 0;
+        for (int track = 0; track < geometry.numCylinders; track++)
+            sectorCount += sectors_per_track(track) * geometry.numHeads;
+
+        Checksums checksums;
+        checksums.dataSize = sectorCount * 512;
+        checksums.tagSize = mfm ? 0 : (sectorCount * 12);
+
+        uint32_t dataOffset = 0x54;
+        uint32_t tagOffset = dataOffset + checksums.dataSize;
+        for (int track = 0; track < geometry.numCylinders; track++)
+        {
+            for (int side = 0; side < geometry.numHeads; side++)
+            {
+                int sectorCount = sectors_per_track(track);
+                for (int sectorId = 0; sectorId < sectorCount; sectorId++)
+                {
+                    const auto& sector = image.get(track, side, sectorId);
+                    if (sector)
+                    {
+                        update_checksum(
+                            checksums.dataChecksum, sector->data.slice(0, 512));
+                        if (!mfm)
+                            update_checksum(checksums.tagChecksum,
+                                sector->data.slice(512, 12));
+                        cb(*sector, dataOffset, tagOffset);
+                    }
+                    dataOffset += 512;
+                    tagOffset += 12;
+                }
+            }
+        }
+        return checksums;
+    }
 };
 
 std::unique_ptr<ImageWriter> ImageWriter::createDiskCopyImageWriter(
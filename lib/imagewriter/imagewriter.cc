@@ -102,6 +102,8 @@ void ImageWriter::writeCsv(const Image& image, const std::string& filename)
 void ImageWriter::printMap(const Image& image)
 {
     Geometry geometry = image.getGeometry();
+    bool acceptCorrected =
+        globalConfig()->decoder().crc_correction().accept();
 
     int badSectors = 0;
     int missingSectors = 0;
@@ -151,6 +153,13 @@ void ImageWriter::printMap(const Image& image)
                             badSectors++;
                             break;
 
+                        case Sector::CORRECTED:
+                            std::cout << 'c';
+                            if (!Sector::isGoodStatus(
+                                    sector->status, acceptCorrected))
+                                badSectors++;
+                            break;
+
                         default:
                             std::cout << (int)sector->status;
                             break;
@@ -1,6 +1,8 @@
 #ifndef IMAGEWRITER_H
 #define IMAGEWRITER_H
 
+#include "lib/data/locations.h"
+
 class ImageWriterProto;
 class Image;
 class Config;
@@ -40,6 +42,22 @@ public:
 
     virtual void writeImage(const Image& sectors) = 0;
 
+    /* Writes just the given sectors into the existing image file, which must
+     * have been written from (or read into) the same image. Returns false if
+     * the format can't do this, in which case the caller should write the
+     * whole image instead. */
+
+    virtual bool updateImage(
+        const Image& sectors, const std::set<LogicalLocation>& locations)
+    {
+        return false;
+    }
+
+    const ImageWriterProto& getConfig() const
+    {
+        return _config;
+    }
+
 protected:
     const ImageWriterProto& _config;
 };
@@ -32,9 +32,65 @@ public:
         if (!outputFile.is_open())
             error("cannot open output file");
 
+        forEachSector(
+            [&](const LogicalLocation& location, unsigned offset, unsigned size)
+            {
+                const auto& sector = image.get(location);
+                if (sector)
+                {
+                    outputFile.seekp(offset);
+                    sector->data.slice(0, size).writeTo(outputFile);
+                }
+            });
+
+        log("IMG: wrote {} tracks, {} sides, {} kB total to {}",
+            tracks,
+            sides,
+            outputFile.tellp() / 1024,
+            _config.filename());
+    }
+
+    bool updateImage(const Image& image,
+        const std::set<LogicalLocation>& locations) override
+    {
+        std::fstream outputFile(_config.filename(),
+            std::ios::in | std::ios::out | std::ios::binary);
+        if (!outputFile.is_open())
+            return false;
+
+        forEachSector(
+            [&](const LogicalLocation& location, unsigned offset, unsigned size)
+            {
+                if (!locations.contains(location))
+                    return;
+                const auto& sector = image.get(location);
+                if (sector)
+                {
+                    outputFile.seekp(offset);
+                    sector->data.slice(0, size).writeTo(outputFile);
+                }
+            });
+        if (!outputFile)
+            error("cannot update output file");
+
+        log("IMG: updated {} sectors in {}",
+            locations.size(),
+            _config.filename());
+        return true;
+    }
+
+private:
+    /* Calls cb with the offset and size in the file of every sector in the
+     * layout. */
+
+    void forEachSector(const std::function<void(
+            const LogicalLocation& location, unsigned offset, unsigned size)>&
+            cb)
+    {
         const auto diskLayout = createDiskLayout();
         bool in_filesystem_order = _config.img().filesystem_sector_order();
 
+        unsigned offset = 0;
         for (auto& logicalLocation :
             in_filesystem_order ? diskLayout->logicalLocationsInFilesystemOrder
                                 : diskLayout->logicalLocations)
@@ -45,20 +101,12 @@ public:
                                          ? ltl->filesystemSectorOrder
                                          : ltl->naturalSectorOrder)
             {
-                const auto& sector = image.get(
-                    logicalLocation.cylinder, logicalLocation.head, sectorId);
-                if (sector)
-                    sector->data.slice(0, ltl->sectorSize).writeTo(outputFile);
-                else
-                    outputFile.seekp(ltl->sectorSize, std::ios::cur);
+                cb({logicalLocation.cylinder, logicalLocation.head, sectorId},
+                    offset,
+                    ltl->sectorSize);
+                offset += ltl->sectorSize;
             }
         }
-
-        log("IMG: wrote {} tracks, {} sides, {} kB total to {}",
-            tracks,
-            sides,
-            outputFile.tellp() / 1024,
-            _config.filename());
     }
 };
 
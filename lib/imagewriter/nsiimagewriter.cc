@@ -17,7 +17,6 @@ public:
     void writeImage(const Image& image) override
     {
         const Geometry& geometry = image.getGeometry();
-        bool mixedDensity = false;
 
         size_t trackSize = geometry.numSectors * geometry.sectorSize;
 
@@ -42,67 +41,106 @@ public:
         if (!outputFile.is_open())
             error("cannot open output file");
 
-        unsigned sectorFileOffset;
         for (int track = 0; track < geometry.numCylinders * geometry.numHeads;
             track++)
         {
             int side = (track < geometry.numCylinders) ? 0 : 1;
             for (int sectorId = 0; sectorId < geometry.numSectors; sectorId++)
+                writeSector(outputFile,
+                    image,
+                    track % geometry.numCylinders,
+                    side,
+                    sectorId);
+        }
+    }
+
+    bool updateImage(const Image& image,
+        const std::set<LogicalLocation>& locations) override
+    {
+        const Geometry& geometry = image.getGeometry();
+        std::fstream outputFile(_config.filename(),
+            std::ios::in | std::ios::out | std::ios::binary);
+        if (!outputFile.is_open())
+            return false;
+
+        for (const auto& location : locations)
+        {
+            if ((location.logicalCylinder >= geometry.numCylinders) ||
+                (location.logicalHead >= geometry.numHeads) ||
+                (location.logicalSector >= geometry.numSectors))
+                continue;
+            writeSector(outputFile,
+                image,
+                location.logicalCylinder,
+                location.logicalHead,
+                location.logicalSector);
+        }
+        if (!outputFile)
+            error("cannot update output file");
+
+        log("NSI: updated {} sectors", locations.size());
+        return true;
+    }
+
+private:
+    void writeSector(std::ostream& outputFile,
+        const Image& image,
+        int cylinder,
+        int side,
+        int sectorId)
+    {
+        const Geometry& geometry = image.getGeometry();
+        const auto& sector = image.get(cylinder, side, sectorId);
+        if (!sector)
+            return;
+
+        size_t trackSize = geometry.numSectors * geometry.sectorSize;
+        unsigned sectorFileOffset;
+        if (side == 0)
+        { /* Side 0 is from track 0-34 */
+            sectorFileOffset =
+                cylinder * trackSize + sectorId * geometry.sectorSize;
+        }
+        else
+        { /* Side 1 is from track 70-35 */
+            sectorFileOffset =
+                (geometry.sectorSize * geometry.numSectors *
+                    geometry.numCylinders) + /* Skip over side 0 */
+                ((geometry.numCylinders - 1) - cylinder) *
+                    (geometry.sectorSize * geometry.numSectors) +
+                (sectorId * geometry.sectorSize); /* Sector offset from
+                                                     beginning of track. */
+        }
+        outputFile.seekp(sectorFileOffset, std::ios::beg);
+        if ((geometry.sectorSize == 512) && (sector->data.size() == 256))
+        {
+            /* North Star DOS provided an upgrade path for disks formatted as
+             * single- density to hold double-density data without
+             * reformatting.  In this case, the four directory blocks will be
+             * single-density but other areas of the disk are double-density.
+             * This cannot be accurately represented using a .nsi file, so in
+             * these cases, we pad the sector to 512-bytes, filling with
+             * spaces.
+             */
+            char fill[256];
+            memset(fill, ' ', sizeof(fill));
+            if (_mixedDensity == false)
             {
-                const auto& sector =
-                    image.get(track % geometry.numCylinders, side, sectorId);
-                if (sector)
-                {
-                    if (side == 0)
-                    { /* Side 0 is from track 0-34 */
-                        sectorFileOffset =
-                            track * trackSize + sectorId * geometry.sectorSize;
-                    }
-                    else
-                    { /* Side 1 is from track 70-35 */
-                        sectorFileOffset =
-                            (geometry.sectorSize * geometry.numSectors *
-                                geometry.numCylinders) + /* Skip over side 0 */
-                            ((geometry.numCylinders - 1) -
-                                (track % geometry.numCylinders)) *
-                                (geometry.sectorSize * geometry.numSectors) +
-                            (sectorId *
-                                geometry.sectorSize); /* Sector offset from
-                                                         beginning of track. */
-                    }
-                    outputFile.seekp(sectorFileOffset, std::ios::beg);
-                    if ((geometry.sectorSize == 512) &&
-                        (sector->data.size() == 256))
-                    {
-                        /* North Star DOS provided an upgrade path for disks
-                         * formatted as single- density to hold double-density
-                         * data without reformatting.  In this case, the four
-                         * directory blocks will be single-density but other
-                         * areas of the disk are double-density.  This cannot be
-                         * accurately represented using a .nsi file, so in these
-                         * cases, we pad the sector to 512-bytes, filling with
-                         * spaces.
-                         */
-                        char fill[256];
-                        memset(fill, ' ', sizeof(fill));
-                        if (mixedDensity == false)
-                        {
-                            log("Warning: Disk contains mixed "
-                                "single/double-density sectors.");
-                        }
-                        mixedDensity = true;
-                        sector->data.slice(0, 256).writeTo(outputFile);
-                        outputFile.write(fill, sizeof(fill));
-                    }
-                    else
-                    {
-                        sector->data.slice(0, geometry.sectorSize)
-                            .writeTo(outputFile);
-                    }
-                }
+                log("Warning: Disk contains mixed "
+                    "single/double-density sectors.");
             }
+            _mixedDensity = true;
+            sector->data.slice(0, 256).writeTo(outputFile);
+            outputFile.write(fill, sizeof(fill));
+        }
+        else
+        {
+            sector->data.slice(0, geometry.sectorSize).writeTo(outputFile);
         }
     }
+
+private:
+    bool _mixedDensity = false;
 };
 
 std::unique_ptr<ImageWriter> ImageWriter::createNsiImageWriter(
@@ -189,7 +189,7 @@ public:
         }
     }
 
-    void testBulkWrite() override
+    BulkTestResult testBulkWrite() override
     {
         int max = std::stoi(sendrecv("data:?max"));
         fmt::print("Writing data: ");
@@ -213,9 +213,10 @@ public:
             max,
             int(elapsed_time * 1000.0),
             int((max / 1024.0) / elapsed_time));
+        return {.bytes = (size_t)max, .elapsed = elapsed_time};
     }
 
-    void testBulkRead() override
+    BulkTestResult testBulkRead() override
     {
         int max = std::stoi(sendrecv("data:?max"));
         fmt::print("Reading data: ");
@@ -231,6 +232,7 @@ public:
             max,
             int(elapsed_time * 1000.0),
             int((max / 1024.0) / elapsed_time));
+        return {.bytes = (size_t)max, .elapsed = elapsed_time};
     }
 
     Bytes read(int side,
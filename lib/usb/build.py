@@ -10,12 +10,19 @@ cxxlibrary(
     name="usb",
     srcs=[
         "./applesauceusb.cc",
+        "./emulateddrive.cc",
+        "./emulatedusb.cc",
         "./fluxengineusb.cc",
         "./greaseweazleusb.cc",
         "./serial.cc",
         "./usb.cc",
         "./usbfinder.cc",
     ],
-    hdrs={"lib/usb/usb.h": "./usb.h", "lib/usb/usbfinder.h": "./usbfinder.h", "lib/usb/serial.h": "./serial.h"},
+    hdrs={
+        "lib/usb/emulateddrive.h": "./emulateddrive.h",
+        "lib/usb/serial.h": "./serial.h",
+        "lib/usb/usb.h": "./usb.h",
+        "lib/usb/usbfinder.h": "./usbfinder.h",
+    },
     deps=["lib/core", "lib/config", "lib/external", "dep+libusbp_lib", "+protocol"],
 )
@@ -0,0 +1,340 @@
+#include "lib/core/globals.h"
+#include "lib/core/bytes.h"
+#include "lib/core/logger.h"
+#include "lib/external/fl2.h"
+#include "lib/external/fl2.pb.h"
+#include "lib/usb/usb.pb.h"
+#include "lib/usb/emulateddrive.h"
+#include "protocol.h"
+#include <thread>
+#include <chrono>
+
+/* Flux is handed to onData in pieces covering this much disk time. */
+static const nanoseconds_t CHUNK_TIME = 10e6;
+
+/* Unformatted tracks are noise, with transitions this far apart. */
+static const nanoseconds_t NOISE_MIN = 2e3;
+static const nanoseconds_t NOISE_MAX = 10e3;
+
+/* Parses FluxEngine bytecode into the times, in ns, of its pulses and index
+ * marks. */
+
+static void parseFlux(const Bytes& fldata,
+    std::vector<nanoseconds_t>& pulses,
+    std::vector<nanoseconds_t>& indexes)
+{
+    uint64_t ticks = 0;
+    ByteReader br(fldata);
+    while (!br.eof())
+    {
+        uint8_t b = br.read_8();
+        ticks += b & 0x3f;
+        if (b & F_BIT_INDEX)
+            indexes.push_back(ticks * NS_PER_TICK);
+        if (b & F_BIT_PULSE)
+            pulses.push_back(ticks * NS_PER_TICK);
+    }
+}
+
+EmulatedDrive::EmulatedDrive(const EmulatorProto& config):
+    _config(config),
+    _lastRealTime(getCurrentTime()),
+    _random(0)
+{
+    _nominalPeriod = 200e6;
+    if (_config.has_flux_file())
+        loadFluxFile(_config.flux_file());
+    if (_config.has_rpm())
+    {
+        if (_config.rpm() <= 0)
+            error("the emulated drive's speed must be positive");
+        _nominalPeriod = 60e9 / _config.rpm();
+    }
+    _period = _nominalPeriod;
+}
+
+void EmulatedDrive::loadFluxFile(const std::string& filename)
+{
+    auto proto = loadFl2File(filename);
+    if (proto.rotational_period_ms() > 0)
+        _nominalPeriod = proto.rotational_period_ms() * 1e6;
+
+    for (const auto& trackFlux : proto.track())
+    {
+        if (trackFlux.flux_size() == 0)
+            continue;
+
+        std::vector<nanoseconds_t> pulses;
+        std::vector<nanoseconds_t> indexes;
+        parseFlux(Bytes(trackFlux.flux(0)), pulses, indexes);
+        if (pulses.empty())
+            continue;
+
+        /* Take the first whole revolution if there is one; otherwise assume
+         * the data is a single revolution (which is what writes from an
+         * image look like). */
+
+        nanoseconds_t start = 0;
+        nanoseconds_t length = pulses.back();
+        if (indexes.size() >= 2)
+        {
+            start = indexes[0];
+            length = indexes[1] - indexes[0];
+        }
+
+        Track& track = _tracks[{trackFlux.track(), trackFlux.head()}];
+        for (nanoseconds_t t : pulses)
+        {
+            double position = (t - start) / length;
+            if ((position >= 0.0) && (position < 1.0))
+                track.push_back(position);
+        }
+    }
+
+    log("Emulator: loaded {} tracks from '{}'", _tracks.size(), filename);
+}
+
+EmulatedDrive::Track& EmulatedDrive::getTrack(int cylinder, int head)
+{
+    auto it = _tracks.find({cylinder, head});
+    if (it != _tracks.end())
+        return it->second;
+
+    /* Generate some noise. This is seeded from the location so that the
+     * same track always reads the same. */
+
+    std::mt19937 random(cylinder * 2 + head);
+    std::uniform_real_distribution<double> interval(
+        NOISE_MIN / _nominalPeriod, NOISE_MAX / _nominalPeriod);
+    Track& track = _tracks[{cylinder, head}];
+    for (double position = interval(random); position < 1.0;
+         position += interval(random))
+        track.push_back(position);
+    return track;
+}
+
+/* Brings the simulated clock up to date with however much real time has
+ * passed since it was last looked at. */
+
+void EmulatedDrive::catchUp()
+{
+    if (_config.time_scale() > 0)
+    {
+        double now = getCurrentTime();
+        _now += (now - _lastRealTime) * 1e9 / _config.time_scale();
+        _lastRealTime = now;
+    }
+    spinTo(_now);
+}
+
+void EmulatedDrive::waitUntil(nanoseconds_t time)
+{
+    if (time <= _now)
+        return;
+
+    if (_config.time_scale() > 0)
+    {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(
+            (int64_t)((time - _now) * _config.time_scale())));
+        _lastRealTime = getCurrentTime();
+    }
+    _now = time;
+}
+
+/* Moves the disk on to the revolution containing the given time, picking a
+ * slightly different speed for each one. */
+
+void EmulatedDrive::spinTo(nanoseconds_t time)
+{
+    while (time >= (_indexTime + _period))
+    {
+        _indexTime += _period;
+        double jitter = _config.rpm_jitter() * _jitter(_random);
+        _period = _nominalPeriod * std::max(1.0 + jitter, 0.5);
+    }
+}
+
+void EmulatedDrive::waitForIndex()
+{
+    catchUp();
+    waitUntil(_indexTime + _period);
+    spinTo(_now);
+}
+
+nanoseconds_t EmulatedDrive::transferTime(size_t bytes) const
+{
+    return bytes * 1e9 / (_config.bandwidth_kbps() * 1024.0);
+}
+
+void EmulatedDrive::seek(int cylinder)
+{
+    catchUp();
+    if (cylinder != _cylinder)
+    {
+        int steps = std::abs(cylinder - _cylinder);
+        waitUntil(_now + (steps * _config.seek_step_ms() +
+                             _config.seek_settle_ms()) *
+                             1e6);
+    }
+    _cylinder = cylinder;
+}
+
+void EmulatedDrive::recalibrate()
+{
+    /* The drive steps outwards until it finds track 0, which always takes at
+     * least one step. */
+
+    catchUp();
+    int steps = _cylinder + 1;
+    waitUntil(_now + (steps * _config.seek_step_ms() +
+                         _config.seek_settle_ms()) *
+                         1e6);
+    _cylinder = 0;
+}
+
+nanoseconds_t EmulatedDrive::measureRotationalPeriod()
+{
+    waitForIndex();
+    nanoseconds_t period = _period;
+    waitUntil(_indexTime + period);
+    spinTo(_now);
+    return period;
+}
+
+Bytes EmulatedDrive::read(int head,
+    bool synced,
+    nanoseconds_t readTime,
+    unsigned maxIndexes,
+    const std::function<bool(const Bytes&)>& onData)
+{
+    if ((readTime <= 0) && !maxIndexes)
+        error("emulated reads must be limited by time or by index pulses");
+
+    if (synced)
+        waitForIndex();
+    else
+        catchUp();
+
+    const Track& track = getTrack(_cylinder, head);
+    nanoseconds_t start = _now;
+    nanoseconds_t end = (readTime > 0) ? start + readTime : INFINITY;
+
+    Bytes fldata;
+    ByteWriter bw(fldata);
+    uint64_t lastTicks = 0;
+    auto emit = [&](nanoseconds_t time, uint8_t bits)
+    {
+        uint64_t ticks = (time - start) / NS_PER_TICK;
+        uint64_t delta = ticks - lastTicks;
+        while (delta > 0x3f)
+        {
+            bw.write_8(0x3f);
+            delta -= 0x3f;
+        }
+        bw.write_8(delta | bits);
+        lastTicks = ticks;
+    };
+
+    /* The device sends flux as it goes, so each chunk is ready when both the
+     * disk has got that far and the USB link has caught up. */
+
+    size_t chunkStart = 0;
+    nanoseconds_t chunkEnd = start + CHUNK_TIME;
+    bool stopped = false;
+    auto flush = [&](nanoseconds_t time)
+    {
+        waitUntil(std::max(time, start + transferTime(fldata.size())));
+        if (onData && (fldata.size() != chunkStart))
+            stopped = onData(fldata.slice(chunkStart));
+        chunkStart = fldata.size();
+    };
+    auto advance = [&](nanoseconds_t time)
+    {
+        while (!stopped && (time >= chunkEnd))
+        {
+            flush(chunkEnd);
+            chunkEnd += CHUNK_TIME;
+        }
+        return !stopped && (time < end);
+    };
+
+    unsigned indexes = 0;
+    nanoseconds_t finish = end;
+    for (;;)
+    {
+        nanoseconds_t indexTime = _indexTime;
+        nanoseconds_t period = _period;
+        if (indexTime >= start)
+        {
+            if (!advance(indexTime))
+                break;
+            emit(indexTime, F_BIT_INDEX);
+            if (maxIndexes && (++indexes == maxIndexes))
+            {
+                finish = indexTime;
+                break;
+            }
+        }
+
+        auto it = std::lower_bound(
+            track.begin(), track.end(), (start - indexTime) / period);
+        for (; it != track.end(); it++)
+        {
+            nanoseconds_t time = indexTime + *it * period;
+            if (!advance(time))
+                break;
+            emit(time, F_BIT_PULSE);
+        }
+        if (it != track.end())
+            break;
+
+        spinTo(indexTime + period);
+    }
+
+    if (!stopped)
+        flush(finish);
+    spinTo(_now);
+    return fldata;
+}
+
+void EmulatedDrive::write(int head, const Bytes& fldata)
+{
+    waitForIndex();
+
+    std::vector<nanoseconds_t> pulses;
+    std::vector<nanoseconds_t> indexes;
+    parseFlux(fldata, pulses, indexes);
+
+    Track newTrack;
+    for (nanoseconds_t t : pulses)
+    {
+        double position = t / _period;
+        if (position >= 1.0)
+            break;
+        newTrack.push_back(position);
+    }
+
+    nanoseconds_t length = pulses.empty() ? 0 : pulses.back();
+    double written = length / _period;
+    Track& track = getTrack(_cylinder, head);
+    auto it = std::upper_bound(track.begin(), track.end(), written);
+    newTrack.insert(newTrack.end(), it, track.end());
+    track = std::move(newTrack);
+
+    waitUntil(_now + std::max(length, transferTime(fldata.size())));
+    spinTo(_now);
+}
+
+void EmulatedDrive::erase(int head)
+{
+    waitForIndex();
+    getTrack(_cylinder, head).clear();
+    waitUntil(_indexTime + _period);
+    spinTo(_now);
+}
+
+void EmulatedDrive::transfer(size_t bytes)
+{
+    catchUp();
+    waitUntil(_now + transferTime(bytes));
+}
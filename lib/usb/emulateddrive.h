@@ -0,0 +1,86 @@
+#ifndef EMULATEDDRIVE_H
+#define EMULATEDDRIVE_H
+
+#include "lib/core/bytes.h"
+#include <random>
+
+class EmulatorProto;
+
+/* A model of a floppy drive with a disk in it, for the emulated devices to
+ * drive. Each track is kept as the positions of its flux transitions as
+ * fractions of a revolution, so it plays back at whatever speed the disk
+ * happens to be spinning at.
+ *
+ * The drive runs on a simulated clock: every operation moves it on by as
+ * long as the real thing would take (seeking, waiting for the index,
+ * spinning the disk, pushing data through the USB link) and then actually
+ * waits that long, scaled by time_scale. Time the host spends between
+ * operations passes on the simulated clock too, so the disk keeps turning
+ * while the host is thinking. */
+
+class EmulatedDrive
+{
+public:
+    EmulatedDrive(const EmulatorProto& config);
+
+public:
+    void seek(int cylinder);
+    void recalibrate();
+
+    /* Waits for an index pulse and times the following revolution. */
+    nanoseconds_t measureRotationalPeriod();
+
+    /* Returns flux in FluxEngine bytecode. If synced, the read starts at the
+     * next index pulse. It stops after readTime, or after maxIndexes index
+     * pulses if that's non-zero (in which case readTime may be zero for no
+     * limit). If onData is set, each chunk of flux is passed to it as it's
+     * produced; returning true stops the read. */
+
+    Bytes read(int head,
+        bool synced,
+        nanoseconds_t readTime,
+        unsigned maxIndexes = 0,
+        const std::function<bool(const Bytes&)>& onData = nullptr);
+
+    /* Writes FluxEngine bytecode, starting at the index. Anything on the
+     * track beyond the end of the new data is left alone. */
+
+    void write(int head, const Bytes& fldata);
+    void erase(int head);
+
+    /* Accounts for moving data across the emulated USB link. */
+
+    void transfer(size_t bytes);
+
+private:
+    typedef std::vector<double> Track;
+
+    Track& getTrack(int cylinder, int head);
+    void loadFluxFile(const std::string& filename);
+
+    void catchUp();
+    void waitUntil(nanoseconds_t time);
+    void waitForIndex();
+    void spinTo(nanoseconds_t time);
+    nanoseconds_t transferTime(size_t bytes) const;
+
+private:
+    const EmulatorProto& _config;
+    std::map<std::pair<int, int>, Track> _tracks;
+    int _cylinder = 0;
+
+    /* Simulated time, and the real time it was last brought up to date. */
+
+    nanoseconds_t _now = 0;
+    double _lastRealTime;
+
+    /* The start and length of the revolution the disk is currently on. */
+
+    nanoseconds_t _nominalPeriod;
+    nanoseconds_t _indexTime = 0;
+    nanoseconds_t _period;
+    std::mt19937 _random;
+    std::normal_distribution<double> _jitter;
+};
+
+#endif
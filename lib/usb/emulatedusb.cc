@@ -0,0 +1,462 @@
+#include "lib/core/globals.h"
+#include "lib/core/bytes.h"
+#include "lib/core/logger.h"
+#include "lib/config/config.h"
+#include "lib/usb/usb.h"
+#include "lib/usb/usb.pb.h"
+#include "lib/usb/emulateddrive.h"
+#include "lib/external/greaseweazle.h"
+#include "protocol.h"
+#include <thread>
+#if !defined __WIN32__
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+/* Size of the data used by the bulk transfer tests. */
+static const size_t BULK_TEST_SIZE = 1024 * 1024;
+
+/* The emulated Greaseweazle's sample clock. */
+static const uint32_t GREASEWEAZLE_FREQUENCY = 72000000;
+static const nanoseconds_t GREASEWEAZLE_CLOCK = 1e9 / GREASEWEAZLE_FREQUENCY;
+
+static BulkTestResult runBulkTest(EmulatedDrive& drive, const char* direction)
+{
+    double startTime = getCurrentTime();
+    drive.transfer(BULK_TEST_SIZE);
+    double elapsedTime = getCurrentTime() - startTime;
+
+    std::cout << fmt::format("transferred {} bytes {} in {} ms ({} kB/s)\n",
+        BULK_TEST_SIZE,
+        direction,
+        int(elapsedTime * 1000.0),
+        int((BULK_TEST_SIZE / 1024.0) / elapsedTime));
+    return {.bytes = BULK_TEST_SIZE, .elapsed = elapsedTime};
+}
+
+/* Behaves like a FluxEngine as seen from the other side of the USB
+ * interface. */
+
+class EmulatedFluxEngineUsb : public USB
+{
+public:
+    EmulatedFluxEngineUsb(const EmulatorProto& config): _drive(config) {}
+
+public:
+    void seek(int track) override
+    {
+        _drive.seek(track);
+    }
+
+    void recalibrate() override
+    {
+        _drive.recalibrate();
+    }
+
+    nanoseconds_t getRotationalPeriod(int hardSectorCount) override
+    {
+        if (hardSectorCount != 0)
+            error("hard sectors are not supported by the emulator");
+
+        /* The real device only reports whole milliseconds. */
+
+        return round(_drive.measureRotationalPeriod() / 1e6) * 1e6;
+    }
+
+    BulkTestResult testBulkWrite() override
+    {
+        std::cout << "Reading data: " << std::flush;
+        return runBulkTest(_drive, "from device -> PC");
+    }
+
+    BulkTestResult testBulkRead() override
+    {
+        std::cout << "Writing data: " << std::flush;
+        return runBulkTest(_drive, "from PC -> device");
+    }
+
+    Bytes read(int side,
+        bool synced,
+        nanoseconds_t readTime,
+        nanoseconds_t hardSectorThreshold) override
+    {
+        checkHardSectors(hardSectorThreshold);
+        return _drive.read(side, synced, readTime);
+    }
+
+    Bytes readStreaming(int side,
+        bool synced,
+        nanoseconds_t maxReadTime,
+        nanoseconds_t hardSectorThreshold,
+        const std::function<bool(const Bytes&)>& onData) override
+    {
+        checkHardSectors(hardSectorThreshold);
+        return _drive.read(side, synced, maxReadTime, 0, onData);
+    }
+
+    void write(int side,
+        const Bytes& bytes,
+        nanoseconds_t hardSectorThreshold) override
+    {
+        checkHardSectors(hardSectorThreshold);
+        _drive.write(side, bytes);
+    }
+
+    void erase(int side, nanoseconds_t hardSectorThreshold) override
+    {
+        checkHardSectors(hardSectorThreshold);
+        _drive.erase(side);
+    }
+
+    void setDrive(int drive, bool high_density, int index_mode) override {}
+
+    void measureVoltages(struct voltages_frame* voltages) override
+    {
+        error("unsupported operation on the emulator");
+    }
+
+private:
+    void checkHardSectors(nanoseconds_t hardSectorThreshold)
+    {
+        if (hardSectorThreshold != 0)
+            error("hard sectors are not supported by the emulator");
+    }
+
+private:
+    EmulatedDrive _drive;
+};
+
+#if !defined __WIN32__
+/* Turns FluxEngine bytecode into a Greaseweazle read stream. It's stateful,
+ * so that a read can be converted a piece at a time. */
+
+class GreaseweazleEncoder
+{
+public:
+    Bytes encode(const Bytes& fldata)
+    {
+        Bytes gwdata;
+        ByteWriter bw(gwdata);
+        ByteReader br(fldata);
+        while (!br.eof())
+        {
+            uint8_t b = br.read_8();
+            _ticks += b & 0x3f;
+            uint32_t now = _ticks * NS_PER_TICK / GREASEWEAZLE_CLOCK;
+
+            if (b & F_BIT_INDEX)
+            {
+                bw.write_8(255);
+                bw.write_8(FLUXOP_INDEX);
+                writeGreaseweazle28(bw, now - _cursor);
+            }
+
+            if (b & F_BIT_PULSE)
+            {
+                /* Zero ends the stream, so intervals can't be empty. */
+
+                uint32_t delta = std::max(now - _cursor, 1U);
+                if (delta < 250)
+                    bw.write_8(delta);
+                else if (delta < (250 + 5 * 255))
+                {
+                    bw.write_8(250 + (delta - 250) / 255);
+                    bw.write_8(1 + (delta - 250) % 255);
+                }
+                else
+                {
+                    bw.write_8(255);
+                    bw.write_8(FLUXOP_SPACE);
+                    writeGreaseweazle28(bw, delta - 249);
+                    bw.write_8(249);
+                }
+                _cursor += delta;
+            }
+        }
+        return gwdata;
+    }
+
+private:
+    uint64_t _ticks = 0;
+    uint32_t _cursor = 0;
+};
+
+/* Serves the Greaseweazle serial protocol on a pseudo-terminal, so that the
+ * ordinary Greaseweazle driver can talk to it. Only the parts of the protocol
+ * which the driver uses are implemented. It runs on its own thread for the
+ * rest of the program's life, like a real device would. */
+
+class GreaseweazleEmulator
+{
+public:
+    GreaseweazleEmulator(const EmulatorProto& config): _drive(config)
+    {
+        _master = posix_openpt(O_RDWR | O_NOCTTY);
+        if ((_master == -1) || grantpt(_master) || unlockpt(_master))
+            error("cannot create a pseudo-terminal for the emulator: {}",
+                strerror(errno));
+        _port = ptsname(_master);
+
+        /* Keep the slave side open, so the master doesn't see a hangup
+         * before the driver has opened it (or between reopens); and make it
+         * raw, so nothing gets echoed in the meantime. */
+
+        _slave = open(_port.c_str(), O_RDWR | O_NOCTTY);
+        if (_slave == -1)
+            error("cannot open '{}': {}", _port, strerror(errno));
+        struct termios t;
+        tcgetattr(_slave, &t);
+        cfmakeraw(&t);
+        tcsetattr(_slave, TCSANOW, &t);
+
+        std::thread(
+            [this]
+            {
+                serve();
+            })
+            .detach();
+    }
+
+    const std::string& getPort() const
+    {
+        return _port;
+    }
+
+private:
+    void serve()
+    {
+        try
+        {
+            for (;;)
+            {
+                Bytes cmd = receive(2);
+                if (cmd[1] < 2)
+                    error("bad command length");
+                cmd = cmd + receive(cmd[1] - 2);
+                execute(cmd);
+            }
+        }
+        catch (const ErrorException& e)
+        {
+            log("Greaseweazle emulator: {}", e.message);
+        }
+    }
+
+    void execute(const Bytes& cmd)
+    {
+        ByteReader br(cmd);
+        br.seek(2);
+        switch (cmd[0])
+        {
+            case CMD_GET_INFO:
+            {
+                ack(cmd);
+                Bytes info(32);
+                if (br.read_8() == GETINFO_FIRMWARE)
+                {
+                    info.writer()
+                        .write_8(1)       /* major version */
+                        .write_8(4)       /* minor version */
+                        .write_8(1)       /* main firmware */
+                        .write_8(CMD_MAX) /* max command */
+                        .write_le32(GREASEWEAZLE_FREQUENCY);
+                }
+                send(info);
+                break;
+            }
+
+            case CMD_SEEK:
+                _drive.seek((int8_t)br.read_8());
+                ack(cmd);
+                break;
+
+            case CMD_HEAD:
+                _head = br.read_8();
+                ack(cmd);
+                break;
+
+            case CMD_SELECT:
+            case CMD_DESELECT:
+            case CMD_MOTOR:
+            case CMD_SET_PIN:
+            case CMD_SET_BUS_TYPE:
+            case CMD_SET_PARAMS:
+            case CMD_RESET:
+            case CMD_GET_FLUX_STATUS:
+                ack(cmd);
+                break;
+
+            case CMD_READ_FLUX:
+                readFlux(cmd, br);
+                break;
+
+            case CMD_WRITE_FLUX:
+                writeFlux(cmd);
+                break;
+
+            case CMD_ERASE_FLUX:
+                ack(cmd);
+                _drive.erase(_head);
+                send(Bytes{0});
+                break;
+
+            case CMD_SOURCE_BYTES:
+            {
+                ack(cmd);
+                uint32_t len = br.read_le32();
+                while (len)
+                {
+                    uint32_t chunk = std::min(len, 64U * 1024);
+                    _drive.transfer(chunk);
+                    send(Bytes(chunk));
+                    len -= chunk;
+                }
+                break;
+            }
+
+            case CMD_SINK_BYTES:
+            {
+                ack(cmd);
+                uint32_t len = br.read_le32();
+                while (len)
+                {
+                    uint32_t chunk = std::min(len, 64U * 1024);
+                    receive(chunk);
+                    _drive.transfer(chunk);
+                    len -= chunk;
+                }
+                send(Bytes{0});
+                break;
+            }
+
+            default:
+                ack(cmd, ACK_BAD_COMMAND);
+                break;
+        }
+    }
+
+    void readFlux(const Bytes& cmd, ByteReader& br)
+    {
+        uint32_t ticks = (cmd.size() >= 6) ? br.read_le32() : 0;
+        uint16_t maxIndex = (cmd.size() >= 8) ? br.read_le16() : 0;
+        if (!ticks && !maxIndex)
+        {
+            ack(cmd, ACK_BAD_COMMAND);
+            return;
+        }
+
+        ack(cmd);
+        GreaseweazleEncoder encoder;
+        _drive.read(_head,
+            false,
+            ticks * GREASEWEAZLE_CLOCK,
+            maxIndex,
+            [&](const Bytes& fldata)
+            {
+                send(encoder.encode(fldata));
+                return false;
+            });
+        send(Bytes{0});
+    }
+
+    void writeFlux(const Bytes& cmd)
+    {
+        ack(cmd);
+
+        Bytes gwdata;
+        ByteWriter bw(gwdata);
+        for (;;)
+        {
+            uint8_t b = receive(1)[0];
+            if (!b)
+                break;
+            bw.write_8(b);
+            if (b == 255)
+                bw += receive(5);
+            else if (b >= 250)
+                bw += receive(1);
+        }
+
+        _drive.write(
+            _head, greaseweazleToFluxEngine(gwdata, GREASEWEAZLE_CLOCK));
+        send(Bytes{0});
+    }
+
+    void ack(const Bytes& cmd, uint8_t status = ACK_OKAY)
+    {
+        send(Bytes{cmd[0], status});
+    }
+
+    void send(const Bytes& bytes)
+    {
+        size_t ptr = 0;
+        while (ptr < bytes.size())
+        {
+            ssize_t len =
+                ::write(_master, bytes.cbegin() + ptr, bytes.size() - ptr);
+            if (len == -1)
+                error("write failed: {}", strerror(errno));
+            ptr += len;
+        }
+    }
+
+    Bytes receive(size_t count)
+    {
+        Bytes bytes(count);
+        size_t ptr = 0;
+        while (ptr < count)
+        {
+            if (_bufferPtr == _bufferFill)
+            {
+                ssize_t len = ::read(_master, _buffer, sizeof(_buffer));
+                if (len <= 0)
+                    error("read failed: {}", strerror(errno));
+                _bufferPtr = 0;
+                _bufferFill = len;
+            }
+
+            size_t len = std::min(count - ptr, _bufferFill - _bufferPtr);
+            memcpy(bytes.begin() + ptr, _buffer + _bufferPtr, len);
+            _bufferPtr += len;
+            ptr += len;
+        }
+        return bytes;
+    }
+
+private:
+    EmulatedDrive _drive;
+    int _master;
+    int _slave;
+    std::string _port;
+    int _head = 0;
+    uint8_t _buffer[4096];
+    size_t _bufferPtr = 0;
+    size_t _bufferFill = 0;
+};
+#endif
+
+USB* createEmulatedUsb(const EmulatorProto& config)
+{
+    switch (config.protocol())
+    {
+        case EmulatorProto::FLUXENGINE:
+            return new EmulatedFluxEngineUsb(config);
+
+        case EmulatorProto::GREASEWEAZLE:
+        {
+#if defined __WIN32__
+            error("the Greaseweazle emulator isn't supported on Windows");
+#else
+            /* Deliberately never freed; see above. */
+
+            auto* emulator = new GreaseweazleEmulator(config);
+            return createGreaseweazleUsb(
+                emulator->getPort(), globalConfig()->usb().greaseweazle());
+#endif
+        }
+
+        default:
+            error("unsupported emulator protocol");
+    }
+}
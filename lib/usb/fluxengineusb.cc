@@ -3,11 +3,29 @@
 #include "protocol.h"
 #include "lib/data/fluxmap.h"
 #include "lib/core/bytes.h"
+#include "lib/core/trace.h"
+#include "lib/usb/usb.pb.h"
 #include "libusbp_config.h"
 #include "libusbp.hpp"
+#include <thread>
+#include <chrono>
 
 #define MAX_TRANSFER (32 * 1024)
 
+/* libusbp has no asynchronous OUT pipes, so writes are done synchronously;
+ * making each transfer larger means fewer gaps between them in which the
+ * device's buffer can drain. */
+#define MAX_WRITE_TRANSFER (256 * 1024)
+
+/* libusbp can't block until an asynchronous transfer completes, so when
+ * nothing is ready the pipe is checked again after this long. At full speed
+ * the device takes about 25ms to fill a transfer, so with several queued this
+ * can't let the queue run dry. */
+#define RECV_POLL_INTERVAL std::chrono::milliseconds(5)
+
+/* If no transfer completes for this long, the device has gone away. */
+#define RECV_TIMEOUT 10.0
+
 /* Hacky: the board always operates in little-endian mode. */
 static uint16_t read_short_from_usb(uint16_t usb)
 {
@@ -32,57 +50,145 @@ private:
         _handle.read_pipe(FLUXENGINE_CMD_IN_EP, ptr, len, &rlen);
     }
 
+    /* Anything still queued belongs to nobody; throw it away. The pipe can't
+     * be destroyed until every transfer has come back. */
+
+    static void cancel_transfers(libusbp::async_in_pipe& pipe)
+    {
+        pipe.cancel_transfers();
+        while (pipe.has_pending_transfers())
+        {
+            pipe.handle_events();
+
+            uint8_t transfer[MAX_TRANSFER];
+            size_t rlen;
+            libusbp::error transferError;
+            while (pipe.handle_finished_transfer(
+                transfer, &rlen, &transferError))
+                ;
+            std::this_thread::sleep_for(RECV_POLL_INTERVAL);
+        }
+    }
+
     void usb_data_send(const Bytes& bytes)
     {
+        TraceSpan span("transfer");
         size_t ptr = 0;
         while (ptr < bytes.size())
         {
             size_t rlen = bytes.size() - ptr;
-            if (rlen > MAX_TRANSFER)
-                rlen = MAX_TRANSFER;
+            if (rlen > MAX_WRITE_TRANSFER)
+                rlen = MAX_WRITE_TRANSFER;
             _handle.write_pipe(
                 FLUXENGINE_DATA_OUT_EP, bytes.cbegin() + ptr, rlen, &rlen);
             ptr += rlen;
         }
     }
 
-    void usb_data_recv(Bytes& bytes)
+    /* Reads data until the device sends a short transfer or the buffer is
+     * full. Several transfers are kept queued at once, so the device always
+     * has somewhere to put its data while the previous transfer is being
+     * copied out; a single synchronous transfer leaves a gap on every
+     * round trip which the device has to absorb in its own (tiny) buffer.
+     * If onData is set, each transfer is passed to it as it arrives. */
+
+    void usb_data_recv(Bytes& bytes,
+        std::vector<double>* transferTimes = nullptr,
+        const std::function<void(const Bytes&)>& onData = nullptr)
     {
+        TraceSpan span("transfer");
+        libusbp::async_in_pipe pipe =
+            _handle.open_async_in_pipe(FLUXENGINE_DATA_IN_EP);
+        pipe.allocate_transfers(_config.transfers_in_flight(), MAX_TRANSFER);
+        pipe.start_endless_transfers();
+
         size_t ptr = 0;
-        while (ptr < bytes.size())
+        try
         {
-            size_t rlen = bytes.size() - ptr;
-            if (rlen > MAX_TRANSFER)
-                rlen = MAX_TRANSFER;
-            _handle.read_pipe(
-                FLUXENGINE_DATA_IN_EP, bytes.begin() + ptr, rlen, &rlen);
-            ptr += rlen;
-            if (rlen < MAX_TRANSFER)
-                break;
+            double startTime = getCurrentTime();
+            double lastTransferTime = startTime;
+            uint8_t transfer[MAX_TRANSFER];
+            bool finished = false;
+            while (!finished)
+            {
+                pipe.handle_events();
+
+                size_t rlen;
+                libusbp::error transferError;
+                bool progress = false;
+                while (!finished &&
+                       pipe.handle_finished_transfer(
+                           transfer, &rlen, &transferError))
+                {
+                    if (transferError)
+                        throw transferError;
+                    lastTransferTime = getCurrentTime();
+                    if (transferTimes)
+                        transferTimes->push_back(lastTransferTime - startTime);
+
+                    size_t len = std::min(rlen, bytes.size() - ptr);
+                    memcpy(bytes.begin() + ptr, transfer, len);
+                    if (onData && len)
+                        onData(bytes.slice(ptr, len));
+                    ptr += len;
+                    finished = (rlen < MAX_TRANSFER) || (ptr == bytes.size());
+                    progress = true;
+                }
+
+                if (!progress)
+                {
+                    if ((getCurrentTime() - lastTransferTime) > RECV_TIMEOUT)
+                        error("timed out waiting for data from the device");
+                    std::this_thread::sleep_for(RECV_POLL_INTERVAL);
+                }
+            }
+        }
+        catch (...)
+        {
+            /* Don't let a secondary failure hide the real one. */
+
+            try
+            {
+                cancel_transfers(pipe);
+            }
+            catch (...)
+            {
+            }
+            throw;
         }
 
+        cancel_transfers(pipe);
         bytes.resize(ptr);
+        Trace::counter("transfer bytes", ptr);
     }
 
 public:
-    FluxEngineUsb(libusbp::device& device):
+    FluxEngineUsb(libusbp::device& device, const FluxEngineProto& config):
+        _config(config),
         _device(device),
         _interface(_device, 0, false),
         _handle(_interface)
     {
-        int version = getVersion();
-        if (version != FLUXENGINE_PROTOCOL_VERSION)
+        if (_config.transfers_in_flight() < 1)
+            error("the number of USB transfers in flight must be at least 1");
+
+        _version = getVersion();
+        if ((_version < FLUXENGINE_MIN_PROTOCOL_VERSION) ||
+            (_version > FLUXENGINE_PROTOCOL_VERSION))
             error(
                 "your FluxEngine firmware is at version {} but the client is "
-                "for version {}; please upgrade",
-                version,
+                "for versions {} to {}; please upgrade",
+                _version,
+                (int)FLUXENGINE_MIN_PROTOCOL_VERSION,
                 (int)FLUXENGINE_PROTOCOL_VERSION);
     }
 
 private:
+    const FluxEngineProto& _config;
     libusbp::device _device;
     libusbp::generic_interface _interface;
     libusbp::generic_handle _handle;
+    int _version;
 
 private:
     void bad_reply(void)
@@ -164,7 +270,7 @@ public:
         return r->period_ms * 1000000;
     }
 
-    void testBulkWrite() override
+    BulkTestResult testBulkWrite() override
     {
         struct any_frame f = {
             .f = {.type = F_FRAME_BULK_WRITE_TEST_CMD, .size = sizeof(f)}
@@ -178,8 +284,9 @@ public:
 
         std::cout << "Reading data: " << std::flush;
         Bytes bulk_buffer(XSIZE * YSIZE * ZSIZE);
+        BulkTestResult result;
         double start_time = getCurrentTime();
-        usb_data_recv(bulk_buffer);
+        usb_data_recv(bulk_buffer, &result.transferTimes);
         double elapsed_time = getCurrentTime() - start_time;
 
         std::cout << "transferred " << bulk_buffer.size()
@@ -202,9 +309,12 @@ public:
                 }
 
         await_reply<struct any_frame>(F_FRAME_BULK_WRITE_TEST_REPLY);
+        result.bytes = bulk_buffer.size();
+        result.elapsed = elapsed_time;
+        return result;
     }
 
-    void testBulkRead() override
+    BulkTestResult testBulkRead() override
     {
         struct any_frame f = {
             .f = {.type = F_FRAME_BULK_READ_TEST_CMD, .size = sizeof(f)}
@@ -237,12 +347,14 @@ public:
                   << " kB/s)" << std::endl;
 
         await_reply<struct any_frame>(F_FRAME_BULK_READ_TEST_REPLY);
+        return {.bytes = bulk_buffer.size(), .elapsed = elapsed_time};
     }
 
-    Bytes read(int side,
+private:
+    void sendReadCommand(int side,
         bool synced,
         nanoseconds_t readTime,
-        nanoseconds_t hardSectorThreshold) override
+        nanoseconds_t hardSectorThreshold)
     {
         struct read_frame f = {
             .f = {.type = F_FRAME_READ_CMD, .size = sizeof(f)},
@@ -255,8 +367,15 @@ public:
         ((uint8_t*)&f.milliseconds)[0] = milliseconds;
         ((uint8_t*)&f.milliseconds)[1] = milliseconds >> 8;
         usb_cmd_send(&f, f.f.size);
+    }
 
-        auto fluxmap = std::unique_ptr<Fluxmap>(new Fluxmap);
+public:
+    Bytes read(int side,
+        bool synced,
+        nanoseconds_t readTime,
+        nanoseconds_t hardSectorThreshold) override
+    {
+        sendReadCommand(side, synced, readTime, hardSectorThreshold);
 
         Bytes buffer(1024 * 1024);
         usb_data_recv(buffer);
@@ -265,6 +384,46 @@ public:
         return buffer;
     }
 
+    Bytes readStreaming(int side,
+        bool synced,
+        nanoseconds_t maxReadTime,
+        nanoseconds_t hardSectorThreshold,
+        const std::function<bool(const Bytes&)>& onData) override
+    {
+        /* Older firmware doesn't know how to stop. */
+
+        if (_version < FLUXENGINE_STOP_READ_PROTOCOL_VERSION)
+            return USB::readStreaming(
+                side, synced, maxReadTime, hardSectorThreshold, onData);
+
+        sendReadCommand(side, synced, maxReadTime, hardSectorThreshold);
+
+        /* The device carries on sending whatever it's already got after being
+         * told to stop, so the data is drained as normal. If the read
+         * finished by itself before the stop arrived, the device ignores it.
+         */
+
+        bool stopped = false;
+        Bytes buffer(1024 * 1024);
+        usb_data_recv(buffer,
+            nullptr,
+            [&](const Bytes& chunk)
+            {
+                if (!stopped && onData(chunk))
+                {
+                    struct any_frame f = {
+                        .f = {.type = F_FRAME_STOP_READ_CMD,
+                              .size = sizeof(f)}
+                    };
+                    usb_cmd_send(&f, f.f.size);
+                    stopped = true;
+                }
+            });
+
+        await_reply<struct any_frame>(F_FRAME_READ_REPLY);
+        return buffer;
+    }
+
     void write(int side,
         const Bytes& bytes,
         nanoseconds_t hardSectorThreshold) override
@@ -352,7 +511,8 @@ public:
     }
 };
 
-USB* createFluxengineUsb(libusbp::device& device)
+USB* createFluxengineUsb(
+    libusbp::device& device, const FluxEngineProto& config)
 {
-    return new FluxEngineUsb(device);
+    return new FluxEngineUsb(device, config);
 }
@@ -2,6 +2,7 @@
 #include "protocol.h"
 #include "lib/data/fluxmap.h"
 #include "lib/core/bytes.h"
+#include "lib/core/trace.h"
 #include "lib/usb/usb.pb.h"
 #include "lib/external/greaseweazle.h"
 #include "lib/usb/serial.h"
@@ -211,7 +212,7 @@ public:
         return _revolutions;
     }
 
-    void testBulkWrite() override
+    BulkTestResult testBulkWrite() override
     {
         std::cout << "Writing data: " << std::flush;
         const int LEN = 10 * 1024 * 1024;
@@ -259,9 +260,10 @@ public:
             LEN,
             int(elapsed_time * 1000.0),
             int((LEN / 1024.0) / elapsed_time));
+        return {.bytes = (size_t)LEN, .elapsed = elapsed_time};
     }
 
-    void testBulkRead() override
+    BulkTestResult testBulkRead() override
     {
         std::cout << "Reading data: " << std::flush;
         const int LEN = 10 * 1024 * 1024;
@@ -301,6 +303,7 @@ public:
             LEN,
             int(elapsed_time * 1000.0),
             int((LEN / 1024.0) / elapsed_time));
+        return {.bytes = (size_t)LEN, .elapsed = elapsed_time};
     }
 
     Bytes read(int side,
@@ -342,17 +345,22 @@ public:
         }
 
         Bytes buffer;
-        ByteWriter bw(buffer);
-        for (;;)
         {
-            uint8_t b = _serial->readByte();
-            if (!b)
-                break;
-            bw.write_8(b);
+            TraceSpan span("transfer");
+            ByteWriter bw(buffer);
+            for (;;)
+            {
+                uint8_t b = _serial->readByte();
+                if (!b)
+                    break;
+                bw.write_8(b);
+            }
         }
+        Trace::counter("transfer bytes", buffer.size());
 
         do_command({CMD_GET_FLUX_STATUS, 2});
 
+        TraceSpan span("flux conversion");
         Bytes fldata = greaseweazleToFluxEngine(buffer, _clock);
         if (synced)
             fldata = stripPartialRotation(fldata);
@@ -378,8 +386,16 @@ public:
                 do_command({CMD_WRITE_FLUX, 4, 1, 1});
                 break;
         }
-        _serial->write(fluxEngineToGreaseweazle(fldata, _clock));
-        _serial->readByte(); /* synchronise */
+        Bytes gwdata;
+        {
+            TraceSpan span("flux conversion");
+            gwdata = fluxEngineToGreaseweazle(fldata, _clock);
+        }
+        {
+            TraceSpan span("transfer");
+            _serial->write(gwdata);
+            _serial->readByte(); /* synchronise */
+        }
 
         do_command({CMD_GET_FLUX_STATUS, 2});
     }
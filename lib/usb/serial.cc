@@ -182,7 +182,14 @@ public:
     {
         int flag = TIOCM_DTR;
         if (ioctl(_fd, TIOCMBIC, &flag) == -1)
+        {
+            /* Pseudo-terminals (such as the emulator's) have no modem
+             * control lines. */
+
+            if (errno == ENOTTY)
+                return;
             error("cannot clear DTR on serial port: {}", strerror(errno));
+        }
         usleep(200000);
         if (ioctl(_fd, TIOCMBIS, &flag) == -1)
             error("cannot set DTR on serial port: {}", strerror(errno));
@@ -12,11 +12,32 @@
 #include "lib/core/logger.h"
 #include "lib/external/applesauce.h"
 #include "lib/external/greaseweazle.h"
+#include <mutex>
 
 static USB* usb = NULL;
+static std::string usbSerial;
+
+/* Every device which has been opened, by serial number. */
+
+static std::mutex usbMutex;
+static std::map<std::string, USB*> openDevices;
+
+static thread_local USB* threadUsb = nullptr;
+static thread_local const std::string* threadSerial = nullptr;
 
 USB::~USB() {}
 
+Bytes USB::readStreaming(int side,
+    bool synced,
+    nanoseconds_t maxReadTime,
+    nanoseconds_t hardSectorThreshold,
+    const std::function<bool(const Bytes&)>& onData)
+{
+    Bytes data = read(side, synced, maxReadTime, hardSectorThreshold);
+    onData(data);
+    return data;
+}
+
 static std::shared_ptr<CandidateDevice> selectDevice()
 {
     auto candidates = findUsbDevices();
@@ -66,15 +87,53 @@ static std::shared_ptr<CandidateDevice> selectDevice()
     exit(1);
 }
 
+static USB* createUsb(CandidateDevice& candidate)
+{
+    switch (candidate.id)
+    {
+        case FLUXENGINE_ID:
+            log("Using FluxEngine {}", candidate.serial);
+            return createFluxengineUsb(
+                candidate.device, globalConfig()->usb().fluxengine());
+
+        case GREASEWEAZLE_ID:
+            log("Using Greaseweazle {} on {}",
+                candidate.serial,
+                candidate.serialPort);
+            return createGreaseweazleUsb(
+                candidate.serialPort, globalConfig()->usb().greaseweazle());
+
+        case APPLESAUCE_ID:
+            log("Using Applesauce {} on {}",
+                candidate.serial,
+                candidate.serialPort);
+            return createApplesauceUsb(
+                candidate.serialPort, globalConfig()->usb().applesauce());
+
+        default:
+            error("internal");
+    }
+}
+
 USB* get_usb_impl()
 {
     /* Special case for certain configurations. */
 
+    if (globalConfig()->usb().has_emulator())
+    {
+        const auto& conf = globalConfig()->usb().emulator();
+        log("Using emulated {}",
+            EmulatorProto::Protocol_Name(conf.protocol()));
+        usbSerial = "emulator";
+        return createEmulatedUsb(conf);
+    }
+
     if (globalConfig()->usb().has_greaseweazle() &&
         globalConfig()->usb().greaseweazle().has_port())
     {
         const auto& conf = globalConfig()->usb().greaseweazle();
         log("Using Greaseweazle on serial port {}", conf.port());
+        usbSerial = conf.port();
         return createGreaseweazleUsb(conf.port(), conf);
     }
 
@@ -83,40 +142,78 @@ USB* get_usb_impl()
     {
         const auto& conf = globalConfig()->usb().applesauce();
         log("Using Applesauce on serial port {}", conf.port());
+        usbSerial = conf.port();
         return createApplesauceUsb(conf.port(), conf);
     }
 
     /* Otherwise, select a device by USB ID. */
 
     auto candidate = selectDevice();
-    switch (candidate->id)
-    {
-        case FLUXENGINE_ID:
-            log("Using FluxEngine {}", candidate->serial);
-            return createFluxengineUsb(candidate->device);
-
-        case GREASEWEAZLE_ID:
-            log("Using Greaseweazle {} on {}",
-                candidate->serial,
-                candidate->serialPort);
-            return createGreaseweazleUsb(
-                candidate->serialPort, globalConfig()->usb().greaseweazle());
+    usbSerial = candidate->serial;
+    return createUsb(*candidate);
+}
 
-        case APPLESAUCE_ID:
-            log("Using Applesauce {} on {}",
-                candidate->serial,
-                candidate->serialPort);
-            return createApplesauceUsb(
-                candidate->serialPort, globalConfig()->usb().applesauce());
+static USB* openUsb(const std::string& serial)
+{
+    /* Each distinct serial number starting with 'emulator' gets its own
+     * emulated device. */
 
-        default:
-            error("internal");
+    if (serial.starts_with("emulator"))
+    {
+        log("Using emulated device {}", serial);
+        return createEmulatedUsb(globalConfig()->usb().emulator());
     }
+
+    for (auto& candidate : findUsbDevices())
+        if (candidate->serial == serial)
+            return createUsb(*candidate);
+    error("no device with serial number '{}' was found", serial);
 }
 
 USB& getUsb()
 {
+    if (threadUsb)
+        return *threadUsb;
+
+    std::lock_guard<std::mutex> lock(usbMutex);
     if (!usb)
+    {
         usb = get_usb_impl();
+        openDevices[usbSerial] = usb;
+    }
     return *usb;
 }
+
+USB& getUsb(const std::string& serial)
+{
+    std::lock_guard<std::mutex> lock(usbMutex);
+    auto& device = openDevices[serial];
+    if (!device)
+        device = openUsb(serial);
+    return *device;
+}
+
+const std::string& usbGetSerial()
+{
+    if (threadSerial)
+        return *threadSerial;
+
+    getUsb();
+    return usbSerial;
+}
+
+UsbBinding::UsbBinding(const std::string& serial):
+    _previousUsb(threadUsb),
+    _previousSerial(threadSerial),
+    _serial(serial)
+{
+    USB& device = getUsb(serial);
+    threadUsb = &device;
+    threadSerial = &_serial;
+}
+
+UsbBinding::~UsbBinding()
+{
+    threadUsb = _previousUsb;
+    threadSerial = _previousSerial;
+}
@@ -5,13 +5,26 @@
 #include "lib/config/flags.h"
 
 class Fluxmap;
+class FluxEngineProto;
 class GreaseweazleProto;
 class ApplesauceProto;
+class EmulatorProto;
 namespace libusbp
 {
     class device;
 }
 
+/* Timings from one run of a bandwidth test. transferTimes holds the time
+ * (relative to the start of the run) at which each individual USB transfer
+ * completed, where the backend can see them; it's used to measure jitter. */
+
+struct BulkTestResult
+{
+    size_t bytes = 0;
+    double elapsed = 0.0;
+    std::vector<double> transferTimes;
+};
+
 class USB
 {
 public:
@@ -23,12 +36,23 @@ public:
     };
     virtual void seek(int track) = 0;
     virtual nanoseconds_t getRotationalPeriod(int hardSectorCount) = 0;
-    virtual void testBulkWrite() = 0;
-    virtual void testBulkRead() = 0;
+    virtual BulkTestResult testBulkWrite() = 0;
+    virtual BulkTestResult testBulkRead() = 0;
     virtual Bytes read(int side,
         bool synced,
         nanoseconds_t readTime,
         nanoseconds_t hardSectorThreshold) = 0;
+
+    /* Like read(), but passes each piece of flux to onData as it arrives; if
+     * onData returns true, the device is asked to stop reading early. The
+     * complete flux is returned as normal. Devices which can't do this pass
+     * everything to onData in one piece at the end. */
+
+    virtual Bytes readStreaming(int side,
+        bool synced,
+        nanoseconds_t maxReadTime,
+        nanoseconds_t hardSectorThreshold,
+        const std::function<bool(const Bytes&)>& onData);
     virtual void write(
         int side, const Bytes& bytes, nanoseconds_t hardSectorThreshold) = 0;
     virtual void erase(int side, nanoseconds_t hardSectorThreshold) = 0;
@@ -39,13 +63,45 @@ protected:
     std::string usberror(int i);
 };
 
+/* Returns the device in use on this thread: the one bound with UsbBinding, if
+ * any, or else the default one, which is chosen (and opened) on first use. */
+
 extern USB& getUsb();
 
-extern USB* createFluxengineUsb(libusbp::device& device);
+/* Returns the device with the given serial number, opening it if need be.
+ * Devices keep references into the config they were opened with, so this
+ * should be called outside any ConfigBinding. */
+
+extern USB& getUsb(const std::string& serial);
+
+/* While one of these exists, getUsb() and the usb*() helpers on the thread
+ * which created it use the given device. This allows several devices to be
+ * driven at once, each from its own thread. */
+
+class UsbBinding
+{
+public:
+    UsbBinding(const std::string& serial);
+    ~UsbBinding();
+
+private:
+    USB* _previousUsb;
+    const std::string* _previousSerial;
+    std::string _serial;
+};
+
+/* The serial number of the device in use (or the port it's on, if that's all
+ * that's known). */
+
+extern const std::string& usbGetSerial();
+
+extern USB* createFluxengineUsb(
+    libusbp::device& device, const FluxEngineProto& config);
 extern USB* createGreaseweazleUsb(
     const std::string& serialPort, const GreaseweazleProto& config);
 extern USB* createApplesauceUsb(
     const std::string& serialPort, const ApplesauceProto& config);
+extern USB* createEmulatedUsb(const EmulatorProto& config);
 
 static inline void usbRecalibrate()
 {
@@ -55,13 +111,13 @@ static inline void usbSeek(int track)
 {
     getUsb().seek(track);
 }
-static inline void usbTestBulkWrite()
+static inline BulkTestResult usbTestBulkWrite()
 {
-    getUsb().testBulkWrite();
+    return getUsb().testBulkWrite();
 }
-static inline void usbTestBulkRead()
+static inline BulkTestResult usbTestBulkRead()
 {
-    getUsb().testBulkRead();
+    return getUsb().testBulkRead();
 }
 
 static inline void usbErase(int side, nanoseconds_t hardSectorThreshold)
@@ -82,6 +138,16 @@ static inline Bytes usbRead(int side,
     return getUsb().read(side, synced, readTime, hardSectorThreshold);
 }
 
+static inline Bytes usbReadStreaming(int side,
+    bool synced,
+    nanoseconds_t maxReadTime,
+    nanoseconds_t hardSectorThreshold,
+    const std::function<bool(const Bytes&)>& onData)
+{
+    return getUsb().readStreaming(
+        side, synced, maxReadTime, hardSectorThreshold, onData);
+}
+
 static inline void usbWrite(
     int side, const Bytes& bytes, nanoseconds_t hardSectorThreshold)
 {
@@ -0,0 +1,174 @@
+#include "lib/core/globals.h"
+#include "lib/vfs/vfs.h"
+#include "lib/vfs/batch.h"
+
+/* Splits a line into words, allowing double quotes around words with spaces
+ * in them. */
+
+static std::vector<std::string> tokenise(const std::string& line)
+{
+    std::vector<std::string> words;
+    unsigned i = 0;
+    for (;;)
+    {
+        while ((i < line.size()) && isspace(line[i]))
+            i++;
+        if (i == line.size())
+            break;
+
+        std::string word;
+        if (line[i] == '"')
+        {
+            auto end = line.find('"', i + 1);
+            if (end == std::string::npos)
+                throw FilesystemException("unterminated quote");
+            word = line.substr(i + 1, end - i - 1);
+            i = end + 1;
+        }
+        else
+        {
+            while ((i < line.size()) && !isspace(line[i]))
+                word += line[i++];
+        }
+        words.push_back(word);
+    }
+    return words;
+}
+
+static void checkArguments(
+    const std::vector<std::string>& words, unsigned min, unsigned max)
+{
+    unsigned count = words.size() - 1;
+    if ((count < min) || (count > max))
+        throw FilesystemException(
+            fmt::format("wrong number of arguments to '{}'", words[0]));
+}
+
+static Path parsePath(const std::string& word)
+{
+    Path path(word);
+    if (path.empty())
+        throw BadPathException();
+    return path;
+}
+
+static BatchOperation parseOperation(const std::vector<std::string>& words)
+{
+    BatchOperation op;
+    const auto& verb = words[0];
+    if (verb == "put")
+    {
+        checkArguments(words, 2, 2);
+        op.type = BatchOperation::PUT;
+        op.local = words[1];
+        op.path = parsePath(words[2]);
+    }
+    else if (verb == "get")
+    {
+        checkArguments(words, 1, 2);
+        op.type = BatchOperation::GET;
+        op.path = parsePath(words[1]);
+        op.local = (words.size() == 3) ? words[2] : op.path.back();
+    }
+    else if (verb == "rm")
+    {
+        checkArguments(words, 1, 1);
+        op.type = BatchOperation::DELETE;
+        op.path = parsePath(words[1]);
+    }
+    else if (verb == "mkdir")
+    {
+        checkArguments(words, 1, 1);
+        op.type = BatchOperation::MKDIR;
+        op.path = parsePath(words[1]);
+    }
+    else if (verb == "mv")
+    {
+        checkArguments(words, 2, 2);
+        op.type = BatchOperation::MOVE;
+        op.path = parsePath(words[1]);
+        op.newPath = parsePath(words[2]);
+    }
+    else
+        throw FilesystemException(fmt::format("unknown operation '{}'", verb));
+    return op;
+}
+
+std::vector<BatchOperation> parseBatchManifest(const std::string& text)
+{
+    std::vector<BatchOperation> operations;
+    std::stringstream ss(text);
+    std::string line;
+    unsigned lineNumber = 0;
+    while (std::getline(ss, line))
+    {
+        lineNumber++;
+        try
+        {
+            auto words = tokenise(line);
+            if (words.empty() || (words[0][0] == '#'))
+                continue;
+
+            auto op = parseOperation(words);
+            op.line = lineNumber;
+            operations.push_back(op);
+        }
+        catch (const FilesystemException& e)
+        {
+            throw FilesystemException(
+                fmt::format("line {}: {}", lineNumber, e.message));
+        }
+    }
+    return operations;
+}
+
+static void runOperation(Filesystem& filesystem, const BatchOperation& op)
+{
+    switch (op.type)
+    {
+        case BatchOperation::PUT:
+            filesystem.putFile(op.path, Bytes::readFromFile(op.local));
+            break;
+
+        case BatchOperation::GET:
+            filesystem.getFile(op.path).writeToFile(op.local);
+            break;
+
+        case BatchOperation::DELETE:
+            filesystem.deleteFile(op.path);
+            break;
+
+        case BatchOperation::MKDIR:
+            filesystem.createDirectory(op.path);
+            break;
+
+        case BatchOperation::MOVE:
+            filesystem.moveFile(op.path, op.newPath);
+            break;
+    }
+}
+
+BatchResult runBatch(
+    Filesystem& filesystem, const std::vector<BatchOperation>& operations)
+{
+    for (const auto& op : operations)
+    {
+        try
+        {
+            runOperation(filesystem, op);
+        }
+        catch (const ErrorException& e)
+        {
+            filesystem.discardChanges();
+            throw FilesystemException(
+                fmt::format("line {}: {}", op.line, e.message));
+        }
+    }
+
+    BatchResult result;
+    result.operations = operations.size();
+    result.tracks = filesystem.getChangedTracks().size();
+    if (filesystem.needsFlushing())
+        filesystem.flushChanges();
+    return result;
+}
@@ -0,0 +1,53 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "lib/vfs/vfs.h"
+
+/* One line of a batch manifest. Paths on the disk are in path and newPath;
+ * the name of the file on the host, for puts and gets, is in local. */
+
+struct BatchOperation
+{
+    enum Type
+    {
+        PUT,
+        GET,
+        DELETE,
+        MKDIR,
+        MOVE
+    };
+
+    Type type;
+    Path path;
+    Path newPath;
+    std::string local;
+    unsigned line;
+};
+
+struct BatchResult
+{
+    unsigned operations;
+    unsigned tracks;
+};
+
+/* Parses a manifest with one operation per line:
+ *
+ *     put <local file> <disk path>
+ *     get <disk path> [<local file>]
+ *     rm <disk path>
+ *     mkdir <disk path>
+ *     mv <old disk path> <new disk path>
+ *
+ * Words containing spaces can be put in double quotes. Blank lines and lines
+ * starting with # are ignored. */
+
+extern std::vector<BatchOperation> parseBatchManifest(const std::string& text);
+
+/* Applies all the operations to the filesystem and then flushes it once, so
+ * each changed track is only written once however many operations touched it.
+ * If any operation fails, nothing is written. */
+
+extern BatchResult runBatch(
+    Filesystem& filesystem, const std::vector<BatchOperation>& operations);
+
+#endif
@@ -27,9 +27,11 @@ cxxlibrary(
         "./amigaffs.cc",
         "./appledos.cc",
         "./applesingle.cc",
+        "./batch.cc",
         "./brother120fs.cc",
         "./cbmfs.cc",
         "./cpmfs.cc",
+        "./exporter.cc",
         "./fatfs.cc",
         "./fluxsectorinterface.cc",
         "./imagesectorinterface.cc",
@@ -46,6 +48,8 @@ cxxlibrary(
     ],
     hdrs={
         "lib/vfs/applesingle.h": "./applesingle.h",
+        "lib/vfs/batch.h": "./batch.h",
+        "lib/vfs/exporter.h": "./exporter.h",
         "lib/vfs/sectorinterface.h": "./sectorinterface.h",
         "lib/vfs/vfs.h": "./vfs.h",
     },
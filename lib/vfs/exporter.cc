@@ -0,0 +1,225 @@
+#include "lib/core/globals.h"
+#include "lib/vfs/vfs.h"
+#include "lib/vfs/exporter.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+/* Makes a filename on the disk safe to use on the host. */
+
+static std::string toHostFilename(std::string filename)
+{
+    if ((filename == ".") || (filename == ".."))
+        return "_";
+    std::ranges::replace(filename, '/', '_');
+    return filename;
+}
+
+static std::filesystem::path toHostPath(const Path& path)
+{
+    std::filesystem::path result;
+    for (const auto& element : path)
+        result /= element;
+    return result;
+}
+
+namespace
+{
+    class DirectoryExportSink : public ExportSink
+    {
+    public:
+        DirectoryExportSink(const std::string& directory): _root(directory)
+        {
+            std::filesystem::create_directories(_root);
+        }
+
+        void addDirectory(const Path& path) override
+        {
+            std::filesystem::create_directories(_root / toHostPath(path));
+        }
+
+        void addFile(const Path& path, const Bytes& data) override
+        {
+            auto hostPath = _root / toHostPath(path);
+            std::filesystem::create_directories(hostPath.parent_path());
+            data.writeToFile(hostPath.string());
+        }
+
+    private:
+        std::filesystem::path _root;
+    };
+
+    /* Writes POSIX ustar archives. */
+
+    class TarExportSink : public ExportSink
+    {
+    public:
+        TarExportSink(const std::string& filename):
+            _filename(filename),
+            _stream(filename, std::ios::out | std::ios::binary),
+            _mtime(time(nullptr))
+        {
+            if (!_stream.is_open())
+                error("cannot open output file '{}'", filename);
+        }
+
+        void addDirectory(const Path& path) override
+        {
+            writeHeader(path.to_str() + "/", 0755, 0, '5');
+        }
+
+        void addFile(const Path& path, const Bytes& data) override
+        {
+            writeHeader(path.to_str(), 0644, data.size(), '0');
+            data.writeTo(_stream);
+            writePadding(data.size());
+        }
+
+        void close() override
+        {
+            Bytes(1024).writeTo(_stream);
+            _stream.close();
+            if (_stream.fail())
+                error("cannot write to '{}'", _filename);
+        }
+
+    private:
+        void writeOctal(
+            ByteWriter& bw, unsigned offset, unsigned width, uint64_t value)
+        {
+            auto s = fmt::format("{:0{}o}", value, width - 1);
+            if (s.size() > (width - 1))
+                throw CannotWriteException("file too big for a tar archive");
+            bw.seek(offset);
+            bw.append(s);
+        }
+
+        void writeHeader(
+            const std::string& filename, int mode, uint64_t size, char type)
+        {
+            /* Long names are split between the prefix and name fields. */
+
+            std::string prefix;
+            std::string name = filename;
+            if (name.size() > 100)
+            {
+                auto slash = name.find('/', name.size() - 101);
+                if ((slash == std::string::npos) || (slash > 155))
+                    throw CannotWriteException(fmt::format(
+                        "'{}' is too long for a tar archive", name));
+                prefix = name.substr(0, slash);
+                name = name.substr(slash + 1);
+            }
+
+            Bytes header(512);
+            ByteWriter bw(header);
+            bw.append(name);
+            writeOctal(bw, 100, 8, mode);
+            writeOctal(bw, 108, 8, 0);
+            writeOctal(bw, 116, 8, 0);
+            writeOctal(bw, 124, 12, size);
+            writeOctal(bw, 136, 12, _mtime);
+            bw.seek(156);
+            bw.write_8(type);
+            bw.seek(257);
+            bw.append("ustar");
+            bw.seek(263);
+            bw.append("00");
+            bw.seek(345);
+            bw.append(prefix);
+
+            /* The checksum is calculated with the checksum field full of
+             * spaces. */
+
+            bw.seek(148);
+            bw.append("        ");
+            unsigned checksum = 0;
+            for (uint8_t b : header)
+                checksum += b;
+            writeOctal(bw, 148, 7, checksum);
+            bw.write_8(0);
+
+            header.writeTo(_stream);
+        }
+
+        void writePadding(size_t size)
+        {
+            if (size % 512)
+                Bytes(512 - (size % 512)).writeTo(_stream);
+        }
+
+    private:
+        std::string _filename;
+        std::ofstream _stream;
+        time_t _mtime;
+    };
+}
+
+std::unique_ptr<ExportSink> ExportSink::createDirectoryExportSink(
+    const std::string& directory)
+{
+    return std::make_unique<DirectoryExportSink>(directory);
+}
+
+std::unique_ptr<ExportSink> ExportSink::createTarExportSink(
+    const std::string& filename)
+{
+    return std::make_unique<TarExportSink>(filename);
+}
+
+static void exportDirectory(Filesystem& filesystem,
+    const Path& path,
+    const Path& relativePath,
+    ExportSink& sink,
+    std::vector<ExportedFile>& results)
+{
+    for (const auto& dirent : filesystem.list(path))
+    {
+        ExportedFile file;
+        file.path = dirent->path.empty() ? path.concat(dirent->filename)
+                                         : dirent->path;
+        file.fileType = dirent->file_type;
+        file.length = dirent->length;
+        file.status = FS_OK;
+        file.badSectors = 0;
+
+        Path relative =
+            relativePath.concat(toHostFilename(dirent->filename));
+        filesystem.clearBadSectorsRead();
+        try
+        {
+            if (dirent->file_type == TYPE_DIRECTORY)
+            {
+                sink.addDirectory(relative);
+                exportDirectory(
+                    filesystem, file.path, relative, sink, results);
+                continue;
+            }
+
+            auto data = filesystem.getFile(file.path);
+            file.length = data.size();
+            sink.addFile(relative, data);
+        }
+        catch (const FilesystemException& e)
+        {
+            file.status = FS_BAD;
+            file.error = e.message;
+        }
+
+        file.badSectors = filesystem.getBadSectorsRead().size();
+        if (file.badSectors && (file.status == FS_OK))
+            file.status = FS_OK_BUT_USED_BAD_SECTORS;
+        results.push_back(file);
+    }
+}
+
+std::vector<ExportedFile> exportFilesystem(
+    Filesystem& filesystem, const Path& root, ExportSink& sink)
+{
+    filesystem.prefetch();
+
+    std::vector<ExportedFile> results;
+    exportDirectory(filesystem, root, Path(), sink, results);
+    sink.close();
+    return results;
+}
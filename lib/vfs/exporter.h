@@ -0,0 +1,53 @@
+#ifndef EXPORTER_H
+#define EXPORTER_H
+
+#include "lib/vfs/vfs.h"
+
+/* Somewhere for exportFilesystem() to put the files it finds. Paths are
+ * relative to the directory being exported. */
+
+class ExportSink
+{
+public:
+    virtual ~ExportSink() {}
+
+public:
+    virtual void addDirectory(const Path& path) = 0;
+    virtual void addFile(const Path& path, const Bytes& data) = 0;
+
+    /* Called once everything has been added. */
+    virtual void close() {}
+
+public:
+    /* Writes files into a directory tree on the host. */
+    static std::unique_ptr<ExportSink> createDirectoryExportSink(
+        const std::string& directory);
+
+    /* Writes files into a tar archive. */
+    static std::unique_ptr<ExportSink> createTarExportSink(
+        const std::string& filename);
+};
+
+struct ExportedFile
+{
+    Path path;
+    FileType fileType;
+    uint32_t length;
+
+    /* FS_OK if the file was read cleanly; FS_OK_BUT_USED_BAD_SECTORS if it
+     * was exported but some of its sectors were bad or missing; FS_BAD if it
+     * couldn't be read at all, in which case error says why. */
+
+    FilesystemStatus status;
+    unsigned badSectors;
+    std::string error;
+};
+
+/* Exports everything under root, recursively. The whole disk is read in one
+ * pass first, so that fetching the individual files doesn't have to go back
+ * to it. Files which can't be read are skipped, and reported as FS_BAD. */
+
+extern std::vector<ExportedFile> exportFilesystem(
+    Filesystem& filesystem, const Path& root, ExportSink& sink);
+
+#endif
@@ -57,6 +57,11 @@ public:
         return !_changedTracks.empty();
     }
 
+    std::set<CylinderHead> getChangedTracks() override
+    {
+        return _changedTracks;
+    }
+
     void flushChanges() override
     {
         std::vector<CylinderHead> locations;
@@ -106,6 +111,26 @@ public:
         discardChanges();
     }
 
+    void prefetch() override
+    {
+        if (!_fluxSource)
+            return;
+
+        std::vector<std::shared_ptr<const LogicalTrackLayout>> tracks;
+        for (const auto& [location, ltl] : _diskLayout->layoutByLogicalLocation)
+            if (_loadedTracks.find(location) == _loadedTracks.end())
+                tracks.push_back(ltl);
+        std::ranges::sort(tracks,
+            [](const auto& a, const auto& b)
+            {
+                return std::tie(a->physicalCylinder, a->physicalHead) <
+                       std::tie(b->physicalCylinder, b->physicalHead);
+            });
+
+        for (const auto& ltl : tracks)
+            populateSectors(ltl->logicalCylinder, ltl->logicalHead);
+    }
+
     void discardChanges() override
     {
         _loadedTracks.clear();
@@ -7,6 +7,11 @@
 #include "lib/data/sector.h"
 #include "lib/core/bytes.h"
 
+/* Keeps the whole image in memory. Changed sectors are remembered, along with
+ * what they used to contain, so that discarding changes doesn't need to read
+ * the image again and (for formats which support it) flushing only needs to
+ * write the changed sectors back. */
+
 class ImageSectorInterface : public SectorInterface
 {
 public:
@@ -17,7 +22,21 @@ public:
         _reader(reader),
         _writer(writer)
     {
-        discardChanges();
+        if (_reader)
+        {
+            _image = _reader->readImage();
+
+            /* If the image is being written back to where it came from, the
+             * file can be updated in place. */
+
+            _fileIsCurrent = _writer && (_reader->getConfig().filename() ==
+                                            _writer->getConfig().filename());
+        }
+        else
+        {
+            _image = std::make_shared<Image>();
+            _image->addMissingSectors(*_diskLayout);
+        }
     }
 
 public:
@@ -30,8 +49,14 @@ public:
     std::shared_ptr<Sector> put(
         unsigned track, unsigned side, unsigned sectorId) override
     {
-        _changed = true;
-        return _image->put(track, side, sectorId);
+        LogicalLocation location = {track, side, sectorId};
+        if (!_originalSectors.contains(location))
+        {
+            auto sector = _image->get(location);
+            _originalSectors[location] =
+                sector ? std::make_shared<Sector>(*sector) : nullptr;
+        }
+        return _image->put(location);
     }
 
     virtual bool isReadOnly() override
@@ -41,25 +66,39 @@ public:
 
     bool needsFlushing() override
     {
-        return _changed;
+        return !_originalSectors.empty();
+    }
+
+    std::set<CylinderHead> getChangedTracks() override
+    {
+        std::set<CylinderHead> tracks;
+        for (const auto& [location, sector] : _originalSectors)
+            tracks.insert(location.trackLocation());
+        return tracks;
     }
 
     void flushChanges() override
     {
-        _writer->writeImage(*_image);
-        _changed = false;
+        std::set<LogicalLocation> locations;
+        for (const auto& [location, sector] : _originalSectors)
+            locations.insert(location);
+
+        if (!_fileIsCurrent || !_writer->updateImage(*_image, locations))
+            _writer->writeImage(*_image);
+        _fileIsCurrent = true;
+        _originalSectors.clear();
     }
 
     void discardChanges() override
     {
-        if (_reader)
-            _image = _reader->readImage();
-        else
+        for (const auto& [location, sector] : _originalSectors)
         {
-            _image = std::make_shared<Image>();
-            _image->addMissingSectors(*_diskLayout);
+            if (sector)
+                *_image->put(location) = *sector;
+            else
+                _image->erase(location);
         }
-        _changed = false;
+        _originalSectors.clear();
     }
 
 private:
@@ -67,7 +106,8 @@ private:
     std::shared_ptr<const DiskLayout> _diskLayout;
     std::shared_ptr<ImageReader> _reader;
     std::shared_ptr<ImageWriter> _writer;
-    bool _changed = false;
+    std::map<LogicalLocation, std::shared_ptr<const Sector>> _originalSectors;
+    bool _fileIsCurrent = false;
 };
 
 std::unique_ptr<SectorInterface> SectorInterface::createImageSectorInterface(
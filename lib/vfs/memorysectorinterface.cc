@@ -25,7 +25,7 @@ public:
     std::shared_ptr<Sector> put(
         unsigned track, unsigned side, unsigned sectorId) override
     {
-        _changed = true;
+        _changedTracks.insert({track, side});
         return _liveImage->put(track, side, sectorId);
     }
 
@@ -36,7 +36,12 @@ public:
 
     bool needsFlushing() override
     {
-        return _changed;
+        return !_changedTracks.empty();
+    }
+
+    std::set<CylinderHead> getChangedTracks() override
+    {
+        return _changedTracks;
     }
 
     void flushChanges() override
@@ -48,7 +53,7 @@ public:
                 sector->logicalSector);
             *s = *sector;
         }
-        _changed = false;
+        _changedTracks.clear();
     }
 
     void discardChanges() override
@@ -61,13 +66,13 @@ public:
                 sector->logicalSector);
             *s = *sector;
         }
-        _changed = false;
+        _changedTracks.clear();
     }
 
 private:
     std::shared_ptr<Image> _backupImage;
     std::shared_ptr<Image> _liveImage;
-    bool _changed = false;
+    std::set<CylinderHead> _changedTracks;
 };
 
 std::unique_ptr<SectorInterface> SectorInterface::createMemorySectorInterface(
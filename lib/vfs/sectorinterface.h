@@ -1,6 +1,8 @@
 #ifndef SECTORINTERFACE_H
 #define SECTORINTERFACE_H
 
+#include "lib/data/locations.h"
+
 class Image;
 class ImageReader;
 class ImageWriter;
@@ -32,8 +34,18 @@ public:
         return false;
     }
 
+    /* Which tracks the pending changes touch. */
+    virtual std::set<CylinderHead> getChangedTracks()
+    {
+        return {};
+    }
+
     virtual void flushChanges() {}
 
+    /* Reads the whole disk in one pass, in physical order, so that later
+     * accesses don't need to go back to it. */
+    virtual void prefetch() {}
+
     virtual void discardChanges() {}
 
 public:
@@ -146,6 +146,11 @@ bool Filesystem::needsFlushing()
     return _sectors->needsFlushing();
 }
 
+std::set<CylinderHead> Filesystem::getChangedTracks()
+{
+    return _sectors->getChangedTracks();
+}
+
 void Filesystem::flushChanges()
 {
     _sectors->flushChanges();
@@ -156,6 +161,21 @@ void Filesystem::discardChanges()
     _sectors->discardChanges();
 }
 
+void Filesystem::prefetch()
+{
+    _sectors->prefetch();
+}
+
+const std::set<LogicalLocation>& Filesystem::getBadSectorsRead() const
+{
+    return _badSectorsRead;
+}
+
+void Filesystem::clearBadSectorsRead()
+{
+    _badSectorsRead.clear();
+}
+
 Filesystem::Filesystem(const std::shared_ptr<const DiskLayout>& diskLayout,
     std::shared_ptr<SectorInterface> sectors):
     _diskLayout(diskLayout),
@@ -272,9 +292,18 @@ std::unique_ptr<Filesystem> Filesystem::createFilesystemFromConfig()
         globalConfig()->filesystem(), diskLayout, sectorInterface);
 }
 
+static bool isGood(const std::shared_ptr<const Sector>& sector)
+{
+    return sector &&
+           Sector::isGoodStatus(sector->status,
+               globalConfig()->decoder().crc_correction().accept());
+}
+
 Bytes Filesystem::getSector(unsigned track, unsigned side, unsigned sector)
 {
     auto s = _sectors->get(track, side, sector);
+    if (!isGood(s))
+        _badSectorsRead.insert({track, side, sector});
     if (!s)
         throw BadFilesystemException();
     return s->data;
@@ -295,8 +324,13 @@ Bytes Filesystem::getLogicalSector(uint32_t number, uint32_t count)
         auto& [cylinder, head, sectorId] =
             _diskLayout->logicalSectorLocationsInFilesystemOrder.at(number + i);
         auto& ltl = _diskLayout->layoutByLogicalLocation.at({cylinder, head});
-        bw += _sectors->get(cylinder, head, sectorId)
-                  ->data.slice(0, ltl->sectorSize);
+        auto sector = _sectors->get(cylinder, head, sectorId);
+        if (!isGood(sector))
+            _badSectorsRead.insert({cylinder, head, sectorId});
+        if (!sector)
+            throw ReadErrorException(fmt::format(
+                "sector c{}h{}s{} is missing", cylinder, head, sectorId));
+        bw += sector->data.slice(0, ltl->sectorSize);
     }
     return data;
 }
@@ -2,6 +2,7 @@
 #define VFS_H
 
 #include "lib/core/bytes.h"
+#include "lib/data/locations.h"
 #include "fmt/format.h"
 
 class Brother120Proto;
@@ -218,12 +219,23 @@ public:
     /* Does this filesystem need flushing? */
     bool needsFlushing();
 
+    /* Which tracks will be written by the next flush? */
+    std::set<CylinderHead> getChangedTracks();
+
     /* Flushes any changes back to the disk. */
     void flushChanges();
 
     /* Discards any pending changes. */
     void discardChanges();
 
+    /* Reads the whole disk into memory in one pass. */
+    void prefetch();
+
+    /* Which bad or missing sectors have been read since the last call to
+     * clearBadSectorsRead()? */
+    const std::set<LogicalLocation>& getBadSectorsRead() const;
+    void clearBadSectorsRead();
+
 public:
     Filesystem(const std::shared_ptr<const DiskLayout>& diskLayout,
         std::shared_ptr<SectorInterface> sectors);
@@ -246,6 +258,7 @@ protected:
 
 private:
     std::shared_ptr<SectorInterface> _sectors;
+    std::set<LogicalLocation> _badSectorsRead;
 
 public:
     static std::unique_ptr<Filesystem> createBrother120Filesystem(
@@ -3,7 +3,14 @@
 
 enum 
 {
-    FLUXENGINE_PROTOCOL_VERSION = 17,
+    FLUXENGINE_PROTOCOL_VERSION = 18,
+
+    /* The oldest firmware the client will still talk to. Version 17 lacks
+     * F_FRAME_STOP_READ_CMD, so reads with it always run to the end. */
+    FLUXENGINE_MIN_PROTOCOL_VERSION = 17,
+
+    /* The first version which understands F_FRAME_STOP_READ_CMD. */
+    FLUXENGINE_STOP_READ_PROTOCOL_VERSION = 18,
 
     FLUXENGINE_VID = 0x1209,
     FLUXENGINE_PID = 0x6e00,
@@ -67,6 +74,7 @@ enum
     F_FRAME_SET_DRIVE_REPLY,      /* any_frame */
     F_FRAME_MEASURE_VOLTAGES_CMD, /* any_frame */
     F_FRAME_MEASURE_VOLTAGES_REPLY, /* voltages_frame */
+    F_FRAME_STOP_READ_CMD,        /* any_frame; sent during a read, no reply */
 };
 
 enum
@@ -11,6 +11,7 @@ dir="$6"
 srcfile=$dir/src.img
 fluxfile=$dir/flux.$ext
 destfile=$dir/dest.img
+fixedfile=$dir/fixed.img
 
 dd if=/dev/urandom of=$srcfile bs=1048576 count=2 2>&1
 
@@ -30,5 +31,15 @@ if ! cmp $srcfile $destfile; then
 	echo "./scripts/encodedecodetest.sh \"$1\" \"$2\" \"$3\" \"$4\" \"$5\" \"$6\"" >&2
 	exit 1
 fi
+
+# The fixed-point PLL must decode exactly what the floating-point one does.
+echo $fluxengine read -c $format -s $fluxfile -o $fixedfile --drive.rotational_period_ms=200 --decoder.fixed_point_pll=true $flags
+$fluxengine read -c $format -s $fluxfile -o $fixedfile --drive.rotational_period_ms=200 --decoder.fixed_point_pll=true $flags
+if ! cmp $destfile $fixedfile; then
+	echo "Fixed-point PLL disagrees with floating point!" >&2
+	echo "Run this to repeat:" >&2
+	echo "./scripts/encodedecodetest.sh \"$1\" \"$2\" \"$3\" \"$4\" \"$5\" \"$6\"" >&2
+	exit 1
+fi
 exit 0
 
@@ -30,6 +30,16 @@ void renderLogMessage(
 {
 }
 
+void renderLogMessage(
+    LogRenderer& r, std::shared_ptr<const VerifyTrackLogMessage> m)
+{
+}
+
+void renderLogMessage(
+    LogRenderer& r, std::shared_ptr<const ParameterSweepLogMessage> m)
+{
+}
+
 void renderLogMessage(
     LogRenderer& r, std::shared_ptr<const BeginReadOperationLogMessage> m)
 {
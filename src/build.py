@@ -9,7 +9,9 @@ cxxprogram(
         "./fluxfile.h",
         "./fe-analysedriveresponse.cc",
         "./fe-analyselayout.cc",
+        "./fe-batch.cc",
         "./fe-convert.cc",
+        "./fe-export.cc",
         "./fe-format.cc",
         "./fe-fluxfilels.cc",
         "./fe-fluxfilerm.cc",
@@ -17,6 +19,7 @@ cxxprogram(
         "./fe-getdiskinfo.cc",
         "./fe-getfile.cc",
         "./fe-getfileinfo.cc",
+        "./fe-identify.cc",
         "./fe-inspect.cc",
         "./fe-ls.cc",
         "./fe-mkdir.cc",
@@ -5,6 +5,7 @@
 #include "lib/core/bitmap.h"
 #include "lib/data/fluxmap.h"
 #include "lib/data/fluxmapreader.h"
+#include "lib/data/fluxhistogram.h"
 #include "protocol.h"
 #include "lib/config/proto.h"
 #include "lib/fluxsink/fluxsink.h"
@@ -299,19 +300,13 @@ int mainAnalyseDriveResponse(int argc, const char* argv[])
             Fluxmap inFluxmap;
             inFluxmap.appendBytes(usbRead(tracks[0].head, true, period, 0));
 
-            /* Compute histogram. */
+            /* Compute histogram, skipping the first 10% and last 10% as they
+             * contain junk. */
 
-            FluxmapReader fmr(inFluxmap);
-            fmr.seek((double)period *
-                     0.1); /* skip first 10% and last 10% as contains junk */
-            fmr.skipToEvent(F_BIT_PULSE);
-            while (fmr.tell().ns() < ((double)period * 0.9))
-            {
-                unsigned ticks;
-                fmr.findEvent(F_BIT_PULSE, ticks);
-                if (ticks < numColumns)
-                    frequencies[row][ticks]++;
-            }
+            FluxHistogram histogram(
+                inFluxmap, {period * 0.1, period * 0.9}, numColumns);
+            for (int i = 0; i < numColumns; i++)
+                frequencies[row][i] = histogram[i];
         }
 
         /* Compute mean and normalise. */
@@ -0,0 +1,44 @@
+#include "lib/core/globals.h"
+#include "lib/config/flags.h"
+#include "lib/config/proto.h"
+#include "fluxengine.h"
+#include "lib/vfs/vfs.h"
+#include "lib/vfs/batch.h"
+#include "src/fileutils.h"
+
+static FlagGroup flags({&fileFlags});
+
+static StringFlag manifest({"-m", "--manifest"},
+    "file containing the operations to perform (or - for stdin)",
+    "");
+
+int mainBatch(int argc, const char* argv[])
+{
+    if (argc == 1)
+        showProfiles("batch", formats);
+    flags.parseFlagsWithConfigFiles(argc, argv, formats);
+
+    try
+    {
+        std::string text;
+        if (manifest.get() == "-")
+            text = std::string(std::istreambuf_iterator<char>(std::cin), {});
+        else if (!manifest.get().empty())
+            text = Bytes::readFromFile(manifest);
+        else
+            error("you must supply a manifest of operations to perform");
+
+        auto operations = parseBatchManifest(text);
+        auto filesystem = Filesystem::createFilesystemFromConfig();
+        auto result = runBatch(*filesystem, operations);
+        fmt::print("{} operations performed; {} tracks written\n",
+            result.operations,
+            result.tracks);
+    }
+    catch (const FilesystemException& e)
+    {
+        error("{}", e.message);
+    }
+
+    return 0;
+}
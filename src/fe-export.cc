@@ -0,0 +1,82 @@
+#include "lib/core/globals.h"
+#include "lib/config/flags.h"
+#include "lib/config/proto.h"
+#include "fluxengine.h"
+#include "lib/vfs/vfs.h"
+#include "lib/vfs/exporter.h"
+#include "lib/core/utils.h"
+#include "src/fileutils.h"
+
+static FlagGroup flags({&fileFlags});
+
+static StringFlag directory({"-p", "--path"}, "disk path to export", "");
+static StringFlag output(
+    {"-l", "--local"}, "local directory to write files to", ".");
+static StringFlag tar({"--tar"}, "write files to this tar archive instead", "");
+
+static char statusChar(FilesystemStatus status)
+{
+    switch (status)
+    {
+        case FS_OK:
+            return ' ';
+
+        case FS_OK_BUT_USED_BAD_SECTORS:
+            return 'B';
+
+        default:
+            return 'X';
+    }
+}
+
+int mainExport(int argc, const char* argv[])
+{
+    if (argc == 1)
+        showProfiles("export", formats);
+    flags.parseFlagsWithConfigFiles(argc, argv, formats);
+
+    std::vector<ExportedFile> files;
+    try
+    {
+        auto filesystem = Filesystem::createFilesystemFromConfig();
+        auto sink = tar.get().empty()
+                        ? ExportSink::createDirectoryExportSink(output)
+                        : ExportSink::createTarExportSink(tar);
+        files = exportFilesystem(*filesystem, Path(directory), *sink);
+    }
+    catch (const FilesystemException& e)
+    {
+        error("{}", e.message);
+    }
+
+    /* B means the file was exported but some of its data is bad; X means it
+     * couldn't be exported at all. */
+
+    int bad = 0;
+    int failed = 0;
+    for (const auto& file : files)
+    {
+        fmt::print("{} {:6} {}{}",
+            statusChar(file.status),
+            file.length,
+            quote(file.path.to_str()),
+            (file.fileType == TYPE_DIRECTORY) ? "/" : "");
+        if (file.status == FS_BAD)
+        {
+            fmt::print(": {}", file.error);
+            failed++;
+        }
+        else if (file.status == FS_OK_BUT_USED_BAD_SECTORS)
+        {
+            fmt::print(" ({} bad sectors)", file.badSectors);
+            bad++;
+        }
+        fmt::print("\n");
+    }
+
+    if (bad)
+        warning("{} files contain bad sectors", bad);
+    if (failed)
+        error("{} files could not be exported", failed);
+    return 0;
+}
@@ -0,0 +1,80 @@
+#include "lib/core/globals.h"
+#include "lib/config/config.h"
+#include "lib/config/flags.h"
+#include "lib/config/proto.h"
+#include "lib/data/fluxmap.h"
+#include "lib/fluxsource/fluxsource.h"
+#include "lib/algorithms/identify.h"
+#include "fluxengine.h"
+#include <chrono>
+
+static FlagGroup flags;
+
+static StringFlag sourceFlux({"--source", "-s"},
+    "flux source to identify",
+    "",
+    [](const auto& value)
+    {
+        globalConfig().setFluxSource(value);
+    });
+
+static StringFlag sampleTracks(
+    {"--tracks", "-t"}, "tracks to sample", "c0h0 c0h1 c4h0");
+
+static IntFlag candidatesFlag(
+    {"--candidates"}, "number of candidate profiles to show", 5);
+
+static IntFlag threadsFlag(
+    {"--threads"}, "number of decoding threads; 0 means one per CPU", 0);
+
+int mainIdentify(int argc, const char* argv[])
+{
+    globalConfig().overrides()->mutable_flux_source()->set_type(FLUXTYPE_DRIVE);
+    flags.parseFlagsWithConfigFiles(argc, argv, {});
+
+    /* Read the samples once; everything after this is done from memory. */
+
+    auto fluxSource = FluxSource::create(globalConfig());
+    auto samples = readIdentifySamples(
+        *fluxSource, parseCylinderHeadsString(sampleTracks));
+    if (samples.empty())
+        error("no flux could be read from any of the sample tracks");
+
+    auto start = std::chrono::steady_clock::now();
+    auto results =
+        identifyFormat(samples, formats, globalConfig(), threadsFlag);
+    auto elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start);
+    fmt::print("Tried {} profiles on {} tracks in {:.2f}s.\n",
+        results.size(),
+        samples.size(),
+        elapsed.count());
+
+    unsigned shown = 0;
+    for (const auto& result : results)
+    {
+        if ((shown == (unsigned)candidatesFlag) || !result.good)
+            break;
+        if (!shown)
+            fmt::print("{:<28} {:>9} {:>5} {:>8} {:>7} {:>6}\n",
+                "Profile",
+                "Good",
+                "Bad",
+                "Spurious",
+                "Clock",
+                "Score");
+        fmt::print("{:<28} {:>4}/{:<4} {:>5} {:>8} {:>6.1f}% {:>6.2f}\n",
+            result.profile,
+            result.good,
+            result.expected,
+            result.bad,
+            result.spurious,
+            result.clockSpread * 100.0,
+            result.score);
+        shown++;
+    }
+    if (!shown)
+        fmt::print("No profile could read any sectors.\n");
+
+    return 0;
+}
@@ -3,6 +3,7 @@
 #include "lib/config/flags.h"
 #include "lib/data/fluxmap.h"
 #include "lib/data/fluxmapreader.h"
+#include "lib/data/fluxhistogram.h"
 #include "lib/decoders/fluxdecoder.h"
 #include "lib/decoders/decoders.h"
 #include "lib/fluxsource/fluxsource.h"
@@ -75,7 +76,7 @@ static nanoseconds_t guessClock(const Fluxmap& fluxmap)
     if (manualClockRate != 0.0)
         return manualClockRate * 1000.0;
 
-    auto data = FluxmapReader(fluxmap).guessClock(
+    auto data = FluxHistogram(fluxmap).guessClock(
         noiseFloorFactor.get(), signalLevelFactor.get());
 
     std::cout << "\nClock detection histogram:" << std::endl;
@@ -33,6 +33,30 @@ static StringFlag destImage({"-o", "--output"},
         globalConfig().setImageWriter(value);
     });
 
+static std::vector<ReadJob> jobs;
+
+static StringFlag job({"--job"},
+    "read a disk from another device: <serial>[/<drive>]=<image>; may be "
+    "repeated",
+    "",
+    [](const auto& value)
+    {
+        auto equals = value.find('=');
+        if (equals == std::string::npos)
+            error("--job must look like <serial>[/<drive>]=<image>");
+
+        ReadJob job{.serial = value.substr(0, equals),
+            .drive = 0,
+            .output = value.substr(equals + 1)};
+        auto slash = job.serial.rfind('/');
+        if (slash != std::string::npos)
+        {
+            job.drive = std::stoi(job.serial.substr(slash + 1));
+            job.serial = job.serial.substr(0, slash);
+        }
+        jobs.push_back(job);
+    });
+
 static StringFlag copyFluxTo({"--copy-flux-to"},
     "while reading, copy the read flux to this file",
     "",
@@ -51,6 +75,17 @@ int mainRead(int argc, const char* argv[])
     if (globalConfig()->decoder().copy_flux_to().type() == FLUXTYPE_DRIVE)
         error("you cannot copy flux to a hardware device");
 
+    if (!jobs.empty())
+    {
+        if (globalConfig()->flux_source().type() != FLUXTYPE_DRIVE)
+            error("--job can only be used when reading from hardware");
+        if (globalConfig()->decoder().has_copy_flux_to())
+            error("--job can't be used with --copy-flux-to");
+
+        readDisksCommand(jobs);
+        return 0;
+    }
+
     auto diskLayout = createDiskLayout(globalConfig());
     auto fluxSource = FluxSource::create(globalConfig());
     auto decoder = Arch::createDecoder(globalConfig());
@@ -1,13 +1,89 @@
 #include "lib/core/globals.h"
 #include "lib/config/flags.h"
 #include "lib/usb/usb.h"
+#include <math.h>
 
 static FlagGroup flags;
 
+static IntFlag iterations({"--iterations"},
+    "Repeat each test this many times and report sustained throughput and "
+    "jitter",
+    1);
+
+static void report(const char* name, const std::vector<BulkTestResult>& runs)
+{
+    size_t bytes = 0;
+    double elapsed = 0.0;
+    double slowest = INFINITY;
+    double fastest = 0.0;
+    std::vector<double> gaps;
+    for (const auto& run : runs)
+    {
+        bytes += run.bytes;
+        elapsed += run.elapsed;
+        double rate = (run.bytes / 1024.0) / run.elapsed;
+        slowest = std::min(slowest, rate);
+        fastest = std::max(fastest, rate);
+
+        double last = 0.0;
+        for (double t : run.transferTimes)
+        {
+            gaps.push_back(t - last);
+            last = t;
+        }
+    }
+
+    fmt::print("{}: {} kB/s sustained over {} runs (slowest {}, fastest {})\n",
+        name,
+        int((bytes / 1024.0) / elapsed),
+        runs.size(),
+        int(slowest),
+        int(fastest));
+
+    /* Jitter is the spread of the times between consecutive transfers
+     * completing; only some devices can report these. */
+
+    if (gaps.size() > 1)
+    {
+        double mean = 0.0;
+        for (double gap : gaps)
+            mean += gap;
+        mean /= gaps.size();
+
+        double variance = 0.0;
+        for (double gap : gaps)
+            variance += (gap - mean) * (gap - mean);
+        variance /= gaps.size();
+
+        fmt::print(
+            "{}: {} transfers, mean interval {:.3f} ms, jitter {:.3f} ms, "
+            "worst {:.3f} ms\n",
+            name,
+            gaps.size(),
+            mean * 1e3,
+            sqrt(variance) * 1e3,
+            *std::max_element(gaps.begin(), gaps.end()) * 1e3);
+    }
+}
+
 int mainTestBandwidth(int argc, const char* argv[])
 {
     flags.parseFlagsWithConfigFiles(argc, argv, {});
-    usbTestBulkWrite();
-    usbTestBulkRead();
+    if (iterations < 1)
+        error("--iterations must be at least 1");
+
+    std::vector<BulkTestResult> writes;
+    std::vector<BulkTestResult> reads;
+    for (int i = 0; i < iterations; i++)
+    {
+        writes.push_back(usbTestBulkWrite());
+        reads.push_back(usbTestBulkRead());
+    }
+
+    if (iterations > 1)
+    {
+        report("bulk write test", writes);
+        report("bulk read test", reads);
+    }
     return 0;
 }
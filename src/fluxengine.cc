@@ -1,11 +1,14 @@
 #include "lib/core/globals.h"
 #include "lib/config/proto.h"
+#include "lib/core/trace.h"
 #include "fmt/format.h"
 
 typedef int command_cb(int agrc, const char* argv[]);
 
 extern command_cb mainAnalyseDriveResponse;
 extern command_cb mainAnalyseLayout;
+extern command_cb mainBatch;
+extern command_cb mainExport;
 extern command_cb mainConvert;
 extern command_cb mainFluxfileLs;
 extern command_cb mainFluxfileRm;
@@ -14,6 +17,7 @@ extern command_cb mainFormat;
 extern command_cb mainGetDiskInfo;
 extern command_cb mainGetFile;
 extern command_cb mainGetFileInfo;
+extern command_cb mainIdentify;
 extern command_cb mainInspect;
 extern command_cb mainLs;
 extern command_cb mainMkDir;
@@ -46,6 +50,7 @@ static std::vector<Command> commands =
     { "inspect",           mainInspect,           "Low-level analysis and inspection of a disk." },
 	{ "analyse",           mainAnalyse,           "Disk and drive analysis tools." },
     { "read",              mainRead,              "Reads a disk, producing a sector image.", },
+    { "identify",          mainIdentify,          "Tries every profile on a few tracks to guess a disk's format.", },
     { "write",             mainWrite,             "Writes a sector image to a disk.", },
 	{ "fluxfile",          mainFluxfile,          "Flux file manipulation operations.", },
 	{ "format",            mainFormat,            "Format a disk and make a file system on it.", },
@@ -59,6 +64,8 @@ static std::vector<Command> commands =
 	{ "getfileinfo",       mainGetFileInfo,       "Read file metadata off a disk (or image).", },
 	{ "putfile",           mainPutFile,           "Write a file to disk (or image).", },
 	{ "mkdir",             mainMkDir,             "Create a directory on disk (or image).", },
+	{ "batch",             mainBatch,             "Performs a list of file operations on a disk (or image) in one go.", },
+	{ "export",            mainExport,            "Copies every file off a disk (or image) in one go.", },
     { "rpm",               mainRpm,               "Measures the disk rotational speed.", },
     { "seek",              mainSeek,              "Moves the disk head.", },
     { "test",              mainTest,              "Various testing commands.", },
@@ -196,6 +203,14 @@ int main(int argc, const char* argv[])
                 fmt::print(stderr, "Error: {}\n", e.message);
                 exit(1);
             }
+            catch (...)
+            {
+                /* Anything else is fatal and won't run exit handlers, so
+                 * write the trace now. */
+
+                Trace::finish();
+                throw;
+            }
         }
     }
 
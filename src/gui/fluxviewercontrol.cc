@@ -4,12 +4,14 @@
 #include "textviewerwindow.h"
 #include "lib/data/disk.h"
 #include "lib/data/fluxmap.h"
+#include "lib/data/fluxpyramid.h"
 #include "lib/decoders/decoders.h"
 #include "lib/decoders/decoders.pb.h"
 #include "lib/data/sector.h"
 #include "lib/data/layout.h"
 #include "lib/data/fluxmapreader.h"
 #include "lib/core/crc.h"
+#include <thread>
 
 DECLARE_COLOUR(BACKGROUND, 192, 192, 192);
 DECLARE_COLOUR(READ_SEPARATOR, 255, 0, 0);
@@ -34,11 +36,19 @@ FluxViewerControl::FluxViewerControl(wxWindow* parent,
         pos,
         size,
         style | wxFULL_REPAINT_ON_RESIZE,
-        "FluxViewerControl")
+        "FluxViewerControl"),
+    _pyramidBuildState(std::make_shared<PyramidBuildState>())
 {
+    _pyramidBuildState->control = this;
     SetDoubleBuffered(true);
 }
 
+FluxViewerControl::~FluxViewerControl()
+{
+    std::scoped_lock lock(_pyramidBuildState->mutex);
+    _pyramidBuildState->control = nullptr;
+}
+
 // clang-format off
 wxBEGIN_EVENT_TABLE(FluxViewerControl, wxPanel)
 	EVT_PAINT(FluxViewerControl::OnPaint)
@@ -63,6 +73,50 @@ void FluxViewerControl::SetFlux(std::shared_ptr<const TrackFlux> flux)
 {
     _flux = flux;
 
+    /* Building the pyramids means reading all the flux, so do it in the
+     * background; the density chart is drawn once they're ready. Any build
+     * for the previous flux is left to notice that it's stale and stop on its
+     * own, rather than being waited for. */
+
+    unsigned generation;
+    {
+        std::scoped_lock lock(_pyramidBuildState->mutex);
+        generation = ++_pyramidBuildState->generation;
+        _pyramidBuildState->pyramids.clear();
+    }
+
+    std::thread(
+        [state = _pyramidBuildState, generation, flux]()
+        {
+            auto isStale = [&]
+            {
+                std::scoped_lock lock(state->mutex);
+                return !state->control || (state->generation != generation);
+            };
+
+            std::vector<std::shared_ptr<const FluxPyramid>> pyramids;
+            for (const auto& trackdata : flux->trackDatas)
+            {
+                if (isStale())
+                    return;
+                pyramids.push_back(
+                    std::make_shared<FluxPyramid>(*trackdata->fluxmap));
+            }
+
+            std::scoped_lock lock(state->mutex);
+            auto* control = state->control;
+            if (control && (state->generation == generation))
+            {
+                state->pyramids = std::move(pyramids);
+                control->CallAfter(
+                    [control]()
+                    {
+                        control->Refresh();
+                    });
+            }
+        })
+        .detach();
+
     _scrollPosition = 0;
     _totalDuration = 0;
     _events.clear();
@@ -92,34 +146,16 @@ void FluxViewerControl::UpdateScale()
         thumbSize / 1000,
         _totalDuration / 1000,
         thumbSize / 2000);
+}
 
-    int totalPixels = (_totalDuration / _nanosecondsPerPixel) + 1;
-    if ((totalPixels != _densityMap.size()) &&
-        (_nanosecondsPerPixel > RENDER_LIMIT))
-    {
-        _densityMap.resize(totalPixels);
-        std::fill(_densityMap.begin(), _densityMap.end(), 0.0);
-
-        int i = 0;
-        for (const auto& trackdata : _flux->trackDatas)
-        {
-            FluxmapReader fmr(*trackdata->fluxmap);
-            while (!fmr.eof())
-            {
-                unsigned ticks;
-                if (!fmr.findEvent(F_BIT_PULSE, ticks))
-                    break;
+/* Returns the pyramids for the current flux, or nothing if they're still
+ * being built. */
 
-                int fx = fmr.tell().ns() / _nanosecondsPerPixel;
-                _densityMap.at(i + fx)++;
-            }
-            i += trackdata->fluxmap->duration() / _nanosecondsPerPixel;
-        }
-
-        double max = *std::max_element(_densityMap.begin(), _densityMap.end());
-        for (auto& d : _densityMap)
-            d /= max;
-    }
+std::vector<std::shared_ptr<const FluxPyramid>> FluxViewerControl::GetPyramids()
+    const
+{
+    std::scoped_lock lock(_pyramidBuildState->mutex);
+    return _pyramidBuildState->pyramids;
 }
 
 static int interpolate(int lo, int hi, float factor)
@@ -148,10 +184,12 @@ void FluxViewerControl::OnPaint(wxPaintEvent&)
     int t4y = th * 3 + th2;
     int t5y = th * 4 + th2;
 
+    auto pyramids = GetPyramids();
     int x = -_scrollPosition / _nanosecondsPerPixel;
     nanoseconds_t fluxStartTime = 0;
-    for (auto& trackdata : _flux->trackDatas)
+    for (unsigned index = 0; index < _flux->trackDatas.size(); index++)
     {
+        const auto& trackdata = _flux->trackDatas[index];
         nanoseconds_t duration = trackdata->fluxmap->duration();
         int fw = duration / _nanosecondsPerPixel;
 
@@ -172,14 +210,9 @@ void FluxViewerControl::OnPaint(wxPaintEvent&)
 
             {
                 dc.SetPen(INDEX_SEPARATOR_PEN);
-                FluxmapReader fmr(*trackdata->fluxmap);
-                for (;;)
+                for (nanoseconds_t mark : trackdata->fluxmap->getIndexMarks())
                 {
-                    unsigned ticks;
-                    if (!fmr.findEvent(F_BIT_INDEX, ticks))
-                        break;
-
-                    int fx = fmr.tell().ns() / _nanosecondsPerPixel;
+                    int fx = mark / _nanosecondsPerPixel;
                     if (((x + fx) > 0) && ((x + fx) < w))
                         dc.DrawLine({x + fx, 0}, {x + fx, h});
 
@@ -405,16 +438,25 @@ void FluxViewerControl::OnPaint(wxPaintEvent&)
             dc.SetPen(FLUX_PEN);
             if (_nanosecondsPerPixel > RENDER_LIMIT)
             {
-                /* Draw using density map. */
+                /* Draw using the density pyramid, but only for the visible
+                 * columns. */
 
                 dc.SetPen(*wxTRANSPARENT_PEN);
-                for (int fx = 0; fx < fw; fx++)
+                int left = std::max(1 - x, 0);
+                int right = std::min(w - x, fw);
+                if ((index < pyramids.size()) && (left < right))
                 {
-                    if (((x + fx) > 0) && ((x + fx) < w))
+                    const auto& pyramid = pyramids[index];
+                    double ticksPerPixel = _nanosecondsPerPixel / NS_PER_TICK;
+                    double max = pyramid->maxDensity(
+                        pyramid->levelFor(ticksPerPixel));
+                    auto columns = pyramid->columns(
+                        left * ticksPerPixel, ticksPerPixel, right - left);
+
+                    for (int fx = left; fx < right; fx++)
                     {
                         float density =
-                            _densityMap[(fluxStartTime / _nanosecondsPerPixel) +
-                                        fx];
+                            max ? (columns[fx - left].density() / max) : 0.0;
                         wxColour colour(interpolate(BACKGROUND_COLOUR.Red(),
                                             FLUX_COLOUR.Red(),
                                             density),
@@ -432,9 +474,17 @@ void FluxViewerControl::OnPaint(wxPaintEvent&)
             }
             else
             {
-                /* Draw discrete pulses. */
+                /* Draw discrete pulses. Once the pyramid's ready, start just
+                 * before the left edge rather than at the start of the
+                 * track; either way, stop at the right edge. */
 
                 FluxmapReader fmr(*trackdata->fluxmap);
+                if (index < pyramids.size())
+                {
+                    int left = std::max(1 - x, 0);
+                    fmr.seek(pyramids[index]->seekPosition(
+                        left * _nanosecondsPerPixel / NS_PER_TICK));
+                }
                 while (!fmr.eof())
                 {
                     unsigned ticks;
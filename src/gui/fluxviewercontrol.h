@@ -2,8 +2,10 @@
 #define FLUXVIEWERCONTROL_H
 
 #include "lib/core/globals.h"
+#include <mutex>
 
 class TrackFlux;
+class FluxPyramid;
 class wxScrollBar;
 class wxScrollEvent;
 class Sector;
@@ -18,7 +20,7 @@ public:
         const wxPoint& pos = wxDefaultPosition,
         const wxSize& size = wxDefaultSize,
         long style = 0);
-    virtual ~FluxViewerControl() {}
+    virtual ~FluxViewerControl();
 
 public:
     void SetScrollbar(wxScrollBar* scrollbar);
@@ -26,6 +28,7 @@ public:
 
 private:
     void UpdateScale();
+    std::vector<std::shared_ptr<const FluxPyramid>> GetPyramids() const;
     void ShowSectorMenu(std::shared_ptr<const Sector> sector);
     void ShowRecordMenu(std::shared_ptr<const TrackInfo>& layout,
         std::shared_ptr<const Record> record);
@@ -49,7 +52,21 @@ private:
     nanoseconds_t _totalDuration = 0;
     double _nanosecondsPerPixel = 0;
     std::set<nanoseconds_t> _events;
-    std::vector<float> _densityMap;
+
+    /* Shared with the background pyramid builders, which aren't waited for
+     * and so may outlive the control. Builds for an old generation give up
+     * as soon as they notice; only the current one gets to store its
+     * pyramids, one per trackdata. These are the only references to them, so
+     * they go away when the control moves on to another track. */
+
+    struct PyramidBuildState
+    {
+        std::mutex mutex;
+        FluxViewerControl* control;
+        unsigned generation = 0;
+        std::vector<std::shared_ptr<const FluxPyramid>> pyramids;
+    };
+    std::shared_ptr<PyramidBuildState> _pyramidBuildState;
     int _dragStartX = -1;
     nanoseconds_t _dragStartPosition = -1;
     int _mouseX = -1;
@@ -29,7 +29,7 @@ HistogramViewer::HistogramViewer(wxWindow* parent,
 
 void HistogramViewer::Redraw(const Fluxmap& fluxmap, nanoseconds_t clock)
 {
-    _data = FluxmapReader(fluxmap).guessClock();
+    _data = FluxHistogram(fluxmap).guessClock();
     _clock = clock;
     _blank = false;
     Refresh();
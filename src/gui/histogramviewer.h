@@ -2,7 +2,7 @@
 
 #include "lib/core/globals.h"
 #include "lib/data/fluxmap.h"
-#include "lib/data/fluxmapreader.h"
+#include "lib/data/fluxhistogram.h"
 
 class HistogramViewer : public wxWindow
 {
@@ -32,7 +32,7 @@ private:
 
 private:
     bool _blank = true;
-    FluxmapReader::ClockData _data;
+    FluxHistogram::ClockData _data;
     wxFont _font;
     nanoseconds_t _clock;
     wxDECLARE_EVENT_TABLE();
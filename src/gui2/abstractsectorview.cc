@@ -17,26 +17,10 @@ AbstractSectorView::AbstractSectorView(const std::string& name):
 
 void AbstractSectorView::drawContent()
 {
-    auto disk = Datastore::getDisk();
-    auto diskLayout = Datastore::getDiskLayout();
-    if (!disk || !diskLayout)
+    auto grid = getSectorGrid();
+    if (!grid || !grid->columns())
         return;
-    auto& image = disk->image;
-    if (!image)
-        return;
-
-    auto [minCylinder, maxCylinder, minHead, maxHead] = getBounds();
-
-    unsigned minSector = UINT_MAX;
-    unsigned maxSector = 0;
-    for (auto& [chs, ltl] : diskLayout->layoutByLogicalLocation)
-    {
-        minSector = std::min(
-            minSector, *std::ranges::min_element(ltl->filesystemSectorOrder));
-        maxSector = std::max(
-            maxSector, *std::ranges::max_element(ltl->filesystemSectorOrder));
-    }
-    unsigned sectorCount = maxSector - minSector + 1;
+    unsigned sectorCount = grid->columns();
 
     auto backgroundColour = ImGui::GetColorU32(ImGuiCol_WindowBg);
     ImGui::PushStyleColor(ImGuiCol_TableBorderLight, backgroundColour);
@@ -95,106 +79,103 @@ void AbstractSectorView::drawContent()
         ImGui::TableNextRow(ImGuiTableRowFlags_None, rowHeight);
 
         ImGui::TableNextColumn();
-        for (int sector = minSector; sector <= maxSector; sector++)
+        for (unsigned column = 0; column < sectorCount; column++)
         {
             ImGui::TableNextColumn();
 
-            auto text = fmt::format("s{}", sector);
+            auto text = fmt::format("s{}", grid->sectorForColumn(column));
             ImGui::SetCursorPosX(ImGui::GetCursorPosX() +
                                  ImGui::GetColumnWidth() / 2 -
                                  ImGui::CalcTextSize(text.c_str()).x / 2);
             ImGui::Text("%s", text.c_str());
         }
 
-        for (unsigned cylinder = minCylinder; cylinder <= maxCylinder;
-            cylinder++)
-            for (unsigned head = minHead; head <= maxHead; head++)
+        for (unsigned row = 0; row < grid->rows(); row++)
+        {
+            unsigned cylinder = grid->cylinderForRow(row);
+            unsigned head = grid->headForRow(row);
+
+            ImGui::TableNextRow(ImGuiTableRowFlags_None, rowHeight);
+            ImGui::TableNextColumn();
+
             {
-                ImGui::TableNextRow(ImGuiTableRowFlags_None, rowHeight);
-                ImGui::TableNextColumn();
+                auto text = fmt::format("c{}h{}", cylinder, head);
+                auto textSize = ImGui::CalcTextSize(text.c_str());
+                ImGui::SetCursorPos(
+                    {ImGui::GetCursorPosX() + ImGui::GetColumnWidth() / 2 -
+                            textSize.x / 2,
+                        ImGui::GetCursorPosY() + rowHeight / 2 -
+                            textSize.y / 2});
+                ImGui::Text("%s", text.c_str());
+            }
 
-                {
-                    auto text = fmt::format("c{}h{}", cylinder, head);
-                    auto textSize = ImGui::CalcTextSize(text.c_str());
-                    ImGui::SetCursorPos(
-                        {ImGui::GetCursorPosX() + ImGui::GetColumnWidth() / 2 -
-                                textSize.x / 2,
-                            ImGui::GetCursorPosY() + rowHeight / 2 -
-                                textSize.y / 2});
-                    ImGui::Text("%s", text.c_str());
-                }
+            for (unsigned column = 0; column < sectorCount; column++)
+            {
+                ImGui::TableNextColumn();
+                const auto& cell = grid->at(row, column);
+                const auto& sector = cell.sector;
+                unsigned sectorId = grid->sectorForColumn(column);
 
-                for (unsigned sectorId = minSector; sectorId <= maxSector;
-                    sectorId++)
+                if (sector)
                 {
-                    ImGui::TableNextColumn();
-                    auto sector = getSector(cylinder, head, sectorId);
+                    auto colour = ImGuiExt::GetCustomColorU32(
+                        (cell.status == Sector::OK)
+                            ? ImGuiCustomCol_LoggerInfo
+                            : ImGuiCustomCol_LoggerError);
 
-                    if (sector)
+                    ImGui::PushStyleColor(ImGuiCol_Header, colour);
+                    ON_SCOPE_EXIT
                     {
-                        auto colour = ImGuiExt::GetCustomColorU32(
-                            (sector->status == Sector::OK)
-                                ? ImGuiCustomCol_LoggerInfo
-                                : ImGuiCustomCol_LoggerError);
-
-                        ImGui::PushStyleColor(ImGuiCol_Header, colour);
-                        ON_SCOPE_EXIT
-                        {
-                            ImGui::PopStyleColor();
-                        };
-
-                        auto block = findOptionally(
-                            diskLayout->blockIdByLogicalSectorLocation,
-                            {sector->logicalCylinder,
-                                sector->logicalHead,
-                                sector->logicalSector});
-
-                        auto id = block.has_value() ? fmt::format("#{}", *block)
-                                                    : "???";
-                        if (ImGui::Selectable(fmt::format("{}##image_c{}h{}s{}",
-                                                  id,
-                                                  cylinder,
-                                                  head,
-                                                  sectorId)
-                                                  .c_str(),
-                                true,
-                                ImGuiSelectableFlags_None,
-                                {0,
-                                    rowHeight -
-                                        ImGui::GetStyle().CellPadding.y * 2}))
-                            if (sector->physicalLocation.has_value())
-                                Events::SeekToSectorViaPhysicalLocation::post(
-                                    CylinderHeadSector{
-                                        sector->physicalLocation->cylinder,
-                                        sector->physicalLocation->head,
-                                        sectorId});
-
-                        ImGui::PushFont(NULL, originalFontSize);
-                        ON_SCOPE_EXIT
-                        {
-                            ImGui::PopFont();
-                        };
-                        auto physicalLocation =
-                            sector->physicalLocation.has_value()
-                                ? fmt::format("Physical: c{}h{}s{}",
-                                      sector->physicalLocation->cylinder,
-                                      sector->physicalLocation->head,
-                                      sectorId)
-                                : "unknown";
-                        ImGui::SetItemTooltip("%s",
-                            fmt::format("Physical: {}\n"
-                                        "Logical: c{}h{}s{}\n"
-                                        "Size: {} bytes\n"
-                                        "Status: {}",
-                                physicalLocation,
-                                sector->logicalCylinder,
-                                sector->logicalHead,
-                                sectorId,
-                                sector->data.size(),
-                                Sector::statusToString(sector->status))
-                                .c_str());
-                    }
+                        ImGui::PopStyleColor();
+                    };
+
+                    auto id = (cell.blockId != -1)
+                                  ? fmt::format("#{}", cell.blockId)
+                                  : "???";
+                    if (ImGui::Selectable(fmt::format("{}##image_c{}h{}s{}",
+                                              id,
+                                              cylinder,
+                                              head,
+                                              sectorId)
+                                              .c_str(),
+                            true,
+                            ImGuiSelectableFlags_None,
+                            {0,
+                                rowHeight -
+                                    ImGui::GetStyle().CellPadding.y * 2}))
+                        if (sector->physicalLocation.has_value())
+                            Events::SeekToSectorViaPhysicalLocation::post(
+                                CylinderHeadSector{
+                                    sector->physicalLocation->cylinder,
+                                    sector->physicalLocation->head,
+                                    sectorId});
+
+                    ImGui::PushFont(NULL, originalFontSize);
+                    ON_SCOPE_EXIT
+                    {
+                        ImGui::PopFont();
+                    };
+                    auto physicalLocation =
+                        sector->physicalLocation.has_value()
+                            ? fmt::format("Physical: c{}h{}s{}",
+                                  sector->physicalLocation->cylinder,
+                                  sector->physicalLocation->head,
+                                  sectorId)
+                            : "unknown";
+                    ImGui::SetItemTooltip("%s",
+                        fmt::format("Physical: {}\n"
+                                    "Logical: c{}h{}s{}\n"
+                                    "Size: {} bytes\n"
+                                    "Status: {}",
+                            physicalLocation,
+                            sector->logicalCylinder,
+                            sector->logicalHead,
+                            sectorId,
+                            sector->data.size(),
+                            Sector::statusToString(sector->status))
+                            .c_str());
                 }
             }
+        }
     }
 }
@@ -4,7 +4,7 @@
 #include "lib/core/globals.h"
 #include "lib/data/layout.h"
 
-class Sector;
+class SectorGrid;
 
 class AbstractSectorView : public hex::View::Window
 {
@@ -23,7 +23,5 @@ public:
     }
 
 protected:
-    virtual std::shared_ptr<const Sector> getSector(
-        unsigned cylinder, unsigned head, unsigned sectorId) = 0;
-    virtual DiskLayout::LayoutBounds getBounds() = 0;
+    virtual std::shared_ptr<const SectorGrid> getSectorGrid() = 0;
 };
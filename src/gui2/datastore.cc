@@ -50,6 +50,8 @@ static std::atomic<bool> failed;
 static bool formattingSupported;
 static std::map<std::string, Datastore::Device> devices;
 static std::shared_ptr<const DiskLayout> diskLayout;
+static std::shared_ptr<SectorGrid> logicalSectorGrid;
+static std::shared_ptr<SectorGrid> physicalSectorGrid;
 
 static void wtRebuildConfiguration(bool useCustom);
 
@@ -304,6 +306,48 @@ std::shared_ptr<const Disk> Datastore::getDisk()
     return disk;
 }
 
+std::shared_ptr<const SectorGrid> Datastore::getSectorGrid(
+    SectorGrid::Kind kind)
+{
+    return (kind == SectorGrid::PHYSICAL) ? physicalSectorGrid
+                                          : logicalSectorGrid;
+}
+
+/* Call these on the UI thread whenever the disk or the layout changes. */
+
+static void updateSectorGrids()
+{
+    const Image* image = disk ? disk->image.get() : nullptr;
+    if (logicalSectorGrid)
+        logicalSectorGrid->update(image);
+    if (physicalSectorGrid)
+        physicalSectorGrid->update(image);
+}
+
+/* As above, but only the given logical tracks have changed. */
+
+static void updateSectorGrids(const std::set<CylinderHead>& logicalTracks)
+{
+    const Image* image = disk ? disk->image.get() : nullptr;
+    if (logicalSectorGrid)
+        logicalSectorGrid->update(image, logicalTracks);
+    if (physicalSectorGrid)
+        physicalSectorGrid->update(image, logicalTracks);
+}
+
+static void rebuildSectorGrids()
+{
+    logicalSectorGrid = physicalSectorGrid = nullptr;
+    if (diskLayout)
+    {
+        logicalSectorGrid =
+            std::make_shared<SectorGrid>(*diskLayout, SectorGrid::LOGICAL);
+        physicalSectorGrid =
+            std::make_shared<SectorGrid>(*diskLayout, SectorGrid::PHYSICAL);
+    }
+    updateSectorGrids();
+}
+
 static void badConfiguration()
 {
     throw ErrorException("internal error: no configuration");
@@ -340,6 +384,7 @@ static void wtClearDiskData()
         {
             ::wtImage = nullptr;
             ::disk = std::make_shared<Disk>();
+            updateSectorGrids();
         });
 }
 
@@ -429,6 +474,7 @@ void wtRebuildConfiguration(bool withCustom = false)
         {
             ::formattingSupported = formattingSupported;
             ::diskLayout = diskLayout;
+            rebuildSectorGrids();
         });
 }
 
@@ -491,6 +537,7 @@ void Datastore::onLogMessage(const AnyLogMessage& message)
                  * is guaranteed not to change. */
 
                 disk = m->disk;
+                updateSectorGrids(m->logicalTracks);
             },
 
             /* Large-scale operation start. */
@@ -720,6 +767,7 @@ void Datastore::readImage(const std::fs::path& path)
                     [=]
                     {
                         ::disk = disk;
+                        updateSectorGrids();
                     });
             }
             catch (...)
@@ -797,6 +845,7 @@ void Datastore::createBlankImage()
                     {
                         Events::SetSystemConfig::post("");
                         ::disk = disk;
+                        updateSectorGrids();
                     });
             }
             catch (...)
@@ -3,6 +3,7 @@
 #include "lib/core/globals.h"
 #include "lib/core/logger.h"
 #include "lib/data/layout.h"
+#include "lib/data/sectorgrid.h"
 
 class Disk;
 class DiskLayout;
@@ -31,6 +32,11 @@ public:
     static const std::map<CylinderHead, std::shared_ptr<const TrackInfo>>&
     getPhysicalCylinderLayouts();
     static std::shared_ptr<const DiskLayout> getDiskLayout();
+
+    /* These are only updated when the disk changes, so are cheap to draw
+     * from every frame. */
+    static std::shared_ptr<const SectorGrid> getSectorGrid(
+        SectorGrid::Kind kind);
     static void onLogMessage(const AnyLogMessage& message);
 
     static void reset();
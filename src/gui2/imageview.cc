@@ -12,14 +12,7 @@ using namespace hex;
 
 ImageView::ImageView(): AbstractSectorView("fluxengine.view.image.name") {}
 
-DiskLayout::LayoutBounds ImageView::getBounds()
+std::shared_ptr<const SectorGrid> ImageView::getSectorGrid()
 {
-    return Datastore::getDiskLayout()->getLogicalBounds();
-}
-
-std::shared_ptr<const Sector> ImageView::getSector(
-    unsigned logicalCylinder, unsigned logicalHead, unsigned sectorId)
-{
-    auto disk = Datastore::getDisk();
-    return disk->image->get({logicalCylinder, logicalHead, sectorId});
+    return Datastore::getSectorGrid(SectorGrid::LOGICAL);
 }
@@ -8,7 +8,5 @@ class ImageView : public AbstractSectorView
 public:
     ImageView();
 
-    std::shared_ptr<const Sector> getSector(
-        unsigned cylinder, unsigned head, unsigned sectorId) override;
-    DiskLayout::LayoutBounds getBounds() override;
+    std::shared_ptr<const SectorGrid> getSectorGrid() override;
 };
@@ -17,20 +17,7 @@ PhysicalView::PhysicalView():
 
 PhysicalView::~PhysicalView() {}
 
-DiskLayout::LayoutBounds PhysicalView::getBounds()
+std::shared_ptr<const SectorGrid> PhysicalView::getSectorGrid()
 {
-    return Datastore::getDiskLayout()->getPhysicalBounds();
-}
-
-std::shared_ptr<const Sector> PhysicalView::getSector(
-    unsigned physicalCylinder, unsigned physicalHead, unsigned sectorId)
-{
-    const auto& disk = Datastore::getDisk();
-    const auto& diskLayout = Datastore::getDiskLayout();
-    const auto& ptl = findOrDefault(
-        diskLayout->layoutByPhysicalLocation, {physicalCylinder, physicalHead});
-    if (!ptl)
-        return nullptr;
-    const auto& ltl = ptl->logicalTrackLayout;
-    return disk->image->get({ltl->logicalCylinder, ltl->logicalHead, sectorId});
+    return Datastore::getSectorGrid(SectorGrid::PHYSICAL);
 }
@@ -9,7 +9,5 @@ public:
     PhysicalView();
     ~PhysicalView();
 
-    std::shared_ptr<const Sector> getSector(
-        unsigned cylinder, unsigned head, unsigned sectorId) override;
-    DiskLayout::LayoutBounds getBounds() override;
+    std::shared_ptr<const SectorGrid> getSectorGrid() override;
 };
@@ -0,0 +1,175 @@
+#include "lib/core/globals.h"
+#include "lib/core/bytes.h"
+#include "lib/data/fluxmap.h"
+#include "lib/data/fluxmapreader.h"
+#include "lib/external/a2r.h"
+#include "protocol.h"
+#include "tests.h"
+#include <assert.h>
+
+static void writeChunk(ByteWriter& bw, uint32_t id, const Bytes& data)
+{
+    bw.write_le32(id);
+    bw.write_le32(data.size());
+    bw += data;
+}
+
+static Bytes makeInfo(unsigned diskType)
+{
+    Bytes info;
+    ByteWriter bw(info);
+    bw.write_8(A2R_INFO_CHUNK_VERSION);
+    bw.append(fmt::format("{: <32}", "test"));
+    bw.write_8(diskType);
+    bw.write_8(1);
+    bw.write_8(1);
+    return info;
+}
+
+/* A 3.5" v2 file: a bits capture (which is ignored) and two timing captures,
+ * one with a long interval. */
+
+static Bytes makeV2()
+{
+    Bytes strm;
+    ByteWriter sw(strm);
+    sw.write_8(0x03);
+    sw.write_8(A2R_BITS);
+    sw.write_le32(2);
+    sw.write_le32(0);
+    sw += Bytes{1, 2};
+
+    sw.write_8(0x00);
+    sw.write_8(A2R_TIMING);
+    sw.write_le32(3);
+    sw.write_le32(20);
+    sw += Bytes{10, 10, 10};
+
+    sw.write_8(0x03);
+    sw.write_8(A2R_TIMING);
+    sw.write_le32(3);
+    sw.write_le32(300);
+    sw += Bytes{10, 0xff, 45};
+    sw.write_8(0xff);
+
+    Bytes file;
+    ByteWriter bw(file);
+    bw += Bytes{'A', '2', 'R', '2', 0xff, 0x0a, 0x0d, 0x0a};
+    writeChunk(bw, A2R_CHUNK_INFO, makeInfo(A2R_DISK_35));
+    writeChunk(bw, A2R_CHUNK_STRM, strm);
+    writeChunk(bw, A2R_CHUNK_META, Bytes{});
+    return file;
+}
+
+/* A 5.25" v3 file with a 250ns resolution and two index marks. */
+
+static Bytes makeV3()
+{
+    Bytes rwcp;
+    ByteWriter rw(rwcp);
+    rw.write_8(1);
+    rw.write_le32(250000);
+    rw += Bytes(11);
+
+    rw.write_8('C');
+    rw.write_8(A2R_TIMING);
+    rw.write_le16(34);
+    rw.write_8(2);
+    rw.write_le32(5);
+    rw.write_le32(15);
+    rw.write_le32(2);
+    rw += Bytes{10, 10};
+    rw.write_8('X');
+
+    Bytes file;
+    ByteWriter bw(file);
+    bw += Bytes{'A', '2', 'R', '3', 0xff, 0x0a, 0x0d, 0x0a};
+    writeChunk(bw, A2R_CHUNK_INFO, makeInfo(A2R_DISK_525));
+    writeChunk(bw, A2R_CHUNK_RWCP, rwcp);
+    return file;
+}
+
+/* Returns the flux as a list of intervals between pulses in ns, with -1 for
+ * an index. */
+
+static std::vector<int> events(const Fluxmap& fluxmap)
+{
+    std::vector<int> result;
+    FluxmapReader fmr(fluxmap);
+    unsigned ticks = 0;
+    for (;;)
+    {
+        int event;
+        unsigned t;
+        fmr.getNextEvent(event, t);
+        if (event == F_EOF)
+            break;
+        ticks += t;
+        if (event & F_BIT_INDEX)
+            result.push_back(-1);
+        if (event & F_BIT_PULSE)
+        {
+            result.push_back(ticks * NS_PER_TICK + 0.5);
+            ticks = 0;
+        }
+    }
+    return result;
+}
+
+static void test_v2()
+{
+    Bytes file = makeV2();
+    auto index = indexA2r(file.cbegin(), file.size());
+    assertThat(index.version).isEqualTo(2);
+    assertThat(index.diskType).isEqualTo(A2R_DISK_35);
+    assertThat(index.captures.size()).isEqualTo(2);
+
+    auto& c0 = index.captures[0];
+    assertThat(c0.location).isEqualTo(0);
+    assertThat(c0.size).isEqualTo(3);
+    assert(c0.data == file.cbegin() + 8 + 8 + 36 + 8 + 10 + 2 + 10);
+    assert(c0.indexes == std::vector<uint32_t>{20});
+
+    assert(events(*readA2rCapture(c0)) ==
+           (std::vector<int>{1250, -1, 1250, 1250}));
+    assert(events(*readA2rCapture(index.captures[1])) ==
+           (std::vector<int>{1250, -1, 37500}));
+}
+
+static void test_v3()
+{
+    Bytes file = makeV3();
+    auto index = indexA2r(file.cbegin(), file.size());
+    assertThat(index.version).isEqualTo(3);
+    assertThat(index.diskType).isEqualTo(A2R_DISK_525);
+    assertThat(index.captures.size()).isEqualTo(1);
+
+    auto& c = index.captures[0];
+    assertThat(c.location).isEqualTo(34);
+    assert(c.indexes == (std::vector<uint32_t>{5, 15}));
+    assert(events(*readA2rCapture(c)) ==
+           (std::vector<int>{-1, 2500, -1, 2500}));
+}
+
+static void test_truncated()
+{
+    Bytes file = makeV2();
+    bool thrown = false;
+    try
+    {
+        indexA2r(file.cbegin(), file.size() - 20);
+    }
+    catch (const ErrorException& e)
+    {
+        thrown = true;
+    }
+    assert(thrown);
+}
+
+int main(int argc, const char* argv[])
+{
+    test_v2();
+    test_v3();
+    test_truncated();
+    return 0;
+}
@@ -16,26 +16,41 @@ protocc(
 )
 
 tests = [
+    "a2r",
     "agg",
     "amiga",
     "applesingle",
     "bitaccumulator",
     "bytes",
+    "calibration",
     "compression",
     "configs",
+    "crccorrector",
     "cpmfs",
     "csvreader",
+    "decoders",
+    "emulator",
     "flags",
+    "fluxdecoder",
+    "fluxhistogram",
+    "fluxmap",
     "fluxmapreader",
     "fluxpattern",
+    "fluxpyramid",
+    "fluxscan",
     "flx",
     "fmmfm",
     "greaseweazle",
+    "identify",
     "kryoflux",
     "layout",
     "locations",
     "ldbs",
     "options",
+    "scp",
+    "sectorcollector",
+    "sectorgrid",
+    "trace",
     "utils",
     "vfs",
 ]
@@ -105,7 +120,8 @@ export(
                 ]
                 + ([".+test_proto_lib"] if n == "options" else [])
                 + (["lib/vfs"] if n in {"cpmfs", "applesingle", "vfs"} else [])
-                + (["arch"] if n in {"amiga"} else []),
+                + (["arch"] if n in {"amiga"} else [])
+                + (["lib/usb"] if n in {"emulator", "identify"} else []),
             ),
         )
         for n in tests
@@ -0,0 +1,94 @@
+#include "lib/core/globals.h"
+#include "lib/config/drive.pb.h"
+#include "lib/algorithms/calibration.h"
+#include "tests.h"
+#include <assert.h>
+#include <unistd.h>
+
+static const time_t NOW = 1700000000;
+
+static CalibrationCacheProto makeConfig()
+{
+    CalibrationCacheProto config;
+    config.set_filename(fmt::format("/tmp/calibration-test-{}", getpid()));
+    unlink(config.filename().c_str());
+    return config;
+}
+
+static void test_roundtrip()
+{
+    auto config = makeConfig();
+    DriveProto drive;
+    drive.set_drive(1);
+
+    assert(!findDriveCalibration(config, "serial", drive, NOW));
+    saveDriveCalibration(config, "serial", drive, {200e6, 0}, NOW);
+
+    auto c = findDriveCalibration(config, "serial", drive, NOW + 60);
+    assert(c);
+    assertThat(c->rotationalPeriod).isEqualTo(200e6);
+
+    /* Anything which might change the measurement is part of the key. */
+
+    assert(!findDriveCalibration(config, "other", drive, NOW));
+    DriveProto other = drive;
+    other.set_drive(0);
+    assert(!findDriveCalibration(config, "serial", other, NOW));
+    other = drive;
+    other.set_index_mode(INDEXMODE_300);
+    assert(!findDriveCalibration(config, "serial", other, NOW));
+    other = drive;
+    other.set_hard_sector_count(16);
+    assert(!findDriveCalibration(config, "serial", other, NOW));
+
+    /* Saving again replaces the entry rather than adding another. */
+
+    other = drive;
+    other.set_hard_sector_count(16);
+    saveDriveCalibration(config, "serial", other, {166e6, 7.8e6}, NOW);
+    saveDriveCalibration(config, "serial", drive, {201e6, 0}, NOW);
+    c = findDriveCalibration(config, "serial", drive, NOW);
+    assertThat(c->rotationalPeriod).isEqualTo(201e6);
+    c = findDriveCalibration(config, "serial", other, NOW);
+    assertThat(c->rotationalPeriod).isEqualTo(166e6);
+    assertThat(c->hardSectorThreshold).isEqualTo(7.8e6);
+
+    unlink(config.filename().c_str());
+}
+
+static void test_expiry()
+{
+    auto config = makeConfig();
+    config.set_max_age_hours(1);
+    DriveProto drive;
+
+    saveDriveCalibration(config, "serial", drive, {200e6, 0}, NOW);
+    assert(findDriveCalibration(config, "serial", drive, NOW + 3599));
+    assert(!findDriveCalibration(config, "serial", drive, NOW + 3601));
+
+    /* Entries from the future are clearly wrong. */
+
+    assert(!findDriveCalibration(config, "serial", drive, NOW - 10));
+
+    unlink(config.filename().c_str());
+}
+
+static void test_drift()
+{
+    CalibrationCacheProto config;
+    config.set_max_drift(0.01);
+    DriveCalibration c{200e6, 0};
+
+    assert(isCalibrationStillValid(config, c, 201e6));
+    assert(isCalibrationStillValid(config, c, 198e6));
+    assert(!isCalibrationStillValid(config, c, 203e6));
+    assert(!isCalibrationStillValid(config, c, 0));
+}
+
+int main(int argc, const char* argv[])
+{
+    test_roundtrip();
+    test_expiry();
+    test_drift();
+    return 0;
+}
@@ -0,0 +1,151 @@
+#include "lib/core/globals.h"
+#include "lib/core/bytes.h"
+#include "lib/core/crc.h"
+#include "lib/core/crccorrector.h"
+#include "tests.h"
+#include <assert.h>
+
+static Bytes makeBlock(unsigned length, uint32_t seed)
+{
+    Bytes bytes(length);
+    for (unsigned i = 0; i < length; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        bytes[i] = seed >> 16;
+    }
+    return bytes;
+}
+
+/* Flips every single bit (and every pair of adjacent bits, in the order in
+ * which they're fed to the CRC) of the block and checks that the corrector
+ * puts it back. */
+
+template <typename F>
+static void testAllFlips(CrcCorrector::Algorithm algorithm,
+    unsigned width,
+    uint64_t poly,
+    const Bytes& good,
+    F check)
+{
+    CrcCorrector singles(algorithm, width, poly, false);
+    CrcCorrector pairs(algorithm, width, poly, true);
+    bool msbFirst = algorithm == CrcCorrector::CRC_MSB_FIRST;
+    uint64_t wanted = check(good);
+
+    auto flip = [&](Bytes& bytes, unsigned bit)
+    {
+        unsigned shift = msbFirst ? (7 - (bit % 8)) : (bit % 8);
+        bytes[bit / 8] ^= 1 << shift;
+    };
+
+    for (unsigned bit = 0; bit < good.size() * 8; bit++)
+    {
+        Bytes bad = good;
+        flip(bad, bit);
+        Bytes fixed = bad;
+        assert(singles.correct(fixed, check(bad), wanted));
+        assert(fixed == good);
+
+        if (bit != (good.size() * 8 - 1))
+        {
+            flip(bad, bit + 1);
+            fixed = bad;
+            assert(pairs.correct(fixed, check(bad), wanted));
+            assert(fixed == good);
+
+            fixed = bad;
+            assert(!singles.correct(fixed, check(bad), wanted));
+            assert(fixed == bad);
+        }
+    }
+}
+
+static void test_ccitt()
+{
+    testAllFlips(CrcCorrector::CRC_MSB_FIRST,
+        16,
+        CCITT_POLY,
+        makeBlock(516, 1),
+        [](const Bytes& bytes)
+        {
+            return crc16(CCITT_POLY, bytes);
+        });
+}
+
+static void test_reflected()
+{
+    testAllFlips(CrcCorrector::CRC_LSB_FIRST,
+        16,
+        MODBUS_POLY_REF,
+        makeBlock(130, 2),
+        [](const Bytes& bytes)
+        {
+            return crc16ref(MODBUS_POLY_REF, bytes);
+        });
+}
+
+static void test_ambiguous()
+{
+    /* CRC-8's polynomial has a period of 127 bits, so in a 64-byte block
+     * every single-bit error looks like several others and none can be
+     * corrected. */
+
+    crcspec spec = {8, 0x07, 0, 0, false, false};
+    CrcCorrector corrector(CrcCorrector::CRC_MSB_FIRST, 8, 0x07, false);
+    Bytes good = makeBlock(64, 3);
+    uint64_t wanted = generic_crc(spec, good);
+    for (unsigned bit = 0; bit < good.size() * 8; bit++)
+    {
+        Bytes bad = good;
+        bad[bit / 8] ^= 0x80 >> (bit % 8);
+        Bytes block = bad;
+        assert(!corrector.correct(block, generic_crc(spec, bad), wanted));
+        assert(block == bad);
+    }
+}
+
+static void test_check_value_errors()
+{
+    /* An error in the check value itself leaves the data alone. */
+
+    CrcCorrector corrector(CrcCorrector::CRC_MSB_FIRST, 16, CCITT_POLY, true);
+    Bytes good = makeBlock(260, 4);
+    uint16_t crc = crc16(CCITT_POLY, good);
+    for (unsigned bit = 0; bit < 16; bit++)
+    {
+        Bytes block = good;
+        assert(corrector.correct(block, crc, crc ^ (1 << bit)));
+        assert(block == good);
+    }
+}
+
+static void test_protected_header()
+{
+    /* Errors before the first correctable byte are refused. */
+
+    CrcCorrector corrector(CrcCorrector::CRC_MSB_FIRST, 16, CCITT_POLY, true);
+    Bytes good = makeBlock(260, 5);
+    uint16_t wanted = crc16(CCITT_POLY, good);
+
+    Bytes bad = good;
+    bad[2] ^= 0x10;
+    Bytes block = bad;
+    assert(!corrector.correct(block, crc16(CCITT_POLY, bad), wanted, 4));
+    assert(block == bad);
+
+    bad = good;
+    bad[4] ^= 0x10;
+    block = bad;
+    assert(corrector.correct(block, crc16(CCITT_POLY, bad), wanted, 4));
+    assert(block == good);
+}
+
+int main(int argc, const char* argv[])
+{
+    test_ccitt();
+    test_reflected();
+    test_ambiguous();
+    test_check_value_errors();
+    test_protected_header();
+    return 0;
+}
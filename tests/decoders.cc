@@ -0,0 +1,161 @@
+#include "lib/core/globals.h"
+#include "lib/data/fluxmap.h"
+#include "lib/data/disk.h"
+#include "lib/data/layout.h"
+#include "lib/data/sector.h"
+#include "lib/decoders/decoders.h"
+#include "lib/decoders/decoders.pb.h"
+#include "tests.h"
+#include <assert.h>
+
+/* A hard-sectored format where every index mark starts a sector, and the
+ * sectors just go round and round. The second sector read is bad, as is
+ * badSector every time. */
+
+class IndexDecoder : public Decoder
+{
+public:
+    IndexDecoder(const DecoderProto& config, unsigned badSector = UINT_MAX):
+        Decoder(config),
+        _badSector(badSector)
+    {
+    }
+
+    nanoseconds_t advanceToNextRecord() override
+    {
+        seekToIndexMark();
+        return 1000;
+    }
+
+    void decodeSectorRecord() override
+    {
+        _sector->logicalCylinder = _ltl->logicalCylinder;
+        _sector->logicalHead = _ltl->logicalHead;
+        _sector->logicalSector =
+            _ltl->diskSectorOrder[_count++ % _ltl->diskSectorOrder.size()];
+        _sector->status =
+            ((_count == 2) || (_sector->logicalSector == _badSector))
+                ? Sector::BAD_CHECKSUM
+                : Sector::OK;
+    }
+
+private:
+    unsigned _badSector;
+    unsigned _count = 0;
+};
+
+static std::shared_ptr<const Fluxmap> makeFluxmap(unsigned marks)
+{
+    auto fluxmap = std::make_shared<Fluxmap>();
+    for (unsigned i = 0; i < marks; i++)
+    {
+        for (unsigned j = 0; j < 10; j++)
+        {
+            fluxmap->appendInterval(100);
+            fluxmap->appendPulse();
+        }
+        fluxmap->appendIndex();
+    }
+    fluxmap->appendInterval(100);
+    fluxmap->appendPulse();
+    return fluxmap;
+}
+
+static void test_stop_when_complete()
+{
+    DecoderProto config;
+    DiskLayout diskLayout(1, 1, 4, 256);
+    auto ptl = diskLayout.layoutByPhysicalLocation.at({0, 0});
+    auto fluxmap = makeFluxmap(12);
+
+    /* Normally every record is decoded. */
+
+    auto all = IndexDecoder(config).decodeToSectors(fluxmap, ptl);
+    assertThat(all->allSectors.size()).isEqualTo(12);
+
+    /* The second sector is bad the first time round, so the decoder has to
+     * get to it again before it can stop. */
+
+    auto some = IndexDecoder(config).decodeToSectors(fluxmap, ptl, true);
+    assertThat(some->allSectors.size()).isEqualTo(6);
+    assertThat(some->allSectors[1]->status).isEqualTo(Sector::BAD_CHECKSUM);
+    assertThat(some->allSectors[5]->logicalSector)
+        .isEqualTo(some->allSectors[1]->logicalSector);
+}
+
+/* Stands in for a FluxEngine: plays back the flux a chunk at a time and, like
+ * the real thing, sends one more chunk after being told to stop. */
+
+static Bytes virtualRead(const Fluxmap& disk,
+    unsigned chunkSize,
+    const std::function<bool(const Bytes&)>& onData)
+{
+    const Bytes& flux = disk.rawBytes();
+    unsigned ptr = 0;
+    bool stopped = false;
+    while (ptr < flux.size())
+    {
+        Bytes chunk = flux.slice(ptr, std::min(chunkSize, flux.size() - ptr));
+        ptr += chunk.size();
+        if (stopped)
+            break;
+        stopped = onData(chunk);
+    }
+    return flux.slice(0, ptr);
+}
+
+static Bytes streamingRead(
+    Decoder& decoder, const Fluxmap& disk, bool* complete = nullptr)
+{
+    DiskLayout diskLayout(1, 1, 4, 256);
+    auto ptl = diskLayout.layoutByPhysicalLocation.at({0, 0});
+
+    /* Four sectors make one revolution. */
+
+    StreamingDecoder streamingDecoder(decoder, ptl, 4000 * NS_PER_TICK);
+    Fluxmap progress;
+    Bytes data = virtualRead(disk,
+        8,
+        [&](const Bytes& chunk)
+        {
+            progress.appendBytes(chunk);
+            return streamingDecoder.feed(progress);
+        });
+    if (complete)
+        *complete = streamingDecoder.complete();
+    return data;
+}
+
+static void test_streaming()
+{
+    DecoderProto config;
+    auto disk = makeFluxmap(20);
+
+    /* The first revolution has a bad sector, but the second fixes it, so the
+     * read can stop long before the end. */
+
+    {
+        IndexDecoder decoder(config);
+        bool complete;
+        Bytes data = streamingRead(decoder, *disk, &complete);
+        assert(complete);
+        assert(data.size() < (disk->bytes() / 2));
+    }
+
+    /* A sector which is never readable means everything gets read. */
+
+    {
+        IndexDecoder decoder(config, 1);
+        bool complete;
+        Bytes data = streamingRead(decoder, *disk, &complete);
+        assert(!complete);
+        assertThat(data.size()).isEqualTo(disk->bytes());
+    }
+}
+
+int main(int argc, const char* argv[])
+{
+    test_stop_when_complete();
+    test_streaming();
+    return 0;
+}
@@ -0,0 +1,185 @@
+#include "lib/core/globals.h"
+#include "lib/core/bytes.h"
+#include "lib/usb/usb.h"
+#include "lib/usb/usb.pb.h"
+#include "lib/usb/emulateddrive.h"
+#include "protocol.h"
+#include "tests.h"
+#include <assert.h>
+#include <thread>
+
+static EmulatorProto makeConfig()
+{
+    EmulatorProto config;
+    config.set_rpm_jitter(0.0);
+    config.set_time_scale(0.0);
+    return config;
+}
+
+struct Events
+{
+    std::vector<unsigned> pulses;
+    std::vector<unsigned> indexes;
+};
+
+/* Returns the times, in ticks, of everything in the flux. */
+
+static Events events(const Bytes& fldata)
+{
+    Events events;
+    unsigned ticks = 0;
+    ByteReader br(fldata);
+    while (!br.eof())
+    {
+        uint8_t b = br.read_8();
+        ticks += b & 0x3f;
+        if (b & F_BIT_INDEX)
+            events.indexes.push_back(ticks);
+        if (b & F_BIT_PULSE)
+            events.pulses.push_back(ticks);
+    }
+    return events;
+}
+
+static void test_unformatted()
+{
+    auto config = makeConfig();
+    EmulatedDrive drive(config);
+
+    assertThat(drive.measureRotationalPeriod()).isEqualTo(200e6);
+
+    /* A synced read starts at the index, and the disk's the same each time
+     * round. */
+
+    auto e1 = events(drive.read(0, true, 200e6));
+    auto e2 = events(drive.read(0, true, 200e6));
+    assert(!e1.indexes.empty() && (e1.indexes[0] == 0));
+    assert(e1.pulses.size() > 10000);
+    assert(e1.pulses == e2.pulses);
+
+    /* The other side isn't. */
+
+    auto e3 = events(drive.read(1, true, 200e6));
+    assert(e1.pulses != e3.pulses);
+}
+
+static void test_write()
+{
+    auto config = makeConfig();
+    EmulatedDrive drive(config);
+    drive.seek(5);
+
+    /* Write a pulse every 4us for the first half of the track. */
+
+    Bytes fldata;
+    ByteWriter bw(fldata);
+    for (int i = 0; i < 25000; i++)
+        bw.write_8(F_BIT_PULSE | (4 * TICKS_PER_US));
+    drive.write(0, fldata);
+
+    auto e = events(drive.read(0, true, 200e6));
+    for (int i = 0; i < 25000; i++)
+    {
+        int delta = e.pulses[i] - (i + 1) * 4 * TICKS_PER_US;
+        assert(std::abs(delta) < 2);
+    }
+
+    /* The rest of the track is what was there before. */
+
+    assert(e.pulses.size() > (25000 + 5000));
+
+    drive.erase(0);
+    assertThat(events(drive.read(0, true, 200e6)).pulses.size()).isEqualTo(0);
+
+    /* Other tracks are unaffected. */
+
+    drive.seek(4);
+    assert(events(drive.read(0, true, 200e6)).pulses.size() > 10000);
+}
+
+static void test_indexes()
+{
+    auto config = makeConfig();
+    config.set_rpm(360);
+    EmulatedDrive drive(config);
+
+    /* Reads can be limited by the number of index pulses rather than by
+     * time. */
+
+    auto e = events(drive.read(0, false, 0, 2));
+    assertThat(e.indexes.size()).isEqualTo(2);
+    double period = (e.indexes[1] - e.indexes[0]) * NS_PER_TICK;
+    assert(std::abs(period - 60e9 / 360) < 1000);
+}
+
+static void test_streaming()
+{
+    auto config = makeConfig();
+    EmulatedDrive drive(config);
+
+    int chunks = 0;
+    size_t streamed = 0;
+    Bytes fldata = drive.read(0,
+        true,
+        400e6,
+        0,
+        [&](const Bytes& chunk)
+        {
+            chunks++;
+            streamed += chunk.size();
+            return false;
+        });
+    assert(chunks > 10);
+    assertThat(streamed).isEqualTo(fldata.size());
+
+    /* Stopping early cuts the read short. */
+
+    size_t full = fldata.size();
+    fldata = drive.read(0,
+        true,
+        400e6,
+        0,
+        [&](const Bytes& chunk)
+        {
+            return true;
+        });
+    assert(fldata.size() < (full / 10));
+}
+
+/* Emulated devices can stand in for a pool of real ones. */
+
+static void test_pool()
+{
+    USB& usb1 = getUsb("emulator1");
+    USB& usb2 = getUsb("emulator2");
+    assert(&usb1 != &usb2);
+    assert(&getUsb("emulator1") == &usb1);
+
+    {
+        UsbBinding binding("emulator2");
+        assert(&getUsb() == &usb2);
+        assertThat(usbGetSerial()).isEqualTo("emulator2");
+    }
+
+    /* Bindings only apply to the thread which made them. */
+
+    UsbBinding binding("emulator1");
+    std::thread(
+        [&]
+        {
+            UsbBinding binding("emulator2");
+            assert(&getUsb() == &usb2);
+        })
+        .join();
+    assert(&getUsb() == &usb1);
+}
+
+int main(int argc, const char* argv[])
+{
+    test_unformatted();
+    test_write();
+    test_indexes();
+    test_streaming();
+    test_pool();
+    return 0;
+}
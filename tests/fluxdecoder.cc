@@ -0,0 +1,73 @@
+#include "lib/core/globals.h"
+#include "lib/data/fluxmap.h"
+#include "lib/data/fluxmapreader.h"
+#include "lib/decoders/fluxdecoder.h"
+#include "lib/decoders/decoders.pb.h"
+#include "protocol.h"
+#include "tests.h"
+#include <assert.h>
+
+static constexpr nanoseconds_t CLOCK = 2000.0;
+
+/* Makes a noisy, slowly drifting MFM-like fluxmap (intervals of two, three or
+ * four clocks) and returns the bits which it should decode to. */
+
+static std::vector<bool> makeFluxmap(Fluxmap& fluxmap, int intervals)
+{
+    std::vector<bool> bits = {true};
+    uint32_t seed = 1;
+    for (int i = 0; i < intervals; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        int cells = 2 + ((seed >> 16) % 3);
+        int jitter = (int)((seed >> 8) % 7) - 3;
+        double drift = 1.0 + 0.02 * sin(i / 5000.0);
+
+        fluxmap.appendInterval(cells * CLOCK * drift / NS_PER_TICK + jitter);
+        fluxmap.appendPulse();
+
+        for (int j = 1; j < cells; j++)
+            bits.push_back(false);
+        bits.push_back(true);
+    }
+    return bits;
+}
+
+static std::vector<bool> decode(const Fluxmap& fluxmap, bool fixedPoint)
+{
+    DecoderProto config;
+    config.set_fixed_point_pll(fixedPoint);
+
+    FluxmapReader fmr(fluxmap);
+    FluxDecoder decoder(&fmr, CLOCK, config);
+    return decoder.readBits();
+}
+
+static void test_matches_truth()
+{
+    Fluxmap fluxmap;
+    auto expected = makeFluxmap(fluxmap, 100000);
+
+    /* The last few bits depend on how the end of the data is handled. */
+
+    for (bool fixedPoint : {false, true})
+    {
+        auto bits = decode(fluxmap, fixedPoint);
+        assert(bits.size() >= expected.size() - 4);
+        assert(std::equal(bits.begin(), bits.end() - 4, expected.begin()));
+    }
+}
+
+static void test_fixed_matches_floating()
+{
+    Fluxmap fluxmap;
+    makeFluxmap(fluxmap, 1000000);
+    assert(decode(fluxmap, false) == decode(fluxmap, true));
+}
+
+int main(int argc, const char* argv[])
+{
+    test_matches_truth();
+    test_fixed_matches_floating();
+    return 0;
+}
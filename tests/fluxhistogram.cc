@@ -0,0 +1,123 @@
+#include "lib/core/globals.h"
+#include "lib/data/fluxmap.h"
+#include "lib/data/fluxmapreader.h"
+#include "lib/data/fluxhistogram.h"
+#include "protocol.h"
+#include "tests.h"
+#include <assert.h>
+
+/* Makes a long, noisy fluxmap (big enough to be split across threads) with
+ * an index mark every 100000 intervals. */
+
+static std::unique_ptr<Fluxmap> makeFluxmap()
+{
+    auto fluxmap = std::make_unique<Fluxmap>();
+    uint32_t seed = 1;
+    for (int i = 0; i < 500000; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        unsigned interval = 20 + ((seed >> 16) % 40);
+        if ((seed >> 8) % 1000 == 0)
+            interval += 300;
+        fluxmap->appendInterval(interval);
+        fluxmap->appendPulse();
+        if ((i % 100000) == 50000)
+            fluxmap->appendIndex();
+    }
+    return fluxmap;
+}
+
+/* The obvious, slow implementation. */
+
+static std::vector<uint32_t> referenceHistogram(
+    const Fluxmap& fluxmap, nanoseconds_t start, nanoseconds_t end)
+{
+    std::vector<uint32_t> buckets(256);
+    FluxmapReader fmr(fluxmap);
+    while (!fmr.eof())
+    {
+        nanoseconds_t now = fmr.tell().ns();
+        unsigned interval;
+        if (!fmr.findEvent(F_BIT_PULSE, interval))
+            break;
+        if ((now >= start) && (now < end) && (interval < 256))
+            buckets[interval]++;
+    }
+    return buckets;
+}
+
+static void test_simple()
+{
+    Fluxmap fluxmap(Bytes{F_BIT_PULSE | 0x10,
+        F_BIT_PULSE | 0x10,
+        0x3f,
+        F_BIT_PULSE | 0x01,
+        F_BIT_INDEX | 0x08,
+        F_BIT_PULSE | 0x08,
+        0x05});
+
+    FluxHistogram h(fluxmap);
+    assertThat(h[0x10]).isEqualTo(3);
+    assertThat(h[0x40]).isEqualTo(1);
+    assertThat(h.intervals()).isEqualTo(4);
+    assertThat(h.max()).isEqualTo(3);
+}
+
+static void test_matches_reference()
+{
+    auto fluxmapp = makeFluxmap();
+    const Fluxmap& fluxmap = *fluxmapp;
+
+    FluxHistogram h(fluxmap);
+    assert(h.buckets() == referenceHistogram(fluxmap, 0, INFINITY));
+    assertThat(h.intervals()).isEqualTo(500000);
+
+    nanoseconds_t start = fluxmap.duration() / 3;
+    nanoseconds_t end = fluxmap.duration() * 2 / 3;
+    FluxHistogram w(fluxmap, {start, end});
+    assert(w.buckets() == referenceHistogram(fluxmap, start, end));
+}
+
+static void test_per_revolution()
+{
+    auto fluxmapp = makeFluxmap();
+    const Fluxmap& fluxmap = *fluxmapp;
+
+    auto revolutions = FluxHistogram::perRevolution(fluxmap);
+    assertThat(revolutions.size()).isEqualTo(6);
+
+    FluxHistogram total;
+    for (const auto& h : revolutions)
+        total += h;
+    assert(total.buckets() == FluxHistogram(fluxmap).buckets());
+    assertThat(total.intervals()).isEqualTo(500000);
+}
+
+static void test_guess_clock()
+{
+    Fluxmap fluxmap;
+    for (int i = 0; i < 1000; i++)
+    {
+        fluxmap.appendInterval(24 + (i % 3) - 1);
+        fluxmap.appendPulse();
+        fluxmap.appendInterval(48);
+        fluxmap.appendPulse();
+    }
+
+    auto data = FluxHistogram(fluxmap).guessClock();
+    assertThat(data.median).isEqualTo(24 * NS_PER_TICK);
+
+    /* With no flux there's no pulse to find. */
+
+    data = FluxHistogram().guessClock();
+    assertThat(data.median).isEqualTo(0);
+}
+
+int main(int argc, const char* argv[])
+{
+    test_simple();
+    test_matches_reference();
+    test_per_revolution();
+    test_guess_clock();
+    return 0;
+}
@@ -0,0 +1,151 @@
+#include "lib/core/globals.h"
+#include "lib/data/fluxmap.h"
+#include "lib/data/fluxmapreader.h"
+#include "lib/decoders/decoders.pb.h"
+#include "protocol.h"
+#include "tests.h"
+#include <assert.h>
+
+static constexpr size_t BUDGET = 256 * 1024 * 1024;
+
+/* A noisy capture with long intervals, index marks (some on pulses, some
+ * not) and the odd desync. */
+
+static std::unique_ptr<Fluxmap> makeFluxmap(int intervals)
+{
+    auto fluxmap = std::make_unique<Fluxmap>();
+    uint32_t seed = 1;
+    for (int i = 0; i < intervals; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        fluxmap->appendInterval(20 + ((seed >> 16) % 200));
+        switch ((seed >> 8) % 500)
+        {
+            case 0:
+                fluxmap->appendIndex();
+                break;
+
+            case 1:
+                fluxmap->appendDesync();
+                fluxmap->appendInterval(3);
+                break;
+        }
+        fluxmap->appendPulse();
+        if (((seed >> 8) % 500) == 2)
+            fluxmap->appendIndex();
+    }
+    fluxmap->appendInterval(100);
+    return fluxmap;
+}
+
+static void test_view()
+{
+    Fluxmap fluxmap(Bytes{F_BIT_PULSE | 0x10,
+        0x3f,
+        F_BIT_PULSE | 0x01,
+        F_BIT_INDEX | 0x08,
+        F_BIT_PULSE | 0x08,
+        F_BIT_PULSE | F_BIT_INDEX | 0x04,
+        0x05});
+
+    auto intervals = fluxmap.getIntervals();
+    assert(intervals);
+    assert(
+        intervals->intervals == (std::vector<uint32_t>{0x10, 0x40, 0x10, 4}));
+    assert(intervals->byteOffsets == (std::vector<uint32_t>{1, 3, 5, 6}));
+    assert(intervals->indexes == (std::vector<uint32_t>{2, 3}));
+    assertThat(intervals->ticks).isEqualTo(fluxmap.ticks());
+
+    /* The view is cached until the fluxmap changes. */
+
+    assert(fluxmap.getIntervals() == intervals);
+    fluxmap.appendPulse();
+    auto changed = fluxmap.getIntervals();
+    assert(changed != intervals);
+    assertThat(changed->intervals.size()).isEqualTo(5);
+}
+
+static void test_reader_matches_bytecode()
+{
+    auto fluxmap = makeFluxmap(100000);
+    DecoderProto config;
+
+    /* One reader with the view and one without. */
+
+    Fluxmap::setIntervalsBudget(0);
+    FluxmapReader slow(*fluxmap, config);
+    Fluxmap::setIntervalsBudget(BUDGET);
+    FluxmapReader fast(*fluxmap, config);
+
+    uint32_t seed = 2;
+    while (!slow.eof())
+    {
+        seed = seed * 1103515245 + 12345;
+        unsigned slowTicks, fastTicks;
+        switch ((seed >> 16) % 16)
+        {
+            case 0:
+                slow.findEvent(F_BIT_INDEX, slowTicks);
+                fast.findEvent(F_BIT_INDEX, fastTicks);
+                break;
+
+            case 1:
+            {
+                int slowEvent, fastEvent;
+                slow.getNextEvent(slowEvent, slowTicks);
+                fast.getNextEvent(fastEvent, fastTicks);
+                assertThat(fastEvent).isEqualTo(slowEvent);
+                break;
+            }
+
+            case 2:
+            {
+                /* Jump back a bit, probably not to a pulse. */
+
+                unsigned pos = slow.tell().bytes;
+                pos = (pos > 64) ? (pos - 64) : 0;
+                slow.seekToByte(pos);
+                fast.seekToByte(pos);
+                slowTicks = fastTicks = 0;
+                break;
+            }
+
+            default:
+                assertThat(fast.findEvent(F_BIT_PULSE, fastTicks))
+                    .isEqualTo(slow.findEvent(F_BIT_PULSE, slowTicks));
+        }
+        assertThat(fastTicks).isEqualTo(slowTicks);
+        assertThat(fast.tell().bytes).isEqualTo(slow.tell().bytes);
+        assertThat(fast.tell().ticks).isEqualTo(slow.tell().ticks);
+    }
+}
+
+static void test_budget()
+{
+    auto fluxmap = makeFluxmap(1000);
+
+    Fluxmap::setIntervalsBudget(fluxmap->bytes());
+    assert(!fluxmap->getIntervals());
+
+    Fluxmap::setIntervalsBudget(fluxmap->bytes() * 8);
+    auto intervals = fluxmap->getIntervals();
+    assert(intervals);
+
+    /* The memory is only given back once the view has gone. */
+
+    auto other = makeFluxmap(1000);
+    assert(!other->getIntervals());
+    fluxmap->appendPulse();
+    intervals = nullptr;
+    assert(other->getIntervals());
+
+    Fluxmap::setIntervalsBudget(BUDGET);
+}
+
+int main(int argc, const char* argv[])
+{
+    test_view();
+    test_reader_matches_bytecode();
+    test_budget();
+    return 0;
+}
@@ -0,0 +1,181 @@
+#include "lib/core/globals.h"
+#include "lib/data/fluxmap.h"
+#include "lib/data/fluxpyramid.h"
+#include "lib/data/fluxmapreader.h"
+#include "protocol.h"
+#include "tests.h"
+#include <assert.h>
+
+static std::unique_ptr<Fluxmap> makeFluxmap()
+{
+    auto fluxmap = std::make_unique<Fluxmap>();
+    uint32_t seed = 1;
+    for (int i = 0; i < 100000; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        unsigned interval = 20 + ((seed >> 16) % 40);
+        if ((seed >> 8) % 1000 == 0)
+            interval += 300;
+        fluxmap->appendInterval(interval);
+        fluxmap->appendPulse();
+    }
+    return fluxmap;
+}
+
+/* The obvious, slow implementation: every pulse whose time is in
+ * [start, end). */
+
+static FluxPyramid::Bucket referenceBucket(
+    const Fluxmap& fluxmap, unsigned start, unsigned end)
+{
+    FluxPyramid::Bucket bucket;
+    const uint8_t* ptr = fluxmap.ptr();
+    unsigned now = 0;
+    unsigned interval = 0;
+    for (size_t i = 0; i < fluxmap.bytes(); i++)
+    {
+        now += ptr[i] & 0x3f;
+        interval += ptr[i] & 0x3f;
+        if (ptr[i] & F_BIT_PULSE)
+        {
+            if ((now >= start) && (now < end))
+            {
+                bucket.pulses++;
+                bucket.minInterval = std::min<unsigned>(bucket.minInterval,
+                    std::min<unsigned>(interval, UINT16_MAX));
+                bucket.maxInterval = std::max<unsigned>(bucket.maxInterval,
+                    std::min<unsigned>(interval, UINT16_MAX));
+            }
+            interval = 0;
+        }
+    }
+    return bucket;
+}
+
+static void test_simple()
+{
+    Fluxmap fluxmap(Bytes{F_BIT_PULSE | 0x10,
+        F_BIT_PULSE | 0x10,
+        0x3f,
+        F_BIT_PULSE | 0x01,
+        F_BIT_INDEX | 0x08,
+        F_BIT_PULSE | 0x08,
+        0x05});
+
+    auto pyramid = std::make_shared<FluxPyramid>(fluxmap);
+    const auto& level0 = pyramid->level(0);
+    assertThat(level0.size()).isEqualTo(4);
+    assertThat(level0[0].pulses).isEqualTo(1);
+    assertThat(level0[1].pulses).isEqualTo(1);
+    assertThat(level0[1].minInterval).isEqualTo(0x10);
+    assertThat(level0[2].pulses).isEqualTo(0);
+    assertThat(level0[3].pulses).isEqualTo(2);
+    assertThat(level0[3].minInterval).isEqualTo(0x10);
+    assertThat(level0[3].maxInterval).isEqualTo(0x40);
+
+    const auto& top = pyramid->level(pyramid->levels() - 1);
+    assertThat(top.size()).isEqualTo(1);
+    assertThat(top[0].pulses).isEqualTo(4);
+    assertThat(top[0].minInterval).isEqualTo(0x10);
+    assertThat(top[0].maxInterval).isEqualTo(0x40);
+}
+
+static void test_levels_match_reference()
+{
+    auto fluxmap = makeFluxmap();
+    auto pyramid = std::make_shared<FluxPyramid>(*fluxmap);
+
+    for (unsigned level = 0; level < pyramid->levels(); level += 3)
+    {
+        unsigned width = pyramid->bucketTicks(level);
+        const auto& buckets = pyramid->level(level);
+        for (unsigned i = 0; i < buckets.size(); i += 97)
+        {
+            auto ref = referenceBucket(*fluxmap, i * width, (i + 1) * width);
+            assertThat(buckets[i].pulses).isEqualTo(ref.pulses);
+            if (ref.pulses)
+            {
+                assertThat(buckets[i].minInterval).isEqualTo(ref.minInterval);
+                assertThat(buckets[i].maxInterval).isEqualTo(ref.maxInterval);
+            }
+        }
+    }
+}
+
+static void test_columns()
+{
+    auto fluxmap = makeFluxmap();
+    auto pyramid = std::make_shared<FluxPyramid>(*fluxmap);
+
+    /* Columns covering the whole fluxmap see every pulse exactly once. */
+
+    double ticksPerColumn = 1000.7;
+    unsigned count = fluxmap->ticks() / ticksPerColumn + 2;
+    auto columns = pyramid->columns(0, ticksPerColumn, count);
+    uint64_t total = 0;
+    for (const auto& column : columns)
+    {
+        total += column.pulses;
+        assert(column.density() <=
+               pyramid->maxDensity(pyramid->levelFor(ticksPerColumn)));
+    }
+    assertThat(total).isEqualTo(100000);
+
+    /* Each column consists of whole buckets which start inside it. */
+
+    unsigned level = pyramid->levelFor(ticksPerColumn);
+    unsigned width = pyramid->bucketTicks(level);
+    assert(width <= ticksPerColumn);
+    assert((width * 2) > ticksPerColumn);
+    auto column = pyramid->columns(5000.3, ticksPerColumn, 1)[0];
+    unsigned start = (5000.3 + width - 1) / width;
+    unsigned end = (5000.3 + ticksPerColumn + width - 1) / width;
+    auto ref = referenceBucket(*fluxmap, start * width, end * width);
+    assertThat(column.pulses).isEqualTo(ref.pulses);
+    assertThat(column.ticks).isEqualTo((end - start) * width);
+
+    /* Columns past the end are empty. */
+
+    auto past = pyramid->columns(fluxmap->ticks() + 10000.0, 100.0, 3);
+    for (const auto& column : past)
+    {
+        assertThat(column.pulses).isEqualTo(0);
+        assertThat(column.density()).isEqualTo(0.0);
+    }
+}
+
+static void test_seek_position()
+{
+    auto fluxmap = makeFluxmap();
+    auto pyramid = std::make_shared<FluxPyramid>(*fluxmap);
+    unsigned last = fluxmap->ticks();
+
+    for (unsigned start : {0U, 1U, 1024U, 5000U, 123457U, last})
+    {
+        auto pos = pyramid->seekPosition(start);
+        assert(pos.ticks <= start);
+        assert((start - pos.ticks) < ((1 << FluxPyramid::SEEK_SHIFT) + 64));
+
+        /* Reading on from there sees the same pulses as the reference. */
+
+        FluxmapReader fmr(*fluxmap);
+        fmr.seek(pos);
+        unsigned pulses = 0;
+        unsigned ticks;
+        while (fmr.findEvent(F_BIT_PULSE, ticks) &&
+               (fmr.tell().ticks < (start + 5000)))
+            if (fmr.tell().ticks >= start)
+                pulses++;
+        assertThat(pulses).isEqualTo(
+            referenceBucket(*fluxmap, start, start + 5000).pulses);
+    }
+}
+
+int main(int argc, const char* argv[])
+{
+    test_simple();
+    test_levels_match_reference();
+    test_columns();
+    test_seek_position();
+    return 0;
+}
@@ -0,0 +1,164 @@
+#include "lib/core/globals.h"
+#include "lib/data/fluxmap.h"
+#include "lib/data/fluxmapreader.h"
+#include "lib/data/fluxscan.h"
+#include "lib/decoders/decoders.pb.h"
+#include "protocol.h"
+#include "tests.h"
+#include <assert.h>
+
+/* Random bytecode, biased towards the awkward cases. */
+
+static Bytes makeNoise(unsigned length)
+{
+    Bytes bytes(length);
+    uint32_t seed = 2;
+    for (unsigned i = 0; i < length; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        uint8_t b = seed >> 16;
+        switch ((seed >> 8) % 8)
+        {
+            case 0:
+                b = 0;
+                break;
+
+            case 1:
+            case 2:
+            case 3:
+                b &= 0x3f;
+                break;
+
+            case 4:
+            case 5:
+                b = 0x3f;
+                break;
+        }
+        bytes[i] = b;
+    }
+    return bytes;
+}
+
+/* The original byte-at-a-time FluxmapReader, for comparison. */
+
+struct ReferenceReader
+{
+    const Bytes& bytes;
+    unsigned pos = 0;
+    unsigned ticks = 0;
+
+    void getNextEvent(int& event, unsigned& t)
+    {
+        t = 0;
+        while (pos != bytes.size())
+        {
+            uint8_t b = bytes[pos++];
+            t += b & 0x3f;
+            if (!b || (b & (F_BIT_PULSE | F_BIT_INDEX)))
+            {
+                ticks += t;
+                event = b & 0xc0;
+                return;
+            }
+        }
+        ticks += t;
+        event = F_EOF;
+    }
+
+    bool findEvent(int event, unsigned& t)
+    {
+        t = 0;
+        while (pos != bytes.size())
+        {
+            unsigned thisTicks;
+            int thisEvent;
+            getNextEvent(thisEvent, thisTicks);
+            t += thisTicks;
+            if (thisEvent == F_EOF)
+                return false;
+            if ((event == thisEvent) || (event & thisEvent))
+                return true;
+        }
+        return false;
+    }
+};
+
+static void test_scan_matches_scalar()
+{
+    Bytes noise = makeNoise(4096);
+    const uint8_t* base = noise.cbegin();
+
+    for (uint8_t stopMask : {0x00, 0x40, 0x80, 0xc0})
+        for (bool stopOnZero : {false, true})
+            for (unsigned start = 0; start < 100; start++)
+                for (unsigned len : {0, 1, 15, 16, 17, 31, 32, 33, 200, 3000})
+                {
+                    const uint8_t* end = base + start + len;
+                    unsigned fastTicks = 0;
+                    unsigned slowTicks = 0;
+                    const uint8_t* fast = scanFlux(
+                        base + start, end, stopMask, stopOnZero, fastTicks);
+                    const uint8_t* slow = scanFluxScalar(
+                        base + start, end, stopMask, stopOnZero, slowTicks);
+                    assert(fast == slow);
+                    assertThat(fastTicks).isEqualTo(slowTicks);
+                }
+}
+
+static void test_reader_matches_reference()
+{
+    Fluxmap fluxmap(makeNoise(100000));
+    DecoderProto config;
+    FluxmapReader fmr(fluxmap, config);
+    ReferenceReader ref{fluxmap.rawBytes()};
+
+    static const int events[] = {-1,
+        F_BIT_PULSE,
+        F_BIT_INDEX,
+        F_BIT_PULSE | F_BIT_INDEX,
+        F_DESYNC,
+        F_EOF};
+    uint32_t seed = 3;
+    while (!fmr.eof())
+    {
+        seed = seed * 1103515245 + 12345;
+        int event = events[(seed >> 16) % std::size(events)];
+        if (event == F_EOF)
+            event = F_BIT_PULSE; /* don't run off the end too soon */
+
+        unsigned gotTicks, wantedTicks;
+        if (event == -1)
+        {
+            int gotEvent, wantedEvent;
+            fmr.getNextEvent(gotEvent, gotTicks);
+            ref.getNextEvent(wantedEvent, wantedTicks);
+            assertThat(gotEvent).isEqualTo(wantedEvent);
+        }
+        else
+        {
+            bool got = fmr.findEvent(event, gotTicks);
+            bool wanted = ref.findEvent(event, wantedTicks);
+            assertThat(got).isEqualTo(wanted);
+        }
+        assertThat(gotTicks).isEqualTo(wantedTicks);
+        assertThat(fmr.tell().bytes).isEqualTo(ref.pos);
+        assertThat(fmr.tell().ticks).isEqualTo(ref.ticks);
+    }
+
+    /* Looking for something which never occurs runs to the end. */
+
+    FluxmapReader fmr2(fluxmap, config);
+    ReferenceReader ref2{fluxmap.rawBytes()};
+    unsigned gotTicks, wantedTicks;
+    assertThat(fmr2.findEvent(F_EOF, gotTicks))
+        .isEqualTo(ref2.findEvent(F_EOF, wantedTicks));
+    assertThat(gotTicks).isEqualTo(wantedTicks);
+    assertThat(fmr2.tell().bytes).isEqualTo(ref2.pos);
+}
+
+int main(int argc, const char* argv[])
+{
+    test_scan_matches_scalar();
+    test_reader_matches_reference();
+    return 0;
+}
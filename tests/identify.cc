@@ -0,0 +1,166 @@
+#include "lib/core/globals.h"
+#include "lib/data/disk.h"
+#include "lib/data/layout.h"
+#include "lib/data/sector.h"
+#include "lib/config/config.h"
+#include "lib/fluxsource/fluxsource.h"
+#include "lib/fluxsource/fluxsource.pb.h"
+#include "lib/usb/usb.pb.h"
+#include "lib/algorithms/identify.h"
+#include "tests.h"
+#include <assert.h>
+#include <google/protobuf/text_format.h>
+
+static std::shared_ptr<const Sector> makeSector(const LogicalTrackLayout& ltl,
+    unsigned id,
+    Sector::Status status,
+    unsigned size,
+    nanoseconds_t clock = 2000)
+{
+    auto sector = std::make_shared<Sector>(
+        LogicalLocation{ltl.logicalCylinder, ltl.logicalHead, id});
+    sector->status = status;
+    sector->data = Bytes(size);
+    sector->data[0] = id;
+    sector->clock = clock;
+    return sector;
+}
+
+static void test_tally()
+{
+    DiskLayout diskLayout(80, 2, 9, 512);
+    auto ptl = diskLayout.layoutByPhysicalLocation.at({0, 0});
+    const auto& ltl = *ptl->logicalTrackLayout;
+
+    Track track;
+    track.ptl = ptl;
+    track.ltl = ptl->logicalTrackLayout;
+    for (unsigned i = 0; i < 8; i++)
+        track.allSectors.push_back(
+            makeSector(ltl, ltl.diskSectorOrder[i], Sector::OK, 512));
+
+    /* A second read of a good sector isn't counted twice. */
+    track.allSectors.push_back(
+        makeSector(ltl, ltl.diskSectorOrder[0], Sector::OK, 512));
+
+    track.allSectors.push_back(
+        makeSector(ltl, ltl.diskSectorOrder[8], Sector::BAD_CHECKSUM, 512));
+    track.allSectors.push_back(makeSector(ltl, 20, Sector::OK, 512));
+
+    IdentifiedFormat result;
+    result.add(track);
+    result.finish();
+    assertThat(result.expected).isEqualTo(9);
+    assertThat(result.good).isEqualTo(8);
+    assertThat(result.bad).isEqualTo(1);
+    assertThat(result.spurious).isEqualTo(1);
+    assertThat(result.clockSpread).isEqualTo(0.0);
+    assert(fabs(result.score - (8.0 / 9.0 - 0.5 / 9.0)) < 1e-9);
+}
+
+static void test_wrong_size()
+{
+    /* Sectors of the wrong size don't fit the geometry. */
+
+    DiskLayout diskLayout(80, 2, 9, 512);
+    auto ptl = diskLayout.layoutByPhysicalLocation.at({0, 1});
+    const auto& ltl = *ptl->logicalTrackLayout;
+
+    Track track;
+    track.ptl = ptl;
+    track.ltl = ptl->logicalTrackLayout;
+    for (unsigned id : ltl.diskSectorOrder)
+        track.allSectors.push_back(makeSector(ltl, id, Sector::OK, 256));
+
+    IdentifiedFormat result;
+    result.add(track);
+    result.finish();
+    assertThat(result.good).isEqualTo(0);
+    assertThat(result.spurious).isEqualTo(9);
+    assert(result.score < 0.0);
+}
+
+static void test_clock_spread()
+{
+    /* The same yield with inconsistent clocks scores lower. */
+
+    DiskLayout diskLayout(80, 2, 9, 512);
+    auto ptl = diskLayout.layoutByPhysicalLocation.at({0, 0});
+    const auto& ltl = *ptl->logicalTrackLayout;
+
+    Track steady;
+    steady.ltl = ptl->logicalTrackLayout;
+    Track wobbly;
+    wobbly.ltl = ptl->logicalTrackLayout;
+    for (unsigned id : ltl.diskSectorOrder)
+    {
+        steady.allSectors.push_back(makeSector(ltl, id, Sector::OK, 512));
+        wobbly.allSectors.push_back(makeSector(
+            ltl, id, Sector::OK, 512, (id & 1) ? 2000 : 4000));
+    }
+
+    IdentifiedFormat steadyResult;
+    steadyResult.add(steady);
+    steadyResult.finish();
+    IdentifiedFormat wobblyResult;
+    wobblyResult.add(wobbly);
+    wobblyResult.finish();
+
+    assertThat(steadyResult.score).isEqualTo(1.0);
+    assert(wobblyResult.clockSpread > 0.1);
+    assert(wobblyResult.score < steadyResult.score);
+}
+
+static void test_emulated()
+{
+    /* Reads from a drive are timed in revolutions, so the samples are only
+     * any good if the drive's speed has been measured first. */
+
+    globalConfig().clear();
+    auto* overrides = globalConfig().overrides();
+    overrides->mutable_flux_source()->set_type(FLUXTYPE_DRIVE);
+    auto* emulator = overrides->mutable_usb()->mutable_emulator();
+    emulator->set_rpm_jitter(0.0);
+    emulator->set_time_scale(0.0);
+
+    auto fluxSource = FluxSource::create(globalConfig());
+    auto samples = readIdentifySamples(*fluxSource, {{0, 0}, {0, 1}});
+    assertThat(samples.size()).isEqualTo(2);
+    double revolutions = globalConfig()->drive().revolutions();
+    for (const auto& sample : samples)
+        assert(sample.fluxmap->duration() > ((revolutions - 0.5) * 200e6));
+
+    /* The emulated disk is unformatted, so nothing should match. */
+
+    ConfigProto ibm;
+    assert(google::protobuf::TextFormat::ParseFromString(R"M(
+        decoder {
+            ibm {}
+        }
+
+        layout {
+            tracks: 80
+            sides: 2
+            layoutdata {
+                sector_size: 512
+                physical {
+                    start_sector: 1
+                    count: 9
+                }
+            }
+        }
+    )M",
+        &ibm));
+    auto results = identifyFormat(samples, {{"ibm", &ibm}}, globalConfig());
+    assertThat(results.size()).isEqualTo(1);
+    assertThat(results[0].good).isEqualTo(0);
+}
+
+int main(int argc, const char* argv[])
+{
+    test_tally();
+    test_wrong_size();
+    test_clock_spread();
+    test_emulated();
+    return 0;
+}
@@ -8,6 +8,7 @@
 #include <google/protobuf/text_format.h>
 #include <assert.h>
 #include <regex>
+#include <thread>
 
 using namespace snowhouse;
 
@@ -66,11 +67,34 @@ static void test_option_validity()
         Equals(true));
 }
 
+/* Bound configs are only seen by the thread which bound them. */
+
+static void test_config_binding()
+{
+    globalConfig().clear();
+    globalConfig().set("drive.drive", "0");
+
+    Config config = globalConfig();
+    config.set("drive.drive", "1");
+    {
+        ConfigBinding binding(config);
+        AssertThat(globalConfig()->drive().drive(), Equals(1));
+        std::thread(
+            [&]
+            {
+                AssertThat(globalConfig()->drive().drive(), Equals(0));
+            })
+            .join();
+    }
+    AssertThat(globalConfig()->drive().drive(), Equals(0));
+}
+
 int main(int argc, const char* argv[])
 {
     try
     {
         test_option_validity();
+        test_config_binding();
         return 0;
     }
     catch (const ErrorException& e)
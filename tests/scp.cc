@@ -0,0 +1,111 @@
+#include "lib/core/globals.h"
+#include "lib/core/bytes.h"
+#include "lib/data/fluxmap.h"
+#include "lib/external/scp.h"
+#include "tests.h"
+#include <assert.h>
+
+/* The obvious, slow implementation, with overflows carried across
+ * revolutions. */
+
+static std::unique_ptr<Fluxmap> referenceConvert(
+    const std::vector<Bytes>& revolutions, nanoseconds_t resolution)
+{
+    auto fluxmap = std::make_unique<Fluxmap>();
+    nanoseconds_t pending = 0;
+    for (int revolution = 0; revolution < revolutions.size(); revolution++)
+    {
+        if (revolution != 0)
+            fluxmap->appendIndex();
+
+        ByteReader br(revolutions[revolution]);
+        while (!br.eof())
+        {
+            uint16_t interval = br.read_be16();
+            if (interval)
+            {
+                fluxmap->appendInterval(
+                    (interval + pending) * resolution / NS_PER_TICK);
+                fluxmap->appendPulse();
+                pending = 0;
+            }
+            else
+                pending += 0x10000;
+        }
+    }
+    return fluxmap;
+}
+
+static std::vector<ScpRevolutionCells> index(
+    const std::vector<Bytes>& revolutions)
+{
+    std::vector<ScpRevolutionCells> cells;
+    uint32_t overflow = 0;
+    for (const auto& data : revolutions)
+    {
+        uint32_t count = data.size() / 2;
+        cells.push_back({data.cbegin(), count, overflow});
+
+        uint32_t trailing = 0;
+        while ((trailing < count) &&
+               !data[(count - trailing - 1) * 2] &&
+               !data[(count - trailing - 1) * 2 + 1])
+            trailing++;
+        overflow = (trailing == count) ? (overflow + trailing) : trailing;
+    }
+    return cells;
+}
+
+static void check(const std::vector<Bytes>& revolutions)
+{
+    for (nanoseconds_t resolution : {25.0, 50.0, 75.0})
+    {
+        auto expected = referenceConvert(revolutions, resolution);
+        auto actual = readScpRevolutions(index(revolutions), resolution);
+        assert(actual->rawBytes() == expected->rawBytes());
+        assertThat(actual->ticks()).isEqualTo(expected->ticks());
+    }
+}
+
+static void test_simple()
+{
+    check({Bytes{0x00, 0x50, 0x01, 0x00}});
+    check({Bytes{0x00, 0x50, 0x00, 0x00, 0x00, 0x01}});
+    check({Bytes{0x00, 0x50, 0x00, 0x00}, Bytes{0x00, 0x02}});
+    check({Bytes{0x00, 0x00}, Bytes{}, Bytes{0x00, 0x00}, Bytes{0x00, 0x03}});
+    check({Bytes{}, Bytes{0x00, 0x10}});
+}
+
+static void test_random()
+{
+    /* Enough cells to be converted in parallel, with the occasional overflow
+     * cell (including at the ends of revolutions). */
+
+    uint32_t seed = 1;
+    std::vector<Bytes> revolutions;
+    for (int revolution = 0; revolution < 5; revolution++)
+    {
+        Bytes data;
+        ByteWriter bw(data);
+        for (int i = 0; i < 50000 + revolution; i++)
+        {
+            seed = seed * 1103515245 + 12345;
+            uint16_t cell = 40 + ((seed >> 16) % 200);
+            if ((seed >> 8) % 500 == 0)
+                cell = 0;
+            bw.write_be16(cell);
+        }
+        if (revolution == 2)
+            bw.write_be16(0);
+        revolutions.push_back(data);
+    }
+
+    check(revolutions);
+}
+
+int main(int argc, const char* argv[])
+{
+    test_simple();
+    test_random();
+    return 0;
+}
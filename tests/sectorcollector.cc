@@ -0,0 +1,128 @@
+#include "lib/core/globals.h"
+#include "lib/core/crc.h"
+#include "lib/data/sector.h"
+#include "lib/data/sectorcollector.h"
+#include "tests.h"
+#include <assert.h>
+
+static std::shared_ptr<const Sector> makeSector(
+    unsigned id, Sector::Status status, const Bytes& data = {})
+{
+    auto sector = std::make_shared<Sector>(LogicalLocation{1, 0, id});
+    sector->status = status;
+    sector->data = data;
+    return sector;
+}
+
+static const Sector& find(
+    const std::vector<std::shared_ptr<const Sector>>& sectors, unsigned id)
+{
+    for (const auto& sector : sectors)
+        if (sector->logicalSector == id)
+            return *sector;
+    error("sector {} not found", id);
+}
+
+static void test_prefers_good()
+{
+    SectorCollector collector;
+    collector.add(makeSector(0, Sector::BAD_CHECKSUM, Bytes{1}));
+    collector.add(makeSector(1, Sector::OK, Bytes{2}));
+    collector.add(makeSector(0, Sector::OK, Bytes{3}));
+    collector.add(makeSector(1, Sector::BAD_CHECKSUM, Bytes{4}));
+    collector.add(makeSector(2, Sector::DATA_MISSING));
+    collector.add(makeSector(2, Sector::BAD_CHECKSUM));
+
+    auto sectors = collector.sectors();
+    assertThat(sectors.size()).isEqualTo(3);
+    assert(find(sectors, 0).data == Bytes{3});
+    assert(find(sectors, 1).data == Bytes{2});
+    assertThat(find(sectors, 2).status).isEqualTo(Sector::DATA_MISSING);
+
+    assert(collector.contains({1, 0, 2}));
+    assert(!collector.contains({1, 0, 3}));
+}
+
+static void test_identical_reads()
+{
+    SectorCollector collector;
+    auto first = makeSector(0, Sector::OK, Bytes{1, 2, 3});
+    collector.add(first);
+    collector.add(makeSector(0, Sector::OK, Bytes{1, 2, 3}));
+
+    auto sectors = collector.sectors();
+    assertThat(sectors.size()).isEqualTo(1);
+    assert(sectors[0] == first);
+}
+
+static void test_conflicts()
+{
+    /* The conflict is sticky, even when a later read agrees with one side. */
+
+    SectorCollector collapsed;
+    collapsed.add(makeSector(0, Sector::OK, Bytes{1}));
+    collapsed.add(makeSector(0, Sector::OK, Bytes{2}));
+    collapsed.add(makeSector(0, Sector::OK, Bytes{1}));
+    auto sectors = collapsed.sectors();
+    assertThat(sectors.size()).isEqualTo(1);
+    assertThat(sectors[0]->status).isEqualTo(Sector::CONFLICT);
+    assert(sectors[0]->data == Bytes{1});
+
+    SectorCollector uncollapsed(false);
+    uncollapsed.add(makeSector(0, Sector::OK, Bytes{1}));
+    uncollapsed.add(makeSector(0, Sector::OK, Bytes{1, 0}));
+    sectors = uncollapsed.sectors();
+    assertThat(sectors.size()).isEqualTo(2);
+    assertThat(sectors[0]->status).isEqualTo(Sector::CONFLICT);
+    assertThat(sectors[1]->status).isEqualTo(Sector::CONFLICT);
+    assert(sectors[1]->data == (Bytes{1, 0}));
+}
+
+static void test_corrected()
+{
+    /* Corrected sectors beat bad ones but lose to good ones. */
+
+    SectorCollector collector;
+    collector.add(makeSector(0, Sector::BAD_CHECKSUM, Bytes{1}));
+    collector.add(makeSector(0, Sector::CORRECTED, Bytes{2}));
+    collector.add(makeSector(0, Sector::BAD_CHECKSUM, Bytes{3}));
+    collector.add(makeSector(1, Sector::OK, Bytes{4}));
+    collector.add(makeSector(1, Sector::CORRECTED, Bytes{5}));
+
+    auto sectors = collector.sectors();
+    assertThat(sectors.size()).isEqualTo(2);
+    assertThat(sectors[0]->status).isEqualTo(Sector::CORRECTED);
+    assert(sectors[0]->data == Bytes{2});
+    assertThat(sectors[1]->status).isEqualTo(Sector::OK);
+    assert(sectors[1]->data == Bytes{4});
+}
+
+static void test_copied_sector()
+{
+    /* A sector copied and then changed, as encoders and image readers do,
+     * must not be mistaken for the original. */
+
+    auto left = std::make_shared<Sector>(LogicalLocation{1, 0, 0});
+    left->status = Sector::OK;
+    left->data = Bytes{1};
+    auto right = std::make_shared<Sector>(*left);
+    right->data = Bytes{2};
+    assertThat(right->dataDigest()).isEqualTo(fnv1a64(Bytes{2}));
+
+    SectorCollector collector;
+    collector.add(left);
+    collector.add(left);
+    assertThat(collector.sectors()[0]->status).isEqualTo(Sector::OK);
+    collector.add(right);
+    assertThat(collector.sectors()[0]->status).isEqualTo(Sector::CONFLICT);
+}
+
+int main(int argc, const char* argv[])
+{
+    test_prefers_good();
+    test_identical_reads();
+    test_conflicts();
+    test_corrected();
+    test_copied_sector();
+    return 0;
+}
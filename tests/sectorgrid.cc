@@ -0,0 +1,103 @@
+#include "lib/core/globals.h"
+#include "lib/config/config.h"
+#include "lib/data/image.h"
+#include "lib/data/layout.h"
+#include "lib/data/sector.h"
+#include "lib/data/sectorgrid.h"
+#include "tests.h"
+#include <assert.h>
+
+static void test_logical()
+{
+    DiskLayout diskLayout(10, 2, 8, 256);
+    SectorGrid grid(diskLayout, SectorGrid::LOGICAL);
+    assertThat(grid.rows()).isEqualTo(20);
+    assertThat(grid.columns()).isEqualTo(8);
+    assertThat(grid.cylinderForRow(5)).isEqualTo(2);
+    assertThat(grid.headForRow(5)).isEqualTo(1);
+    assertThat(grid.sectorForColumn(3)).isEqualTo(3);
+
+    /* Nothing has been read yet, but the block numbers are known. */
+
+    assert(!grid.at(5, 3).sector);
+    assertThat(grid.at(5, 3).blockId)
+        .isEqualTo(diskLayout.blockIdByLogicalSectorLocation.at({2, 1, 3}));
+
+    Image image;
+    auto sector = image.put(2, 1, 3);
+    sector->status = Sector::BAD_CHECKSUM;
+    assert(grid.update(&image));
+    assert(grid.at(5, 3).sector == sector);
+    assertThat(grid.at(5, 3).status).isEqualTo(Sector::BAD_CHECKSUM);
+    assert(!grid.at(5, 2).sector);
+
+    /* Updating from the same image changes nothing. */
+
+    assert(!grid.update(&image));
+
+    /* Rereading the sector replaces it, but only updating its own track
+     * picks that up. */
+
+    image.put(2, 1, 3)->status = Sector::OK;
+    assert(!grid.update(&image, {{2, 0}, {3, 1}}));
+    assertThat(grid.at(5, 3).status).isEqualTo(Sector::BAD_CHECKSUM);
+    assert(grid.update(&image, {{2, 1}}));
+    assertThat(grid.at(5, 3).status).isEqualTo(Sector::OK);
+
+    /* No image at all empties the grid. */
+
+    assert(grid.update(nullptr));
+    assert(!grid.at(5, 3).sector);
+    assertThat(grid.at(5, 3).status).isEqualTo(Sector::MISSING);
+}
+
+static void test_physical()
+{
+    globalConfig().clear();
+    globalConfig().readBaseConfig(R"M(
+		drive {
+			drive_type: DRIVETYPE_80TRACK
+		}
+
+		layout {
+			format_type: FORMATTYPE_40TRACK
+			tracks: 2
+			sides: 2
+			layoutdata {
+				sector_size: 256
+				physical {
+					start_sector: 1
+					count: 4
+				}
+			}
+		}
+	)M");
+
+    auto diskLayout = createDiskLayout();
+    SectorGrid grid(*diskLayout, SectorGrid::PHYSICAL);
+    assertThat(grid.rows()).isEqualTo(8);
+    assertThat(grid.columns()).isEqualTo(4);
+    assertThat(grid.sectorForColumn(0)).isEqualTo(1);
+
+    /* Each logical track is written to a group of physical tracks, so a
+     * sector shows up in each of them. */
+
+    Image image;
+    auto sector = image.put(1, 0, 2);
+    grid.update(&image);
+
+    std::vector<unsigned> rows;
+    for (unsigned row = 0; row < grid.rows(); row++)
+        if (grid.at(row, 1).sector == sector)
+            rows.push_back(row);
+    assert((rows == std::vector<unsigned>{4, 6}));
+    assertThat(grid.cylinderForRow(4)).isEqualTo(2);
+    assertThat(grid.cylinderForRow(6)).isEqualTo(3);
+}
+
+int main(int argc, const char* argv[])
+{
+    test_logical();
+    test_physical();
+    return 0;
+}
@@ -0,0 +1,125 @@
+#include "lib/core/globals.h"
+#include "lib/core/trace.h"
+#include "tests.h"
+#include <assert.h>
+#include <thread>
+
+static void test_disabled()
+{
+    Trace::enable(16);
+    Trace::disable();
+    {
+        TraceSpan span("ignored");
+        Trace::counter("ignored", 1);
+    }
+    assertThat(Trace::events().size()).isEqualTo(0);
+}
+
+static void test_spans_and_counters()
+{
+    Trace::enable(16);
+    {
+        TraceSpan outer("outer", {{"cylinder", 3}, {"head", 1}});
+        {
+            TraceSpan inner("inner");
+        }
+        Trace::counter("bytes", 42);
+    }
+    Trace::disable();
+
+    /* Spans are recorded when they finish. */
+
+    auto events = Trace::events();
+    assertThat(events.size()).isEqualTo(3);
+    assertThat(std::string(events[0].name)).isEqualTo("inner");
+    assertThat(std::string(events[1].name)).isEqualTo("bytes");
+    assertThat(std::string(events[2].name)).isEqualTo("outer");
+
+    const auto& outer = events[2];
+    const auto& inner = events[0];
+    assert(outer.type == Trace::Event::SPAN);
+    assert(outer.start <= inner.start);
+    assert((inner.start + inner.duration) <= (outer.start + outer.duration));
+    assertThat(outer.numArgs).isEqualTo(2);
+    assertThat(outer.args[0].value).isEqualTo(3);
+    assertThat(outer.args[1].value).isEqualTo(1);
+
+    const auto& counter = events[1];
+    assert(counter.type == Trace::Event::COUNTER);
+    assertThat(counter.args[0].value).isEqualTo(42);
+}
+
+static void test_ring_buffer()
+{
+    Trace::enable(4);
+    for (int i = 0; i < 10; i++)
+        Trace::counter("n", i);
+    Trace::disable();
+
+    /* Only the most recent events survive. */
+
+    auto events = Trace::events();
+    assertThat(events.size()).isEqualTo(4);
+    assertThat(Trace::dropped()).isEqualTo(6);
+    for (int i = 0; i < 4; i++)
+        assertThat(events[i].args[0].value).isEqualTo(6 + i);
+}
+
+static void test_threads()
+{
+    /* Many threads wrapping a tiny buffer at once; every surviving event
+     * must be one that was actually written. */
+
+    Trace::enable(8);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++)
+        threads.emplace_back(
+            []
+            {
+                for (int i = 0; i < 10000; i++)
+                    Trace::counter("n", i);
+            });
+    for (auto& thread : threads)
+        thread.join();
+    Trace::disable();
+
+    auto events = Trace::events();
+    assert(events.size() <= 8);
+    assertThat(events.size() + Trace::dropped()).isEqualTo(40000);
+    for (const auto& event : events)
+    {
+        assertThat(std::string(event.name)).isEqualTo("n");
+        assert((event.args[0].value >= 0) && (event.args[0].value < 10000));
+    }
+}
+
+static void test_chrome_format()
+{
+    Trace::enable(16);
+    {
+        TraceSpan span("a \"quoted\" name", {{"cylinder", 7}});
+    }
+    Trace::counter("bytes", 99);
+    Trace::disable();
+
+    std::stringstream ss;
+    Trace::writeChromeTrace(ss);
+    auto s = ss.str();
+    assert(s.starts_with("{\"traceEvents\":["));
+    assert(s.find("\"name\":\"a \\\"quoted\\\" name\",\"ph\":\"X\"") !=
+           std::string::npos);
+    assert(s.find("\"args\":{\"cylinder\":7}") != std::string::npos);
+    assert(s.find("\"name\":\"bytes\",\"ph\":\"C\"") != std::string::npos);
+    assert(s.find("\"args\":{\"value\":99}") != std::string::npos);
+    assert(s.find("\"dur\":") != std::string::npos);
+}
+
+int main(int argc, const char* argv[])
+{
+    test_disabled();
+    test_spans_and_counters();
+    test_ring_buffer();
+    test_threads();
+    test_chrome_format();
+    return 0;
+}
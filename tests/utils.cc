@@ -88,6 +88,30 @@ static void testMultimapToMap()
     AssertThat(output, Equals(wanted));
 }
 
+static void testParallelFor()
+{
+    std::vector<int> results(100);
+    parallelFor(results.size(),
+        4,
+        [&](unsigned i)
+        {
+            results[i] = i * 2;
+        });
+    for (unsigned i = 0; i < results.size(); i++)
+        AssertThat(results[i], Equals(i * 2));
+
+    /* The first failure comes back out once everything has stopped. */
+
+    AssertThrows(ErrorException,
+        parallelFor(100,
+            4,
+            [&](unsigned i)
+            {
+                if (i == 50)
+                    error("failed");
+            }));
+}
+
 int main(void)
 {
     testJoin();
@@ -98,5 +122,6 @@ int main(void)
     testUnhex();
     testUnbcd();
     testMultimapToMap();
+    testParallelFor();
     return 0;
 }
@@ -1,7 +1,17 @@
 #include "lib/core/globals.h"
 #include "lib/config/config.h"
 #include "lib/vfs/vfs.h"
+#include "lib/vfs/batch.h"
+#include "lib/vfs/exporter.h"
+#include "lib/vfs/sectorinterface.h"
+#include "lib/data/image.h"
+#include "lib/data/layout.h"
+#include "lib/data/sector.h"
+#include "lib/imagereader/imagereader.h"
+#include "lib/imagewriter/imagewriter.h"
+#include "lib/config/config.pb.h"
 #include "snowhouse/snowhouse.h"
+#include <filesystem>
 
 using namespace snowhouse;
 
@@ -25,9 +35,226 @@ static void testPathParenthood()
         Equals(std::vector<std::string>{"one", "two"}));
 }
 
+static void testBatchParsing()
+{
+    auto ops = parseBatchManifest(
+        "# comment\n"
+        "\n"
+        "put local.txt dir/REMOTE.TXT\n"
+        "get \"dir/WITH SPACES\"\n"
+        "  mv A B\n");
+    AssertThat(ops.size(), Equals(3));
+    AssertThat(ops[0].type, Equals(BatchOperation::PUT));
+    AssertThat(ops[0].local, Equals("local.txt"));
+    AssertThat(ops[0].path, Equals(Path("dir/REMOTE.TXT")));
+    AssertThat(ops[0].line, Equals(3));
+    AssertThat(ops[1].type, Equals(BatchOperation::GET));
+    AssertThat(ops[1].local, Equals("WITH SPACES"));
+    AssertThat(ops[2].type, Equals(BatchOperation::MOVE));
+    AssertThat(ops[2].newPath, Equals(Path("B")));
+
+    AssertThrows(FilesystemException, parseBatchManifest("frob A"));
+    AssertThrows(FilesystemException, parseBatchManifest("rm A B"));
+    AssertThrows(FilesystemException, parseBatchManifest("rm \"A"));
+}
+
+namespace
+{
+    /* Stores file N in logical sector N. */
+
+    class SectorPerFileFilesystem : public Filesystem
+    {
+    public:
+        using Filesystem::Filesystem;
+
+        std::vector<std::shared_ptr<Dirent>> list(const Path& path) override
+        {
+            std::vector<std::shared_ptr<Dirent>> dirents;
+            for (auto name : {"1", "2", "3"})
+            {
+                auto dirent = std::make_shared<Dirent>();
+                dirent->filename = name;
+                dirent->path = {name};
+                dirent->file_type = TYPE_FILE;
+                dirent->length = 256;
+                dirents.push_back(dirent);
+            }
+            return dirents;
+        }
+
+        Bytes getFile(const Path& path) override
+        {
+            return getLogicalSector(std::stoi(path.back()));
+        }
+
+        void putFile(const Path& path, const Bytes& data) override
+        {
+            putLogicalSector(std::stoi(path.back()), data.slice(0, 256));
+        }
+
+        void deleteFile(const Path& path) override
+        {
+            putLogicalSector(std::stoi(path.back()), Bytes(256));
+        }
+    };
+}
+
+static void testBatchCoalescing()
+{
+    auto diskLayout = std::make_shared<DiskLayout>(10, 1, 8, 256);
+    auto image = std::make_shared<Image>();
+    image->addMissingSectors(*diskLayout, true);
+    SectorPerFileFilesystem fs(
+        diskLayout, SectorInterface::createMemorySectorInterface(image));
+
+    /* Five operations, but they only touch two tracks. */
+
+    auto ops = parseBatchManifest(
+        "put /dev/null 1\n"
+        "put /dev/null 2\n"
+        "rm 3\n"
+        "put /dev/null 9\n"
+        "rm 15\n");
+    auto result = runBatch(fs, ops);
+    AssertThat(result.operations, Equals(5));
+    AssertThat(result.tracks, Equals(2));
+    AssertThat(fs.needsFlushing(), Equals(false));
+
+    /* A failure writes nothing. */
+
+    AssertThrows(FilesystemException,
+        runBatch(fs, parseBatchManifest("rm 1\nmkdir 2\n")));
+    AssertThat(fs.needsFlushing(), Equals(false));
+}
+
+static void testExport()
+{
+    auto diskLayout = std::make_shared<DiskLayout>(10, 1, 8, 256);
+    auto image = std::make_shared<Image>();
+    auto sector = image->put(0, 0, 1);
+    sector->status = Sector::OK;
+    sector->data = Bytes{1} * 256;
+    sector = image->put(0, 0, 2);
+    sector->status = Sector::BAD_CHECKSUM;
+    sector->data = Bytes{2} * 256;
+    SectorPerFileFilesystem fs(
+        diskLayout, SectorInterface::createMemorySectorInterface(image));
+
+    std::string directory = fmt::format("/tmp/vfs-test-{}", getpid());
+    auto files = exportFilesystem(
+        fs, Path(), *ExportSink::createDirectoryExportSink(directory));
+    AssertThat(files.size(), Equals(3));
+    AssertThat(files[0].status, Equals(FS_OK));
+    AssertThat(files[1].status, Equals(FS_OK_BUT_USED_BAD_SECTORS));
+    AssertThat(files[1].badSectors, Equals(1));
+    AssertThat(files[2].status, Equals(FS_BAD));
+    AssertThat(
+        Bytes::readFromFile(directory + "/1"), Equals(Bytes{1} * 256));
+    AssertThat(
+        Bytes::readFromFile(directory + "/2"), Equals(Bytes{2} * 256));
+    AssertThat(std::filesystem::exists(directory + "/3"), Equals(false));
+    std::filesystem::remove_all(directory);
+
+    /* Each file in a tar archive is a header followed by its data, and the
+     * end is marked by two empty blocks. */
+
+    std::string tarFilename = directory + ".tar";
+    exportFilesystem(fs, Path(), *ExportSink::createTarExportSink(tarFilename));
+    Bytes tar = Bytes::readFromFile(tarFilename);
+    AssertThat(tar.size(), Equals(2 * 512 * 2 + 1024));
+    AssertThat(tar.slice(0, 1), Equals(Bytes{'1'}));
+    AssertThat(tar.slice(257, 5), Equals(Bytes{'u', 's', 't', 'a', 'r'}));
+    AssertThat(tar.slice(512, 256), Equals(Bytes{1} * 256));
+    unlink(tarFilename.c_str());
+}
+
+/* Corrected sectors are only trusted if the decoder was told to accept
+ * them. */
+
+static void testExportCorrected()
+{
+    auto diskLayout = std::make_shared<DiskLayout>(10, 1, 8, 256);
+    auto image = std::make_shared<Image>();
+    auto sector = image->put(0, 0, 1);
+    sector->status = Sector::CORRECTED;
+    sector->data = Bytes{1} * 256;
+    SectorPerFileFilesystem fs(
+        diskLayout, SectorInterface::createMemorySectorInterface(image));
+
+    std::string tarFilename =
+        fmt::format("/tmp/vfs-test-corrected-{}.tar", getpid());
+    auto files = exportFilesystem(
+        fs, Path(), *ExportSink::createTarExportSink(tarFilename));
+    AssertThat(files[0].status, Equals(FS_OK_BUT_USED_BAD_SECTORS));
+
+    auto* decoder = globalConfig().overrides()->mutable_decoder();
+    decoder->mutable_crc_correction()->set_accept(true);
+    files = exportFilesystem(
+        fs, Path(), *ExportSink::createTarExportSink(tarFilename));
+    AssertThat(files[0].status, Equals(FS_OK));
+    decoder->clear_crc_correction();
+    unlink(tarFilename.c_str());
+}
+
+static void testImageWriteBack()
+{
+    std::string filename = fmt::format("/tmp/vfs-test-{}.d64", getpid());
+    ImageReaderProto readerConfig;
+    readerConfig.set_type(IMAGETYPE_D64);
+    readerConfig.set_filename(filename);
+    ImageWriterProto writerConfig;
+    writerConfig.set_type(IMAGETYPE_D64);
+    writerConfig.set_filename(filename);
+
+    /* Make an image with just the first track on it. */
+
+    {
+        Image image;
+        for (int i = 0; i < 21; i++)
+            image.put(0, 0, i)->data = Bytes{(uint8_t)i} * 256;
+        ImageWriter::create(writerConfig)->writeImage(image);
+    }
+
+    std::shared_ptr<ImageReader> reader = ImageReader::create(readerConfig);
+    std::shared_ptr<ImageWriter> writer = ImageWriter::create(writerConfig);
+    auto sectors =
+        SectorInterface::createImageSectorInterface(nullptr, reader, writer);
+
+    /* Only the changed sector gets written back; anything else in the file
+     * is left alone. */
+
+    Bytes data = Bytes::readFromFile(filename);
+    data.writer().seek(2 * 256).append(Bytes{0xff} * 256);
+    data.writeToFile(filename);
+
+    sectors->put(0, 0, 1)->data = Bytes{0xaa} * 256;
+    AssertThat(sectors->getChangedTracks().size(), Equals(1));
+    sectors->flushChanges();
+
+    data = Bytes::readFromFile(filename);
+    AssertThat(data.size(), Equals(21 * 256));
+    AssertThat(data.slice(1 * 256, 256), Equals(Bytes{0xaa} * 256));
+    AssertThat(data.slice(2 * 256, 256), Equals(Bytes{0xff} * 256));
+    AssertThat(data.slice(3 * 256, 256), Equals(Bytes{3} * 256));
+
+    /* Discarding changes puts back what was there before. */
+
+    sectors->put(0, 0, 3)->data = Bytes{0x55} * 256;
+    sectors->discardChanges();
+    AssertThat(sectors->needsFlushing(), Equals(false));
+    AssertThat(sectors->get(0, 0, 3)->data, Equals(Bytes{3} * 256));
+
+    unlink(filename.c_str());
+}
+
 int main(void)
 {
     testPathParsing();
     testPathParenthood();
+    testBatchParsing();
+    testBatchCoalescing();
+    testImageWriteBack();
+    testExport();
+    testExportCorrected();
     return 0;
 }
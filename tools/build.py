@@ -39,6 +39,25 @@ cxxprogram(
     + emu,
 )
 
+# Not part of +all; build it explicitly.
+cxxprogram(
+    name="fluxbenchmark",
+    srcs=["./fluxbenchmark.cc"],
+    deps=[
+        "dep+fmt_lib",
+        "+protobuf_lib",
+        "+protocol",
+        "+z_lib",
+        "lib/config",
+        "lib/core",
+        "lib/data",
+        "lib/fluxsource+proto_lib",
+        "lib/algorithms",
+        "src/formats",
+    ]
+    + emu,
+)
+
 cxxprogram(
     name="upgrade-flux-file",
     srcs=["./upgrade-flux-file.cc"],
@@ -0,0 +1,142 @@
+#include "lib/core/globals.h"
+#include "lib/core/utils.h"
+#include "lib/data/fluxmap.h"
+#include "lib/data/fluxmapreader.h"
+#include "lib/data/fluxscan.h"
+#include "lib/decoders/fluxdecoder.h"
+#include "lib/decoders/decoders.pb.h"
+#include "protocol.h"
+#include "fmt/format.h"
+
+/* Times the inner loops of flux decoding on synthetic captures. The numbers
+ * only mean anything on a quiet machine, so this isn't part of the test suite
+ * (which checks that the fast paths give the right answers), and it isn't
+ * built by default: use `make tools+fluxbenchmark`. */
+
+static constexpr nanoseconds_t CLOCK = 2000.0;
+static constexpr int ITERATIONS = 10;
+
+/* MFM-like flux at a 2us clock with some jitter and slow drift, and an index
+ * mark every 200ms. */
+
+static std::unique_ptr<Fluxmap> makeCapture(int intervals)
+{
+    auto fluxmap = std::make_unique<Fluxmap>();
+    uint32_t seed = 1;
+    nanoseconds_t nextIndex = 200e6;
+    for (int i = 0; i < intervals; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        int cells = 2 + ((seed >> 16) % 3);
+        int jitter = (int)((seed >> 8) % 7) - 3;
+        double drift = 1.0 + 0.02 * sin(i / 5000.0);
+
+        fluxmap->appendInterval(cells * CLOCK * drift / NS_PER_TICK + jitter);
+        fluxmap->appendPulse();
+        if (fluxmap->duration() >= nextIndex)
+        {
+            fluxmap->appendIndex();
+            nextIndex += 200e6;
+        }
+    }
+    return fluxmap;
+}
+
+/* Runs f ITERATIONS times and returns the throughput in MB/s of bytecode. */
+
+template <typename F>
+static double megabytesPerSecond(const Fluxmap& fluxmap, F&& f)
+{
+    double start = getCurrentTime();
+    for (int i = 0; i < ITERATIONS; i++)
+        f();
+    double elapsed = getCurrentTime() - start;
+    return (ITERATIONS * fluxmap.bytes() / 1e6) / elapsed;
+}
+
+static void benchmarkPll(const Fluxmap& fluxmap)
+{
+    auto time = [&](bool fixedPoint)
+    {
+        DecoderProto config;
+        config.set_fixed_point_pll(fixedPoint);
+        return megabytesPerSecond(fluxmap,
+            [&]
+            {
+                FluxmapReader fmr(fluxmap, config);
+                FluxDecoder decoder(&fmr, CLOCK, config);
+                decoder.readBits();
+            });
+    };
+
+    double floating = time(false);
+    double fixed = time(true);
+    fmt::print("PLL: floating point {:.0f} MB/s, fixed point {:.0f} MB/s\n",
+        floating,
+        fixed);
+}
+
+static void benchmarkScan(const Fluxmap& fluxmap)
+{
+    const uint8_t* begin = fluxmap.ptr();
+    const uint8_t* end = begin + fluxmap.bytes();
+
+    for (uint8_t event : {F_BIT_PULSE, F_BIT_INDEX})
+    {
+        auto time = [&](auto scan)
+        {
+            return megabytesPerSecond(fluxmap,
+                [&]
+                {
+                    unsigned ticks = 0;
+                    const uint8_t* ptr = begin;
+                    while (ptr != end)
+                    {
+                        ptr = scan(ptr, end, event, true, ticks);
+                        if (ptr != end)
+                            ptr++;
+                    }
+                });
+        };
+
+        double fast = time(scanFlux);
+        double slow = time(scanFluxScalar);
+        fmt::print("scan for {}: {} {:.0f} MB/s, bytewise {:.0f} MB/s\n",
+            (event == F_BIT_PULSE) ? "pulses" : "index marks",
+            scanFluxImplementation(),
+            fast,
+            slow);
+    }
+}
+
+static void benchmarkIntervals(const Fluxmap& fluxmap)
+{
+    DecoderProto config;
+    auto time = [&](size_t budget)
+    {
+        Fluxmap::setIntervalsBudget(budget);
+        FluxmapReader fmr(fluxmap, config);
+        return megabytesPerSecond(fluxmap,
+            [&]
+            {
+                fmr.rewind();
+                while (!fmr.eof())
+                    fmr.readIntervalWithThreshold(0);
+            });
+    };
+
+    double slow = time(0);
+    double fast = time(SIZE_MAX);
+    fmt::print("readInterval: bytecode {:.0f} MB/s, intervals {:.0f} MB/s\n",
+        slow,
+        fast);
+}
+
+int main(int argc, const char* argv[])
+{
+    auto fluxmap = makeCapture(1000000);
+    benchmarkPll(*fluxmap);
+    benchmarkScan(*fluxmap);
+    benchmarkIntervals(*fluxmap);
+    return 0;
+}